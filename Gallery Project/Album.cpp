@@ -1,17 +1,16 @@
 ﻿#include "Album.h"
 #include "ItemNotFoundException.h"
-#include <iomanip>
-#include <sstream>
+#include "TimeFormat.h"
 
 
 Album::Album(int ownerId, const std::string& name) :
-	m_ownerId(ownerId), m_name(name), m_pictures{}
+	m_ownerId(ownerId), m_name(name)
 {
 	setCreationDateNow();
 }
 
-Album::Album(int ownerId, const std::string & name, const std::string & creationTime) :
-	m_ownerId(ownerId), m_name(name), m_creationDate(creationTime), m_pictures{}
+Album::Album(int ownerId, const std::string & name, int64_t creationTime) :
+	m_ownerId(ownerId), m_name(name), m_creationTime(creationTime)
 {
 	// Left empty
 }
@@ -49,99 +48,132 @@ void Album::setId(int id)
 
 std::string Album::getCreationDate() const
 {
-	return m_creationDate;
+	return formatTime(m_creationTime);
 }
 
 void Album::setCreationDate(const std::string& creationTime)
 {
-	m_creationDate = creationTime;
+	parseTime(creationTime, m_creationTime);
 }
 
 void Album::setCreationDateNow()
 {
-	time_t now = time(nullptr);
-	std::stringstream oss;
-	oss << std::put_time(localtime(&now), "%d/%m/%Y %H:%M:%S");
-	m_creationDate = oss.str();
+	m_creationTime = currentTime();
 }
 
+int64_t Album::getCreationTime() const
+{
+	return m_creationTime;
+}
 
-Picture Album::getPicture(const std::string& pictureName) const
+void Album::setCreationTime(int64_t creationTime)
 {
-	for (auto& picture: m_pictures) {
-		if (pictureName == picture.getName()) {
-			return picture;
-		}
+	m_creationTime = creationTime;
+}
+
+
+const Picture& Album::getPicture(const std::string& pictureName) const
+{
+	const Picture* picture = m_pictures->find(pictureName);
+	if (nullptr == picture) {
+		throw ItemNotFoundException("Picture", pictureName);
 	}
-	throw ItemNotFoundException("Picture", pictureName);
+	return *picture;
+}
+
+const Picture& Album::getPicture(int pictureId) const
+{
+	const Picture* picture = m_pictures->find(pictureId);
+	if (nullptr == picture) {
+		throw ItemNotFoundException("Picture", pictureId);
+	}
+	return *picture;
 }
 
 
-std::list<Picture> Album::getPictures() const
+const std::vector<Picture>& Album::getPictures() const
 {
-	return m_pictures;
+	return m_pictures->getPictures();
 }
 
 void Album::untagUserInAlbum(int userId)
 {
-	for(auto& picture: m_pictures) {
-		picture.untagUser(userId);
-	}
+	editPictures().untagUser(userId);
 }
 
 void Album::tagUserInAlbum(int userId)
 {
-	for (auto& picture : m_pictures) {
-		picture.tagUser(userId);
-	}
+	editPictures().tagUser(userId);
 }
 
 void Album::untagUserInPicture(int userId, const std::string & pictureName)
 {
-	for (auto& picture : m_pictures) {
-		if (picture.getName() == pictureName) {
-			picture.untagUser(userId);
-		}
+	if (m_pictures->find(pictureName)) {
+		editPictures().find(pictureName)->untagUser(userId);
+	}
+}
+
+void Album::untagUserInPicture(int userId, int pictureId)
+{
+	if (m_pictures->find(pictureId)) {
+		editPictures().find(pictureId)->untagUser(userId);
 	}
 }
 
 void Album::tagUserInPicture(int userId, const std::string & pictureName)
 {
-	for (auto& picture : m_pictures) {
-		if (picture.getName() == pictureName) {
-			picture.tagUser(userId);
-		}
+	if (m_pictures->find(pictureName)) {
+		editPictures().find(pictureName)->tagUser(userId);
 	}
 }
 
 void Album::addPicture(const Picture& picture)
 {
-	m_pictures.push_back(picture);
+	editPictures().add(picture);
+}
+
+void Album::addPicture(Picture&& picture)
+{
+	editPictures().add(std::move(picture));
+}
+
+/*
+This function makes room for pictures that are about to be added, so adding them allocates nothing
+input: how many pictures the album will hold
+output: none
+*/
+void Album::reservePictures(size_t count)
+{
+	editPictures().reserve(count);
 }
 
 
 void Album::removePicture(const std::string& pictureName)
 {
-	for (const auto& picture : m_pictures) {
-		if (pictureName == picture.getName()) {
-			m_pictures.remove(picture);
-			return;
-		}
+	if (!(m_pictures->find(pictureName) && editPictures().remove(pictureName))) {
+		throw ItemNotFoundException("Picture", pictureName);
 	}
-	
-	throw ItemNotFoundException("Picture", pictureName);
 }
 
 
 bool Album::doesPictureExists(const std::string& name) const
 {
-	//If it does not point to end, it means element exists in list
-	for (const auto& picture : m_pictures) {
-		if (name == picture.getName()) {
-			return true;
-		}
+	return m_pictures->find(name) != nullptr;
+}
+
+/*
+This function returns the pictures of this album for changing them.
+The pictures are shared between copies of the album (e.g. a gallery snapshot),
+so if anyone else holds them they are copied first and the others keep the old ones.
+input: none
+output: the pictures owned only by this album
+*/
+PictureStore& Album::editPictures()
+{
+	if (m_pictures.use_count() > 1) {
+		m_pictures = std::make_shared<PictureStore>(*m_pictures);
 	}
-	return false;
+	return *m_pictures;
 }
 
 bool Album::operator==(const Album& other) const
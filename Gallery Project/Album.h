@@ -1,7 +1,8 @@
 ﻿#pragma once
 #include "Picture.h"
-#include <list>
+#include "PictureStore.h"
 #include <memory>
+#include <vector>
 
 
 class Album
@@ -9,7 +10,7 @@ class Album
 public:
     Album() = default;
 	Album(int ownerId, const std::string& name);
-	Album(int ownerId, const std::string& name, const std::string& creationTime);
+	Album(int ownerId, const std::string& name, int64_t creationTime);
 
 	const std::string& getName() const;
 	void setName(const std::string& name);
@@ -23,27 +24,37 @@ public:
 	std::string getCreationDate() const;
 	void setCreationDate(const std::string& creationTime);
 	void setCreationDateNow();
+	int64_t getCreationTime() const;
+	void setCreationTime(int64_t creationTime);
 
 	bool doesPictureExists(const std::string& name) const;
 	void addPicture(const Picture& picture);
+	void addPicture(Picture&& picture);
+	void reservePictures(size_t count);
 	void removePicture(const std::string& pictureName);
 
-	Picture getPicture(const std::string& name) const;
-	std::list<Picture> getPictures() const;
+	const Picture& getPicture(const std::string& name) const;
+	const Picture& getPicture(int pictureId) const;
+	const std::vector<Picture>& getPictures() const;
 
 	void untagUserInAlbum(int userId);
 	void tagUserInAlbum(int userId);
 
 	void untagUserInPicture(int userId, const std::string& pictureName);
+	void untagUserInPicture(int userId, int pictureId);
 	void tagUserInPicture(int userId, const std::string& pictureName);
 	
 	bool operator==(const Album& other) const;
 	friend std::ostream& operator<<(std::ostream& strOut, const Album& album);
 
 private:
+	PictureStore& editPictures();
+
     int m_ownerId { 0 };
-	int m_id;
+	int m_id { 0 };
 	std::string m_name;
-	std::string m_creationDate;
-	std::list<Picture> m_pictures;
+	// seconds since the epoch, formatted only when shown
+	int64_t m_creationTime { 0 };
+	// shared between copies of the album until one of them changes its pictures
+	std::shared_ptr<PictureStore> m_pictures { std::make_shared<PictureStore>() };
 };
@@ -1,21 +1,36 @@
 ﻿#include "AlbumManager.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include <iostream>
 #include "Constants.h"
 #include "MyException.h"
 #include "AlbumNotOpenException.h"
+#include "TimeFormat.h"
+#include "PictureScanner.h"
+#include "ThreadPool.h"
+#include "ContentHash.h"
+#include "PerceptualHash.h"
 
 
 AlbumManager::AlbumManager(IDataAccess& dataAccess) :
-    m_dataAccess(dataAccess), m_nextPictureId(100), m_nextUserId(200)
+    m_dataAccess(dataAccess), m_nextPictureId(100), m_nextUserId(200), m_thumbnails(THUMBNAILS_FOLDER)
 {
-	// Left empty
-	m_dataAccess.open();
+	if (!m_dataAccess.open()) {
+		throw MyException("Error: Failed to open the gallery\n");
+	}
+
+	// the gallery that was loaded keeps its ids, new users and pictures are given ids after them
+	m_nextPictureId = std::max(m_nextPictureId, m_dataAccess.getLastPictureId());
+	m_nextUserId = std::max(m_nextUserId, m_dataAccess.getLastUserId());
 }
 
 void AlbumManager::executeCommand(CommandType command) {
 	try {
 		AlbumManager::handler_func_t handler = m_commands.at(command);
 		(this->*handler)();
+		// every command is committed as one batch of changes
+		m_dataAccess.flush();
 	} catch (const std::out_of_range&) {
 			throw MyException("Error: Invalid command[" + std::to_string(command) + "]\n");
 	}
@@ -76,7 +91,7 @@ void AlbumManager::openAlbum()
 		throw MyException("Error: Failed to open album, since there is no album with name:"+name +".\n");
 	}
 
-	m_openAlbum = m_dataAccess.openAlbum(name);
+	m_openAlbum = m_dataAccess.openAlbum(name, userId);
     m_currentAlbumName = name;
 	// success
 	std::cout << "Album [" << name << "] opened successfully." << std::endl;
@@ -88,6 +103,7 @@ void AlbumManager::closeAlbum()
 
 	std::cout << "Album [" << m_openAlbum.getName() << "] closed successfully." << std::endl;
 	m_dataAccess.closeAlbum(m_openAlbum);
+	m_openAlbum = Album();
 	m_currentAlbumName = "";
 }
 
@@ -139,6 +155,82 @@ void AlbumManager::listAlbumsOfUser()
 	}
 }
 
+/*
+This function imports a folder tree of pictures - the user gets an album for every folder that
+holds pictures, named by its path from the imported folder. The folders are listed in parallel,
+and the albums are created in one batch. Folders the user already has an album of are skipped.
+input: none
+output: none
+*/
+void AlbumManager::importAlbums()
+{
+	std::string userIdStr = getInputFromConsole("Enter user id: ");
+	int userId = std::stoi(userIdStr);
+	if ( !m_dataAccess.doesUserExists(userId) ) {
+		throw MyException("Error: Can't import albums since there is no user with id [" + userIdStr + "]\n");
+	}
+
+	std::string folderPath = getInputFromConsole("Enter folder path: ");
+	std::error_code error;
+	if ( !std::filesystem::is_directory(folderPath, error) ) {
+		throw MyException("Error: There is no folder <" + folderPath + ">.\n");
+	}
+
+	auto startTime = std::chrono::steady_clock::now();
+	ThreadPool pool;
+	std::vector<PictureScanner::Folder> folders = PictureScanner::scan(folderPath, pool);
+	auto scanEndTime = std::chrono::steady_clock::now();
+
+	size_t skippedCount = 0;
+	folders.erase(std::remove_if(folders.begin(), folders.end(), [&](const PictureScanner::Folder& folder) {
+		if (folder.pictures.empty()) {
+			return true;
+		}
+		if (m_dataAccess.doesAlbumExists(folder.name, userId)) {
+			++skippedCount;
+			return true;
+		}
+		return false;
+	}), folders.end());
+
+	// only the pictures that are imported are read
+	size_t hashedCount = PictureScanner::hashPictures(folders, pool);
+	auto hashEndTime = std::chrono::steady_clock::now();
+
+	std::list<Album> albums;
+	size_t picturesCount = 0;
+	for (PictureScanner::Folder& folder : folders) {
+		albums.emplace_back(userId, folder.name);
+		albums.back().reservePictures(folder.pictures.size());
+		for (Picture& picture : folder.pictures) {
+			// the same ids as the pictures that are added one by one
+			picture.setId(++m_nextPictureId);
+			++picturesCount;
+			albums.back().addPicture(std::move(picture));
+		}
+	}
+
+	m_dataAccess.importAlbums(albums);
+
+	std::chrono::duration<double> scanTime = scanEndTime - startTime;
+	std::chrono::duration<double> hashTime = hashEndTime - scanEndTime;
+	std::chrono::duration<double> importTime = std::chrono::steady_clock::now() - startTime;
+	std::cout << "Imported " << picturesCount << " pictures into " << albums.size() << " albums in " << std::fixed << std::setprecision(3) << importTime.count() << " sec";
+	if (importTime.count() > 0) {
+		std::cout << " (" << static_cast<long long>(picturesCount / importTime.count()) << " files/sec)";
+	}
+	std::cout << ", the folders were listed and the pictures were hashed by " << pool.size() << " threads in "
+		<< scanTime.count() << " + " << hashTime.count() << " sec." << std::defaultfloat << std::endl;
+
+	if (hashedCount < picturesCount) {
+		std::cout << "Failed to read " << picturesCount - hashedCount << " pictures, they won't be found as duplicates." << std::endl;
+	}
+
+	if (skippedCount > 0) {
+		std::cout << "Skipped " << skippedCount << " folders, the user already has their albums." << std::endl;
+	}
+}
+
 
 // ******************* Picture ******************* 
 void AlbumManager::addPictureToAlbum()
@@ -154,7 +246,25 @@ void AlbumManager::addPictureToAlbum()
 	std::string picPath = getInputFromConsole("Enter picture path: ");
 	picture.setPath(picPath);
 
-	m_dataAccess.addPictureToAlbumByName(m_openAlbum.getName(), picture);
+	// a path that isn't there (yet) is allowed, the picture just has no size and isn't found as a duplicate
+	ImageHeader header;
+	ImageHeader::read(picPath, header);
+	picture.setImageHeader(header);
+
+	ExifMetadata metadata;
+	if (ImageFormat::JPEG == header.format && ExifMetadata::read(picPath, metadata)) {
+		picture.setMetadata(metadata);
+	}
+
+	uint64_t contentHash = 0, perceptualHash = 0;
+	if (ContentHash::hashFile(picPath, contentHash)) {
+		picture.setContentHash(contentHash);
+	}
+	if (PerceptualHash::hashFile(picPath, perceptualHash)) {
+		picture.setPerceptualHash(perceptualHash);
+	}
+
+	m_dataAccess.addPictureToAlbumByName(m_openAlbum.getName(), m_openAlbum.getOwnerId(), picture);
 
 	std::cout << "Picture [" << picture.getId() << "] successfully added to Album [" << m_openAlbum.getName() << "]." << std::endl;
 }
@@ -168,8 +278,7 @@ void AlbumManager::removePictureFromAlbum()
 		throw MyException("Error: There is no picture with name <" + picName + ">.\n");
 	}
 	
-	auto picture = m_openAlbum.getPicture(picName);
-	m_dataAccess.removePictureFromAlbumByName(m_openAlbum.getName(), picture.getName());
+	m_dataAccess.removePictureFromAlbumByName(m_openAlbum.getName(), m_openAlbum.getOwnerId(), picName);
 	std::cout << "Picture <" << picName << "> successfully removed from Album [" << m_openAlbum.getName() << "]." << std::endl;
 }
 
@@ -180,11 +289,21 @@ void AlbumManager::listPicturesInAlbum()
 	std::cout << "List of pictures in Album [" << m_openAlbum.getName() 
 			  << "] of user@" << m_openAlbum.getOwnerId() <<":" << std::endl;
 	
-	const std::list<Picture>& albumPictures = m_openAlbum.getPictures();
+	const std::vector<Picture>& albumPictures = m_openAlbum.getPictures();
 	for (auto iter = albumPictures.begin(); iter != albumPictures.end(); ++iter) {
 		std::cout << "   + Picture [" << iter->getId() << "] - " << iter->getName() << 
 			"\tLocation: [" << iter->getPath() << "]\tCreation Date: [" <<
-				iter->getCreationDate() << "]\tTags: [" << iter->getTagsCount() << "]" << std::endl;
+				iter->getCreationDate() << "]\tTags: [" << iter->getTagsCount() << "]";
+		if (iter->getFormat() != ImageFormat::UNKNOWN) {
+			std::cout << "\tSize: [" << iter->getWidth() << "x" << iter->getHeight() << " " << ImageHeader::formatName(iter->getFormat()) << "]";
+		}
+		if (iter->getMetadata().captureTime != 0) {
+			std::cout << "\tTaken: [" << formatTime(iter->getMetadata().captureTime) << "]";
+		}
+		if (m_thumbnails.hasThumbnail(*iter)) {
+			std::cout << "\tThumbnail: [" << m_thumbnails.getThumbnailPath(iter->getContentHash()) << "]";
+		}
+		std::cout << std::endl;
 	}
 	std::cout << std::endl;
 }
@@ -198,7 +317,7 @@ void AlbumManager::showPicture()
 		throw MyException("Error: There is no picture with name <" + picName + ">.\n");
 	}
 	
-	auto pic = m_openAlbum.getPicture(picName);
+	const Picture& pic = m_openAlbum.getPicture(picName);
 	if ( !fileExistsOnDisk(pic.getPath()) ) {
 		throw MyException("Error: Can't open <" + picName+ "> since it doesnt exist on disk.\n");
 	}
@@ -209,6 +328,45 @@ void AlbumManager::showPicture()
 	system(pic.getPath().c_str()); 
 }
 
+void AlbumManager::makeThumbnails()
+{
+	refreshOpenAlbum();
+
+	const std::vector<Picture>& albumPictures = m_openAlbum.getPictures();
+	size_t cachedCount = std::count_if(albumPictures.begin(), albumPictures.end(), [this](const Picture& picture) {
+		return m_thumbnails.hasThumbnail(picture);
+	});
+	size_t queuedCount = m_thumbnails.makeThumbnailsInBackground(albumPictures);
+
+	std::cout << "Making " << queuedCount << " thumbnails of Album [" << m_openAlbum.getName() << "] in the background, " <<
+		cachedCount << " of its " << albumPictures.size() << " pictures have one already (only BMP / PPM pictures get one)." << std::endl;
+	std::cout << "The thumbnails are saved in [" << THUMBNAILS_FOLDER << "], List pictures shows them when they're done." << std::endl;
+}
+
+void AlbumManager::listLargePictures()
+{
+	refreshOpenAlbum();
+
+	std::string pixelsStr = getInputFromConsole("Enter a size in pixels (the pictures wider or taller than it are listed): ");
+	int pixels = std::stoi(pixelsStr);
+	if (pixels < 0) {
+		throw MyException("Error: Invalid size <" + pixelsStr + ">.\n");
+	}
+
+	const std::list<Picture> pictures = m_dataAccess.getPicturesLargerThan(m_openAlbum.getName(), m_openAlbum.getOwnerId(), pixels);
+
+	if (pictures.empty()) {
+		throw MyException("There aren't any pictures larger than " + pixelsStr + " pixels in Album [" + m_openAlbum.getName() + "].");
+	}
+
+	std::cout << "Pictures larger than " << pixels << " pixels in Album [" << m_openAlbum.getName() << "]:" << std::endl;
+	for (const Picture& picture : pictures) {
+		std::cout << "   + Picture [" << picture.getId() << "] - " << picture.getName() << "\tSize: [" << picture.getWidth() << "x" <<
+			picture.getHeight() << " " << ImageHeader::formatName(picture.getFormat()) << ", " << picture.getFileSize() << " bytes]" << std::endl;
+	}
+	std::cout << pictures.size() << " pictures" << std::endl << std::endl;
+}
+
 void AlbumManager::tagUserInPicture()
 {
 	refreshOpenAlbum();
@@ -218,7 +376,7 @@ void AlbumManager::tagUserInPicture()
 		throw MyException("Error: There is no picture with name <" + picName + ">.\n");
 	}
 	
-	Picture pic = m_openAlbum.getPicture(picName);
+	const Picture& pic = m_openAlbum.getPicture(picName);
 	
 	std::string userIdStr = getInputFromConsole("Enter user id to tag: ");
 	int userId = std::stoi(userIdStr);
@@ -227,7 +385,7 @@ void AlbumManager::tagUserInPicture()
 	}
 	User user = m_dataAccess.getUser(userId);
 
-	m_dataAccess.tagUserInPicture(m_openAlbum.getName(), pic.getName(), user.getId());
+	m_dataAccess.tagUserInPicture(m_openAlbum.getName(), m_openAlbum.getOwnerId(), pic.getName(), user.getId());
 	std::cout << "User @" << userIdStr << " successfully tagged in picture <" << pic.getName() << "> in album [" << m_openAlbum.getName() << "]" << std::endl;
 }
 
@@ -240,7 +398,7 @@ void AlbumManager::untagUserInPicture()
 		throw MyException("Error: There is no picture with name <" + picName + ">.\n");
 	}
 
-	Picture pic = m_openAlbum.getPicture(picName);
+	const Picture& pic = m_openAlbum.getPicture(picName);
 
 	std::string userIdStr = getInputFromConsole("Enter user id: ");
 	int userId = stoi(userIdStr);
@@ -253,7 +411,7 @@ void AlbumManager::untagUserInPicture()
 		throw MyException("Error: The user was not tagged! \n");
 	}
 
-	m_dataAccess.untagUserInPicture(m_openAlbum.getName(), pic.getName(), user.getId());
+	m_dataAccess.untagUserInPicture(m_openAlbum.getName(), m_openAlbum.getOwnerId(), pic.getName(), user.getId());
 	std::cout << "User @" << userIdStr << " successfully untagged in picture <" << pic.getName() << "> in album [" << m_openAlbum.getName() << "]" << std::endl;
 
 }
@@ -266,9 +424,9 @@ void AlbumManager::listUserTags()
 	if ( !m_openAlbum.doesPictureExists(picName) ) {
 		throw MyException("Error: There is no picture with name <" + picName + ">.\n");
 	}
-	auto pic = m_openAlbum.getPicture(picName); 
+	const Picture& pic = m_openAlbum.getPicture(picName);
 
-	const std::set<int> users = pic.getUserTags();
+	const TagSet& users = pic.getUserTags();
 
 	if ( 0 == users.size() )  {
 		throw MyException("Error: There is no user tegged in <" + picName + ">.\n");
@@ -312,10 +470,10 @@ void AlbumManager::removeUser()
 
 	try
 	{
-		m_dataAccess.deleteUserTags(user);
-		m_dataAccess.deleteUsersAlbums(user);
-		m_dataAccess.deleteUser(user);
-		std::cout << "User @" << userId << " deleted successfully." << std::endl;
+		auto start = std::chrono::steady_clock::now();
+		m_dataAccess.deleteUserCascade(user);
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		std::cout << "User @" << userId << " deleted successfully (" << elapsed.count() << " ms)." << std::endl;
 	}
 	
 	catch (std::exception& e)
@@ -381,10 +539,181 @@ void AlbumManager::picturesTaggedUser()
 	std::cout << std::endl;
 }
 
+void AlbumManager::topTaggedUsers()
+{
+	const std::list<User> users = m_dataAccess.getTopTaggedUsers(TOP_TAGGED_COUNT);
+
+	if (users.empty()) {
+		throw MyException("There isn't any tagged user.");
+	}
+
+	std::cout << "Top " << TOP_TAGGED_COUNT << " tagged users:" << std::endl;
+	int place = 0;
+	for (const User& user : users) {
+		std::cout << std::setw(5) << ++place << ". " << user.getName() << " (@" << user.getId() << ") - "
+			<< m_dataAccess.countTagsOfUser(user) << " tags" << std::endl;
+	}
+	std::cout << std::endl;
+}
+
+void AlbumManager::topTaggedPictures()
+{
+	const std::list<Picture> pictures = m_dataAccess.getTopTaggedPictures(TOP_TAGGED_COUNT);
+
+	if (pictures.empty()) {
+		throw MyException("There isn't any tagged picture.");
+	}
+
+	std::cout << "Top " << TOP_TAGGED_COUNT << " tagged pictures:" << std::endl;
+	int place = 0;
+	for (const Picture& picture : pictures) {
+		std::cout << std::setw(5) << ++place << ". " << picture.getName() << " [" << picture.getId() << "] - "
+			<< picture.getTagsCount() << " tags" << std::endl;
+	}
+	std::cout << std::endl;
+}
+
+void AlbumManager::picturesCreatedBetween()
+{
+	int64_t from = 0, to = 0;
+
+	std::string fromStr = getInputFromConsole("Enter first date (dd/mm/yyyy [hh:mm:ss]): ");
+	if (!parseTime(fromStr, from)) {
+		throw MyException("Error: Invalid date <" + fromStr + ">.\n");
+	}
+
+	std::string toStr = getInputFromConsole("Enter last date (dd/mm/yyyy [hh:mm:ss]): ");
+	if (!parseTime(toStr, to)) {
+		throw MyException("Error: Invalid date <" + toStr + ">.\n");
+	}
+	// a last date without a time includes that whole day
+	if (toStr.find(':') == std::string::npos) {
+		to += 24 * 60 * 60 - 1;
+	}
+
+	const std::list<Picture> pictures = m_dataAccess.getPicturesCreatedBetween(from, to);
+
+	std::cout << "Pictures created between " << formatTime(from) << " and " << formatTime(to) << ":" << std::endl;
+	for (const Picture& picture : pictures) {
+		std::cout << "   + " << picture << std::endl;
+	}
+	std::cout << pictures.size() << " pictures" << std::endl << std::endl;
+}
+
+void AlbumManager::findDuplicates()
+{
+	const std::list<std::list<Picture>> groups = m_dataAccess.getDuplicatePictures();
+
+	if (groups.empty()) {
+		throw MyException("There aren't any duplicate pictures.");
+	}
+
+	size_t copiesCount = 0;
+	std::cout << "Pictures with the same content:" << std::endl;
+	for (const std::list<Picture>& group : groups) {
+		std::cout << "   Content " << ContentHash::toString(group.front().getContentHash()) << " - " << group.size() << " pictures:" << std::endl;
+		for (const Picture& picture : group) {
+			std::cout << "      + " << picture << std::endl;
+		}
+		copiesCount += group.size() - 1;
+	}
+	std::cout << groups.size() << " contents are duplicated, " << copiesCount << " pictures could be removed" << std::endl << std::endl;
+}
+
+void AlbumManager::findSimilarPictures()
+{
+	std::string distanceStr = getInputFromConsole("Enter how many bits of the picture hashes may differ (0-" + std::to_string(PerceptualHash::BITS) + ", 10 finds resized copies): ");
+	int maxDistance = std::stoi(distanceStr);
+	if (maxDistance < 0 || maxDistance > PerceptualHash::BITS) {
+		throw MyException("Error: Invalid distance <" + distanceStr + ">.\n");
+	}
+
+	const std::list<std::list<Picture>> groups = m_dataAccess.getSimilarPictures(maxDistance);
+
+	if (groups.empty()) {
+		throw MyException("There aren't any similar pictures.");
+	}
+
+	size_t picturesCount = 0;
+	std::cout << "Pictures that look alike (only BMP / PPM pictures are compared):" << std::endl;
+	int groupNumber = 0;
+	for (const std::list<Picture>& group : groups) {
+		std::cout << "   Group " << ++groupNumber << " - " << group.size() << " pictures:" << std::endl;
+		for (const Picture& picture : group) {
+			std::cout << "      + " << picture << std::endl;
+		}
+		picturesCount += group.size();
+	}
+	std::cout << picturesCount << " pictures in " << groups.size() << " groups" << std::endl << std::endl;
+}
+
+void AlbumManager::picturesCapturedBetween()
+{
+	int64_t from = 0, to = 0;
+
+	std::string fromStr = getInputFromConsole("Enter first date (dd/mm/yyyy [hh:mm:ss]): ");
+	if (!parseTime(fromStr, from)) {
+		throw MyException("Error: Invalid date <" + fromStr + ">.\n");
+	}
+
+	std::string toStr = getInputFromConsole("Enter last date (dd/mm/yyyy [hh:mm:ss]): ");
+	if (!parseTime(toStr, to)) {
+		throw MyException("Error: Invalid date <" + toStr + ">.\n");
+	}
+	// a last date without a time includes that whole day
+	if (toStr.find(':') == std::string::npos) {
+		to += 24 * 60 * 60 - 1;
+	}
+
+	const std::list<Picture> pictures = m_dataAccess.getPicturesCapturedBetween(from, to);
+
+	std::cout << "Pictures taken between " << formatTime(from) << " and " << formatTime(to) << " (by their EXIF metadata):" << std::endl;
+	printCapturedPictures(pictures);
+}
+
+void AlbumManager::picturesOfCamera()
+{
+	std::string cameraModel = getInputFromConsole("Enter camera model: ");
+
+	const std::list<Picture> pictures = m_dataAccess.getPicturesOfCamera(cameraModel);
+
+	std::cout << "Pictures taken with " << cameraModel << " (by their EXIF metadata):" << std::endl;
+	printCapturedPictures(pictures);
+}
+
+void AlbumManager::printCapturedPictures(const std::list<Picture>& pictures)
+{
+	for (const Picture& picture : pictures) {
+		const ExifMetadata& metadata = picture.getMetadata();
+		std::cout << "   + " << picture << std::endl << "\tTaken: [" <<
+			(metadata.captureTime != 0 ? formatTime(metadata.captureTime) : "unknown") << "]";
+		if (!metadata.cameraModel.empty()) {
+			std::cout << "\tCamera: [" << metadata.cameraModel << "]";
+		}
+		if (metadata.hasLocation) {
+			std::cout << "\tLocation: [" << std::fixed << std::setprecision(6) << metadata.latitude << ", " << metadata.longitude << "]" << std::defaultfloat;
+		}
+		std::cout << std::endl;
+	}
+	std::cout << pictures.size() << " pictures" << std::endl << std::endl;
+}
+
+
+// ******************* Snapshot *******************
+void AlbumManager::saveSnapshot()
+{
+	if (!m_dataAccess.saveSnapshot()) {
+		throw MyException("Error: Failed to save a snapshot of the gallery.\n");
+	}
+
+	std::cout << "Snapshot saved, the gallery will start up from it until it is changed." << std::endl;
+}
+
 
 // ******************* Help & exit ******************* 
 void AlbumManager::exit()
 {
+	m_dataAccess.close();
 	std::exit(EXIT_SUCCESS);
 }
 
@@ -415,7 +744,7 @@ void AlbumManager::refreshOpenAlbum() {
 	if (!isCurrentAlbumSet()) {
 		throw AlbumNotOpenException();
 	}
-    m_openAlbum = m_dataAccess.openAlbum(m_currentAlbumName);
+    m_openAlbum = m_dataAccess.openAlbum(m_currentAlbumName, m_openAlbum.getOwnerId());
 }
 
 bool AlbumManager::isCurrentAlbumSet() const
@@ -432,7 +761,8 @@ const std::vector<struct CommandGroup> AlbumManager::m_prompts  = {
 			{ CLOSE_ALBUM         , "Close album" },
 			{ DELETE_ALBUM        , "Delete album" },
 			{ LIST_ALBUMS         , "List albums" },
-			{ LIST_ALBUMS_OF_USER , "List albums of user" }
+			{ LIST_ALBUMS_OF_USER , "List albums of user" },
+			{ IMPORT_ALBUMS       , "Import albums from a folder tree" }
 		}
 	},
 	{
@@ -441,6 +771,8 @@ const std::vector<struct CommandGroup> AlbumManager::m_prompts  = {
 			{ ADD_PICTURE    , "Add picture." },
 			{ REMOVE_PICTURE , "Remove picture." },
 			{ SHOW_PICTURE   , "Show picture." },
+			{ MAKE_THUMBNAILS , "Make thumbnails of the pictures (in the background)." },
+			{ LARGE_PICTURES , "List pictures larger than a size." },
 			{ LIST_PICTURES  , "List pictures." },
 			{ TAG_USER		 , "Tag user." },
 			{ UNTAG_USER	 , "Untag user." },
@@ -462,11 +794,19 @@ const std::vector<struct CommandGroup> AlbumManager::m_prompts  = {
 			{ TOP_TAGGED_USER      , "Top tagged user." },
 			{ TOP_TAGGED_PICTURE   , "Top tagged picture." },
 			{ PICTURES_TAGGED_USER , "Pictures tagged user." },
+			{ TOP_TAGGED_USERS     , "Top 10 tagged users." },
+			{ TOP_TAGGED_PICTURES  , "Top 10 tagged pictures." },
+			{ PICTURES_CREATED_BETWEEN , "Pictures created between two dates." },
+			{ FIND_DUPLICATES , "Find duplicate pictures (same content)." },
+			{ SIMILAR_PICTURES , "Find similar pictures (look alike)." },
+			{ PICTURES_CAPTURED_BETWEEN , "Pictures taken between two dates." },
+			{ PICTURES_OF_CAMERA , "Pictures taken with a camera." },
 		}
 	},
 	{
 		"Supported Operations:",
 		{
+			{ SAVE_SNAPSHOT , "Save snapshot (fast startup)." },
 			{ HELP , "Help (clean screen)" },
 			{ EXIT , "Exit." },
 		}
@@ -480,10 +820,13 @@ const std::map<CommandType, AlbumManager::handler_func_t> AlbumManager::m_comman
 	{ DELETE_ALBUM, &AlbumManager::deleteAlbum },
 	{ LIST_ALBUMS, &AlbumManager::listAlbums },
 	{ LIST_ALBUMS_OF_USER, &AlbumManager::listAlbumsOfUser },
+	{ IMPORT_ALBUMS, &AlbumManager::importAlbums },
 	{ ADD_PICTURE, &AlbumManager::addPictureToAlbum },
 	{ REMOVE_PICTURE, &AlbumManager::removePictureFromAlbum },
 	{ LIST_PICTURES, &AlbumManager::listPicturesInAlbum },
 	{ SHOW_PICTURE, &AlbumManager::showPicture },
+	{ MAKE_THUMBNAILS, &AlbumManager::makeThumbnails },
+	{ LARGE_PICTURES, &AlbumManager::listLargePictures },
 	{ TAG_USER, &AlbumManager::tagUserInPicture, },
 	{ UNTAG_USER, &AlbumManager::untagUserInPicture },
 	{ LIST_TAGS, &AlbumManager::listUserTags },
@@ -494,6 +837,14 @@ const std::map<CommandType, AlbumManager::handler_func_t> AlbumManager::m_comman
 	{ TOP_TAGGED_USER, &AlbumManager::topTaggedUser },
 	{ TOP_TAGGED_PICTURE, &AlbumManager::topTaggedPicture },
 	{ PICTURES_TAGGED_USER, &AlbumManager::picturesTaggedUser },
+	{ TOP_TAGGED_USERS, &AlbumManager::topTaggedUsers },
+	{ TOP_TAGGED_PICTURES, &AlbumManager::topTaggedPictures },
+	{ PICTURES_CREATED_BETWEEN, &AlbumManager::picturesCreatedBetween },
+	{ FIND_DUPLICATES, &AlbumManager::findDuplicates },
+	{ SIMILAR_PICTURES, &AlbumManager::findSimilarPictures },
+	{ PICTURES_CAPTURED_BETWEEN, &AlbumManager::picturesCapturedBetween },
+	{ PICTURES_OF_CAMERA, &AlbumManager::picturesOfCamera },
+	{ SAVE_SNAPSHOT, &AlbumManager::saveSnapshot },
 	{ HELP, &AlbumManager::help },
 	{ EXIT, &AlbumManager::exit }
 };
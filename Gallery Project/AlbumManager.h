@@ -3,6 +3,7 @@
 #include "Constants.h"
 #include "MemoryAccess.h"
 #include "Album.h"
+#include "ThumbnailCache.h"
 
 
 class AlbumManager
@@ -21,6 +22,7 @@ private:
     std::string m_currentAlbumName{};
 	IDataAccess& m_dataAccess;
 	Album m_openAlbum;
+	ThumbnailCache m_thumbnails;
 
 	void help();
 	// albums management
@@ -30,12 +32,15 @@ private:
 	void deleteAlbum();
 	void listAlbums();
 	void listAlbumsOfUser();
+	void importAlbums();
 
 	// Picture management
 	void addPictureToAlbum();
 	void removePictureFromAlbum();
 	void listPicturesInAlbum();
 	void showPicture();
+	void makeThumbnails();
+	void listLargePictures();
 
 	// tags related
 	void tagUserInPicture();
@@ -51,6 +56,15 @@ private:
 	void topTaggedUser();
 	void topTaggedPicture();
 	void picturesTaggedUser();
+	void topTaggedUsers();
+	void topTaggedPictures();
+	void picturesCreatedBetween();
+	void findDuplicates();
+	void findSimilarPictures();
+	void picturesCapturedBetween();
+	void picturesOfCamera();
+	void printCapturedPictures(const std::list<Picture>& pictures);
+	void saveSnapshot();
 	void exit();
 
 	std::string getInputFromConsole(const std::string& message);
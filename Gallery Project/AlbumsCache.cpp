@@ -0,0 +1,118 @@
+#include <algorithm>
+#include "AlbumsCache.h"
+
+
+AlbumsCache::AlbumsCache(size_t capacity) :
+	m_capacity(std::max<size_t>(capacity, 1))
+{
+	// Left empty
+}
+
+size_t AlbumsCache::getCapacity() const
+{
+	return m_capacity;
+}
+
+/*
+This function sets how many albums the cache holds (at least one), evicting albums if needed
+input: the capacity
+output: none
+*/
+void AlbumsCache::setCapacity(size_t capacity)
+{
+	m_capacity = std::max<size_t>(capacity, 1);
+	evict(m_capacity);
+}
+
+size_t AlbumsCache::size() const
+{
+	return m_albums.size();
+}
+
+/*
+This function looks for an album in the cache, a found album becomes the most recently used one
+input: the album id
+output: the cached album, nullptr if it is not in the cache
+*/
+Album* AlbumsCache::find(int albumId)
+{
+	auto album = m_albumsById.find(albumId);
+	if (album == m_albumsById.end()) {
+		++m_misses;
+		return nullptr;
+	}
+
+	++m_hits;
+	m_albums.splice(m_albums.begin(), m_albums, album->second);
+	return &m_albums.front();
+}
+
+/*
+This function adds an album to the cache as the most recently used one.
+If the cache is full, the least recently used album is evicted first.
+input: the album
+output: the cached album
+*/
+Album& AlbumsCache::insert(Album album)
+{
+	erase(album.getId());
+	evict(m_capacity - 1);
+
+	m_albums.push_front(std::move(album));
+	m_albumsById[m_albums.front().getId()] = m_albums.begin();
+	return m_albums.front();
+}
+
+void AlbumsCache::erase(int albumId)
+{
+	auto album = m_albumsById.find(albumId);
+	if (album != m_albumsById.end()) {
+		m_albums.erase(album->second);
+		m_albumsById.erase(album);
+	}
+}
+
+void AlbumsCache::clear()
+{
+	m_albums.clear();
+	m_albumsById.clear();
+}
+
+/*
+This function returns the cached albums (most recently used first), without counting a hit
+input: none
+output: the cached albums
+*/
+std::list<Album>& AlbumsCache::getAlbums()
+{
+	return m_albums;
+}
+
+unsigned long long AlbumsCache::getHits() const
+{
+	return m_hits;
+}
+
+unsigned long long AlbumsCache::getMisses() const
+{
+	return m_misses;
+}
+
+unsigned long long AlbumsCache::getEvictions() const
+{
+	return m_evictions;
+}
+
+/*
+This function evicts the least recently used albums until the cache holds at most the given count
+input: the count of albums to keep
+output: none
+*/
+void AlbumsCache::evict(size_t capacity)
+{
+	while (m_albums.size() > capacity) {
+		m_albumsById.erase(m_albums.back().getId());
+		m_albums.pop_back();
+		++m_evictions;
+	}
+}
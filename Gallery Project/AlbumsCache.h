@@ -0,0 +1,40 @@
+#pragma once
+#include <list>
+#include <unordered_map>
+#include "Album.h"
+
+/*
+A bounded cache of whole albums (with their pictures and tags) by album id.
+When the cache is full, adding an album evicts the least recently used one.
+*/
+class AlbumsCache
+{
+public:
+	AlbumsCache(size_t capacity = 1);
+
+	size_t getCapacity() const;
+	void setCapacity(size_t capacity);
+	size_t size() const;
+
+	Album* find(int albumId);
+	Album& insert(Album album);
+	void erase(int albumId);
+	void clear();
+	std::list<Album>& getAlbums();
+
+	unsigned long long getHits() const;
+	unsigned long long getMisses() const;
+	unsigned long long getEvictions() const;
+
+private:
+	size_t m_capacity;
+	// most recently used first
+	std::list<Album> m_albums;
+	std::unordered_map<int, std::list<Album>::iterator> m_albumsById;
+
+	unsigned long long m_hits { 0 };
+	unsigned long long m_misses { 0 };
+	unsigned long long m_evictions { 0 };
+
+	void evict(size_t capacity);
+};
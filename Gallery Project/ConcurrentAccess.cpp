@@ -0,0 +1,348 @@
+#include "ConcurrentAccess.h"
+
+using ReadLock = std::shared_lock<WriterPreferringMutex>;
+using WriteLock = std::unique_lock<WriterPreferringMutex>;
+
+
+void WriterPreferringMutex::lock()
+{
+	m_writerMutex.lock();
+	m_mutex.lock();
+}
+
+void WriterPreferringMutex::unlock()
+{
+	m_mutex.unlock();
+	m_writerMutex.unlock();
+}
+
+void WriterPreferringMutex::lock_shared()
+{
+	// waits for the writer that holds the lock or waits for it
+	std::lock_guard<std::mutex> writerLock(m_writerMutex);
+	m_mutex.lock_shared();
+}
+
+void WriterPreferringMutex::unlock_shared()
+{
+	m_mutex.unlock_shared();
+}
+
+
+ConcurrentAccess::ConcurrentAccess(IDataAccess& dataAccess) :
+	m_dataAccess(dataAccess)
+{
+	// Left empty
+}
+
+/*
+This function returns a snapshot of the wrapped data access (the caller must hold the lock)
+input: none
+output: the snapshot
+*/
+std::shared_ptr<const GallerySnapshot> ConcurrentAccess::takeSnapshot()
+{
+	std::lock_guard<std::mutex> loadLock(m_loadMutex);
+	return m_dataAccess.getSnapshot();
+}
+
+
+// ******************* Album *******************
+std::list<Album> ConcurrentAccess::getAlbums()
+{
+	ReadLock lock(m_mutex);
+	std::shared_ptr<const GallerySnapshot> snapshot = takeSnapshot();
+
+	// album copies share their pictures with the snapshot
+	return std::list<Album>(snapshot->getAlbums().begin(), snapshot->getAlbums().end());
+}
+
+std::list<Album> ConcurrentAccess::getAlbumsOfUser(const User& user)
+{
+	ReadLock lock(m_mutex);
+	return m_dataAccess.getAlbumsOfUser(user);
+}
+
+void ConcurrentAccess::createAlbum(const Album& album)
+{
+	WriteLock lock(m_mutex);
+	m_dataAccess.createAlbum(album);
+}
+
+void ConcurrentAccess::importAlbums(const std::list<Album>& albums)
+{
+	WriteLock lock(m_mutex);
+	m_dataAccess.importAlbums(albums);
+}
+
+void ConcurrentAccess::deleteAlbum(const std::string& albumName, int userId)
+{
+	WriteLock lock(m_mutex);
+	m_dataAccess.deleteAlbum(albumName, userId);
+}
+
+bool ConcurrentAccess::doesAlbumExists(const std::string& albumName, int userId)
+{
+	ReadLock lock(m_mutex);
+	return m_dataAccess.doesAlbumExists(albumName, userId);
+}
+
+Album ConcurrentAccess::openAlbum(const std::string& albumName, int userId)
+{
+	ReadLock lock(m_mutex);
+	std::lock_guard<std::mutex> loadLock(m_loadMutex);
+	return m_dataAccess.openAlbum(albumName, userId);
+}
+
+Album ConcurrentAccess::getAlbumById(const int albumId)
+{
+	ReadLock lock(m_mutex);
+	std::lock_guard<std::mutex> loadLock(m_loadMutex);
+	return m_dataAccess.getAlbumById(albumId);
+}
+
+void ConcurrentAccess::closeAlbum(const Album& pAlbum)
+{
+	ReadLock lock(m_mutex);
+	m_dataAccess.closeAlbum(pAlbum);
+}
+
+void ConcurrentAccess::printAlbums()
+{
+	ReadLock lock(m_mutex);
+	m_dataAccess.printAlbums();
+}
+
+std::shared_ptr<const GallerySnapshot> ConcurrentAccess::getSnapshot()
+{
+	ReadLock lock(m_mutex);
+	return takeSnapshot();
+}
+
+
+// ******************* Picture *******************
+void ConcurrentAccess::addPictureToAlbumByName(const std::string& albumName, int ownerId, const Picture& picture)
+{
+	WriteLock lock(m_mutex);
+	m_dataAccess.addPictureToAlbumByName(albumName, ownerId, picture);
+}
+
+void ConcurrentAccess::removePictureFromAlbumByName(const std::string& albumName, int ownerId, const std::string& pictureName)
+{
+	WriteLock lock(m_mutex);
+	m_dataAccess.removePictureFromAlbumByName(albumName, ownerId, pictureName);
+}
+
+void ConcurrentAccess::tagUserInPicture(const std::string& albumName, int ownerId, const std::string& pictureName, int userId)
+{
+	WriteLock lock(m_mutex);
+	m_dataAccess.tagUserInPicture(albumName, ownerId, pictureName, userId);
+}
+
+void ConcurrentAccess::untagUserInPicture(const std::string& albumName, int ownerId, const std::string& pictureName, int userId)
+{
+	WriteLock lock(m_mutex);
+	m_dataAccess.untagUserInPicture(albumName, ownerId, pictureName, userId);
+}
+
+int ConcurrentAccess::getLastPictureId()
+{
+	ReadLock lock(m_mutex);
+	return m_dataAccess.getLastPictureId();
+}
+
+
+// ******************* User *******************
+void ConcurrentAccess::printUsers()
+{
+	ReadLock lock(m_mutex);
+	m_dataAccess.printUsers();
+}
+
+void ConcurrentAccess::createUser(User& user)
+{
+	WriteLock lock(m_mutex);
+	m_dataAccess.createUser(user);
+}
+
+void ConcurrentAccess::deleteUser(const User& user)
+{
+	WriteLock lock(m_mutex);
+	m_dataAccess.deleteUser(user);
+}
+
+bool ConcurrentAccess::doesUserExists(int userId)
+{
+	ReadLock lock(m_mutex);
+	return m_dataAccess.doesUserExists(userId);
+}
+
+int ConcurrentAccess::getLastUserId()
+{
+	ReadLock lock(m_mutex);
+	return m_dataAccess.getLastUserId();
+}
+
+User ConcurrentAccess::getUser(int userId)
+{
+	ReadLock lock(m_mutex);
+	return m_dataAccess.getUser(userId);
+}
+
+void ConcurrentAccess::deleteUsersAlbums(const User& user)
+{
+	WriteLock lock(m_mutex);
+	m_dataAccess.deleteUsersAlbums(user);
+}
+
+void ConcurrentAccess::deleteUserTags(const User& user)
+{
+	WriteLock lock(m_mutex);
+	m_dataAccess.deleteUserTags(user);
+}
+
+void ConcurrentAccess::deleteUserCascade(const User& user)
+{
+	WriteLock lock(m_mutex);
+	m_dataAccess.deleteUserCascade(user);
+}
+
+
+// ******************* User statistics *******************
+int ConcurrentAccess::countAlbumsOwnedOfUser(const User& user)
+{
+	ReadLock lock(m_mutex);
+	return m_dataAccess.countAlbumsOwnedOfUser(user);
+}
+
+int ConcurrentAccess::countAlbumsTaggedOfUser(const User& user)
+{
+	ReadLock lock(m_mutex);
+	return m_dataAccess.countAlbumsTaggedOfUser(user);
+}
+
+int ConcurrentAccess::countTagsOfUser(const User& user)
+{
+	ReadLock lock(m_mutex);
+	return m_dataAccess.countTagsOfUser(user);
+}
+
+float ConcurrentAccess::averageTagsPerAlbumOfUser(const User& user)
+{
+	ReadLock lock(m_mutex);
+	return m_dataAccess.averageTagsPerAlbumOfUser(user);
+}
+
+
+// ******************* Queries *******************
+User ConcurrentAccess::getTopTaggedUser()
+{
+	ReadLock lock(m_mutex);
+	return m_dataAccess.getTopTaggedUser();
+}
+
+Picture ConcurrentAccess::getTopTaggedPicture()
+{
+	ReadLock lock(m_mutex);
+	return m_dataAccess.getTopTaggedPicture();
+}
+
+std::list<Picture> ConcurrentAccess::getTaggedPicturesOfUser(const User& user)
+{
+	ReadLock lock(m_mutex);
+	return m_dataAccess.getTaggedPicturesOfUser(user);
+}
+
+std::list<User> ConcurrentAccess::getTopTaggedUsers(int count)
+{
+	ReadLock lock(m_mutex);
+	return m_dataAccess.getTopTaggedUsers(count);
+}
+
+std::list<Picture> ConcurrentAccess::getTopTaggedPictures(int count)
+{
+	ReadLock lock(m_mutex);
+	return m_dataAccess.getTopTaggedPictures(count);
+}
+
+std::list<Picture> ConcurrentAccess::getPicturesCreatedBetween(int64_t from, int64_t to)
+{
+	ReadLock lock(m_mutex);
+	return m_dataAccess.getPicturesCreatedBetween(from, to);
+}
+
+std::list<std::list<Picture>> ConcurrentAccess::getDuplicatePictures()
+{
+	ReadLock lock(m_mutex);
+	return m_dataAccess.getDuplicatePictures();
+}
+
+std::list<std::list<Picture>> ConcurrentAccess::getSimilarPictures(int maxDistance)
+{
+	ReadLock lock(m_mutex);
+	return m_dataAccess.getSimilarPictures(maxDistance);
+}
+
+std::list<Picture> ConcurrentAccess::getPicturesLargerThan(const std::string& albumName, int ownerId, int pixels)
+{
+	ReadLock lock(m_mutex);
+	// may load the album into the albums cache of the wrapped data access
+	std::lock_guard<std::mutex> loadLock(m_loadMutex);
+	return m_dataAccess.getPicturesLargerThan(albumName, ownerId, pixels);
+}
+
+std::list<Picture> ConcurrentAccess::getPicturesCapturedBetween(int64_t from, int64_t to)
+{
+	ReadLock lock(m_mutex);
+	return m_dataAccess.getPicturesCapturedBetween(from, to);
+}
+
+std::list<Picture> ConcurrentAccess::getPicturesOfCamera(const std::string& cameraModel)
+{
+	ReadLock lock(m_mutex);
+	return m_dataAccess.getPicturesOfCamera(cameraModel);
+}
+
+
+// ******************* SQL *******************
+bool ConcurrentAccess::open()
+{
+	WriteLock lock(m_mutex);
+	return m_dataAccess.open();
+}
+
+void ConcurrentAccess::close()
+{
+	WriteLock lock(m_mutex);
+	m_dataAccess.close();
+}
+
+void ConcurrentAccess::clear()
+{
+	WriteLock lock(m_mutex);
+	m_dataAccess.clear();
+}
+
+void ConcurrentAccess::flush()
+{
+	WriteLock lock(m_mutex);
+	m_dataAccess.flush();
+}
+
+bool ConcurrentAccess::saveSnapshot()
+{
+	WriteLock lock(m_mutex);
+	return m_dataAccess.saveSnapshot();
+}
+
+bool ConcurrentAccess::runSqlCommand(std::string sqlStatement)
+{
+	WriteLock lock(m_mutex);
+	return m_dataAccess.runSqlCommand(sqlStatement);
+}
+
+void ConcurrentAccess::dropTables()
+{
+	WriteLock lock(m_mutex);
+	m_dataAccess.dropTables();
+}
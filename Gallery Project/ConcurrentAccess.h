@@ -0,0 +1,108 @@
+#pragma once
+#include <mutex>
+#include <shared_mutex>
+#include "IDataAccess.h"
+
+/*
+A reader/writer mutex that lets a waiting writer in before the readers that come after it.
+std::shared_mutex may prefer the readers, and readers that overlap each other (waiting for the
+load mutex or the DB) would keep the writers out for good.
+*/
+class WriterPreferringMutex
+{
+
+public:
+	void lock();
+	void unlock();
+	void lock_shared();
+	void unlock_shared();
+
+private:
+	std::shared_mutex m_mutex;
+	// held by a writer from the moment it waits for the lock until it unlocks
+	std::mutex m_writerMutex;
+};
+
+/*
+A thread safe wrapper of another data access.
+Queries run concurrently under a shared lock, changes run alone under an exclusive lock
+(a waiting change goes before the queries that come after it).
+The albums handed out (getAlbums, openAlbum, getAlbumById) are copies owned by the caller,
+sharing their pictures with the originals until a writer changes them, so they stay unchanged
+whatever the other threads change meanwhile.
+Every query that may load an album lazily (openAlbum, getAlbumById, getPicturesLargerThan)
+or build a snapshot also takes the load mutex, since it changes the wrapped data access.
+*/
+class ConcurrentAccess : public IDataAccess
+{
+
+public:
+	ConcurrentAccess(IDataAccess& dataAccess);
+	virtual ~ConcurrentAccess() = default;
+
+	// album related
+	std::list<Album> getAlbums() override;
+	std::list<Album> getAlbumsOfUser(const User& user) override;
+	void createAlbum(const Album& album) override;
+	void importAlbums(const std::list<Album>& albums) override;
+	void deleteAlbum(const std::string& albumName, int userId) override;
+	bool doesAlbumExists(const std::string& albumName, int userId) override;
+	Album openAlbum(const std::string& albumName, int userId) override;
+	Album getAlbumById(const int albumId) override;
+	void closeAlbum(const Album& pAlbum) override;
+	void printAlbums() override;
+	std::shared_ptr<const GallerySnapshot> getSnapshot() override;
+
+	// picture related
+	void addPictureToAlbumByName(const std::string& albumName, int ownerId, const Picture& picture) override;
+	void removePictureFromAlbumByName(const std::string& albumName, int ownerId, const std::string& pictureName) override;
+	void tagUserInPicture(const std::string& albumName, int ownerId, const std::string& pictureName, int userId) override;
+	void untagUserInPicture(const std::string& albumName, int ownerId, const std::string& pictureName, int userId) override;
+	int getLastPictureId() override;
+
+	// user related
+	void printUsers() override;
+	void createUser(User& user) override;
+	void deleteUser(const User& user) override;
+	bool doesUserExists(int userId) override;
+	int getLastUserId() override;
+	User getUser(int userId) override;
+	void deleteUsersAlbums(const User& user) override;
+	void deleteUserTags(const User& user) override;
+	void deleteUserCascade(const User& user) override;
+
+	// user statistics
+	int countAlbumsOwnedOfUser(const User& user) override;
+	int countAlbumsTaggedOfUser(const User& user) override;
+	int countTagsOfUser(const User& user) override;
+	float averageTagsPerAlbumOfUser(const User& user) override;
+
+	// queries
+	User getTopTaggedUser() override;
+	Picture getTopTaggedPicture() override;
+	std::list<Picture> getTaggedPicturesOfUser(const User& user) override;
+	std::list<User> getTopTaggedUsers(int count) override;
+	std::list<Picture> getTopTaggedPictures(int count) override;
+	std::list<Picture> getPicturesCreatedBetween(int64_t from, int64_t to) override;
+	std::list<std::list<Picture>> getDuplicatePictures() override;
+	std::list<std::list<Picture>> getSimilarPictures(int maxDistance) override;
+	std::list<Picture> getPicturesLargerThan(const std::string& albumName, int ownerId, int pixels) override;
+	std::list<Picture> getPicturesCapturedBetween(int64_t from, int64_t to) override;
+	std::list<Picture> getPicturesOfCamera(const std::string& cameraModel) override;
+
+	bool open() override;
+	void close() override;
+	void clear() override;
+	void flush() override;
+	bool saveSnapshot() override;
+	bool runSqlCommand(std::string sqlStatement) override;
+	void dropTables() override;
+
+private:
+	IDataAccess& m_dataAccess;
+	WriterPreferringMutex m_mutex;
+	// the wrapped data access builds its snapshot and may load albums lazily, so readers do it one at a time
+	std::mutex m_loadMutex;
+
+	std::shared_ptr<const GallerySnapshot> takeSnapshot();
+};
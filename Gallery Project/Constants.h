@@ -33,10 +33,27 @@ enum CommandType
 	TOP_TAGGED_USER,
 	TOP_TAGGED_PICTURE,
 	PICTURES_TAGGED_USER,
+	TOP_TAGGED_USERS,
+	TOP_TAGGED_PICTURES,
+	PICTURES_CREATED_BETWEEN,
+
+	SAVE_SNAPSHOT,
+	IMPORT_ALBUMS,
+	FIND_DUPLICATES,
+	SIMILAR_PICTURES,
+	MAKE_THUMBNAILS,
+	LARGE_PICTURES,
+	PICTURES_CAPTURED_BETWEEN,
+	PICTURES_OF_CAMERA,
 
 	EXIT = 99
 };
 
+// how many entries the top tagged users / pictures queries list
+const int TOP_TAGGED_COUNT = 10;
+// where the thumbnails of the pictures are cached
+const std::string THUMBNAILS_FOLDER = "Thumbnails";
+
 struct CommandPrompt {
 	CommandType type;
 	const std::string prompt;
@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include "ContentHash.h"
+
+static const uint64_t PRIME_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t PRIME_3 = 0x165667B19E3779F9ULL;
+static const uint64_t PRIME_4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t PRIME_5 = 0x27D4EB2F165667C5ULL;
+
+// files are read in big sequential blocks, so a file costs a few reads instead of one per buffer of the stdio
+static const size_t READ_SIZE = 1 << 20;
+
+
+static inline uint64_t rotateLeft(uint64_t value, int bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+// the bytes are read as little endian whatever the machine is, so every machine gives the same hash
+// (written as a byte by byte read, which the compiler turns into a single load on a little endian machine)
+static inline uint64_t read64(const unsigned char* bytes)
+{
+	return static_cast<uint64_t>(bytes[0]) | (static_cast<uint64_t>(bytes[1]) << 8) |
+		(static_cast<uint64_t>(bytes[2]) << 16) | (static_cast<uint64_t>(bytes[3]) << 24) |
+		(static_cast<uint64_t>(bytes[4]) << 32) | (static_cast<uint64_t>(bytes[5]) << 40) |
+		(static_cast<uint64_t>(bytes[6]) << 48) | (static_cast<uint64_t>(bytes[7]) << 56);
+}
+
+static inline uint32_t read32(const unsigned char* bytes)
+{
+	return static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+		(static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+static inline uint64_t mixLane(uint64_t lane, uint64_t input)
+{
+	lane += input * PRIME_2;
+	lane = rotateLeft(lane, 31);
+	return lane * PRIME_1;
+}
+
+static inline uint64_t mergeRound(uint64_t hash, uint64_t lane)
+{
+	hash ^= mixLane(0, lane);
+	return hash * PRIME_1 + PRIME_4;
+}
+
+
+ContentHash::ContentHash(uint64_t seed) :
+	m_lanes { seed + PRIME_1 + PRIME_2, seed + PRIME_2, seed, seed - PRIME_1 }, m_seed(seed)
+{
+	// Left empty
+}
+
+/*
+This function adds a block of bytes to the hash
+input: the bytes and their count
+output: none
+*/
+void ContentHash::update(const void* data, size_t size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	const unsigned char* end = bytes + size;
+	m_totalSize += size;
+
+	// first fill the stripe that was left from the last block
+	if (m_stripeSize > 0) {
+		size_t count = std::min(size, STRIPE_SIZE - m_stripeSize);
+		std::memcpy(m_stripe + m_stripeSize, bytes, count);
+		m_stripeSize += count;
+		bytes += count;
+
+		if (m_stripeSize < STRIPE_SIZE) {
+			return;
+		}
+		consumeStripe(m_stripe);
+		m_stripeSize = 0;
+	}
+
+	for (; end - bytes >= static_cast<ptrdiff_t>(STRIPE_SIZE); bytes += STRIPE_SIZE) {
+		consumeStripe(bytes);
+	}
+
+	m_stripeSize = end - bytes;
+	std::memcpy(m_stripe, bytes, m_stripeSize);
+}
+
+/*
+This function gives the hash of all the bytes that were added so far (more may be added after it)
+input: none
+output: the hash
+*/
+uint64_t ContentHash::digest() const
+{
+	uint64_t hash = 0;
+
+	if (m_totalSize >= STRIPE_SIZE) {
+		hash = rotateLeft(m_lanes[0], 1) + rotateLeft(m_lanes[1], 7) + rotateLeft(m_lanes[2], 12) + rotateLeft(m_lanes[3], 18);
+		for (uint64_t lane : m_lanes) {
+			hash = mergeRound(hash, lane);
+		}
+	}
+	else {
+		hash = m_seed + PRIME_5;
+	}
+	hash += m_totalSize;
+
+	const unsigned char* bytes = m_stripe;
+	const unsigned char* end = m_stripe + m_stripeSize;
+
+	for (; end - bytes >= 8; bytes += 8) {
+		hash ^= mixLane(0, read64(bytes));
+		hash = rotateLeft(hash, 27) * PRIME_1 + PRIME_4;
+	}
+	if (end - bytes >= 4) {
+		hash ^= read32(bytes) * PRIME_1;
+		hash = rotateLeft(hash, 23) * PRIME_2 + PRIME_3;
+		bytes += 4;
+	}
+	for (; bytes < end; ++bytes) {
+		hash ^= *bytes * PRIME_5;
+		hash = rotateLeft(hash, 11) * PRIME_1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= PRIME_2;
+	hash ^= hash >> 29;
+	hash *= PRIME_3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+/*
+This function hashes the content of a file
+input: the file path, the hash to fill
+output: true if the file was read, false otherwise
+*/
+bool ContentHash::hashFile(const std::string& path, uint64_t& hash)
+{
+	// one buffer per thread, files are hashed by several threads at once
+	thread_local std::unique_ptr<unsigned char[]> buffer(new unsigned char[READ_SIZE]);
+
+	FILE* file = std::fopen(path.c_str(), "rb");
+	if (nullptr == file) {
+		return false;
+	}
+	// the reads are already as big as a buffer of the stdio could be
+	std::setvbuf(file, nullptr, _IONBF, 0);
+
+	ContentHash contentHash;
+	size_t count = 0;
+	while ((count = std::fread(buffer.get(), 1, READ_SIZE, file)) > 0) {
+		contentHash.update(buffer.get(), count);
+	}
+
+	bool succeeded = !std::ferror(file);
+	std::fclose(file);
+	if (!succeeded) {
+		return false;
+	}
+
+	hash = contentHash.digest();
+	// 0 means "not hashed", a file that really hashes to 0 is moved next to it
+	if (0 == hash) {
+		hash = 1;
+	}
+	return true;
+}
+
+/*
+This function formats a hash as it is shown to the user
+input: the hash
+output: 16 hex digits
+*/
+std::string ContentHash::toString(uint64_t hash)
+{
+	std::ostringstream str;
+	str << std::hex << std::setw(16) << std::setfill('0') << hash;
+	return str.str();
+}
+
+void ContentHash::consumeStripe(const unsigned char* stripe)
+{
+	m_lanes[0] = mixLane(m_lanes[0], read64(stripe));
+	m_lanes[1] = mixLane(m_lanes[1], read64(stripe + 8));
+	m_lanes[2] = mixLane(m_lanes[2], read64(stripe + 16));
+	m_lanes[3] = mixLane(m_lanes[3], read64(stripe + 24));
+}
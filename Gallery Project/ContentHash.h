@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+A 64 bit hash of a file's content (XXH64), used to find pictures that are the same file.
+The hash is computed in a stream - update() may be called with any sizes of blocks, and
+digest() gives the same hash as hashing all of them at once. It works on four independent
+lanes of 8 bytes, so the compiler can keep the four of them in flight together.
+Hash 0 is never given to a file, it means "not hashed" (see hashFile()).
+*/
+class ContentHash
+{
+public:
+	explicit ContentHash(uint64_t seed = 0);
+
+	void update(const void* data, size_t size);
+	uint64_t digest() const;
+
+	static bool hashFile(const std::string& path, uint64_t& hash);
+	static std::string toString(uint64_t hash);
+
+private:
+	static const size_t STRIPE_SIZE = 32;
+
+	uint64_t m_lanes[4];
+	uint64_t m_seed;
+	uint64_t m_totalSize { 0 };
+	// the bytes that don't fill a whole stripe yet
+	unsigned char m_stripe[STRIPE_SIZE];
+	size_t m_stripeSize { 0 };
+
+	void consumeStripe(const unsigned char* stripe);
+};
@@ -1,9 +1,29 @@
 #include <map>
 #include <algorithm>
+#include <chrono>
+#include <thread>
+#include <unordered_map>
 
 #include "ItemNotFoundException.h"
 #include "DatabaseAccess.h"
 
+// the creation dates are kept as seconds since the epoch
+const char* const ALBUMS_COLUMNS = "ID INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, NAME TEXT NOT NULL, CREATION_DATE INTEGER NOT NULL, USER_ID INTEGER NOT NULL REFERENCES USERS(ID)";
+const char* const PICTURES_COLUMNS = "ID INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, NAME TEXT NOT NULL, LOCATION TEXT NOT NULL, CREATION_DATE INTEGER NOT NULL, ALBUM_ID INTEGER NOT NULL REFERENCES ALBUMS(ID), CONTENT_HASH INTEGER NOT NULL DEFAULT 0, PERCEPTUAL_HASH INTEGER NOT NULL DEFAULT 0, "
+	"WIDTH INTEGER NOT NULL DEFAULT 0, HEIGHT INTEGER NOT NULL DEFAULT 0, FORMAT INTEGER NOT NULL DEFAULT 0, FILE_SIZE INTEGER NOT NULL DEFAULT 0";
+// the EXIF metadata of the pictures that have it, the location is NULL when the photo has none
+const char* const PICTURE_METADATA_COLUMNS = "PICTURE_ID INTEGER PRIMARY KEY NOT NULL REFERENCES PICTURES(ID), CAPTURE_TIME INTEGER NOT NULL, CAMERA_MODEL TEXT NOT NULL COLLATE NOCASE, "
+	"LATITUDE REAL, LONGITUDE REAL";
+// the columns of a picture that columnPicture() reads, in its order - the metadata columns come from PICTURE_METADATA_JOIN
+const std::string PICTURE_FIELDS = "PICTURES.ID, PICTURES.NAME, PICTURES.LOCATION, PICTURES.CREATION_DATE, PICTURES.CONTENT_HASH, PICTURES.PERCEPTUAL_HASH, "
+	"PICTURES.WIDTH, PICTURES.HEIGHT, PICTURES.FORMAT, PICTURES.FILE_SIZE, "
+	"PICTURE_METADATA.CAPTURE_TIME, PICTURE_METADATA.CAMERA_MODEL, PICTURE_METADATA.LATITUDE, PICTURE_METADATA.LONGITUDE";
+const int PICTURE_FIELDS_COUNT = 14;
+// joined to PICTURES by every query that selects the PICTURE_FIELDS (a lookup by the primary key)
+const std::string PICTURE_METADATA_JOIN = " LEFT JOIN PICTURE_METADATA ON PICTURE_METADATA.PICTURE_ID = PICTURES.ID";
+// how many times flush() tries to commit a transaction, and the wait before the first retry (it doubles every retry)
+const int COMMIT_ATTEMPTS = 5;
+const std::chrono::milliseconds COMMIT_RETRY_DELAY(20);
 
 
 void DatabaseAccess::printAlbums()
@@ -21,7 +41,8 @@ void DatabaseAccess::printAlbums()
 bool DatabaseAccess::open()
 {
 	int doesFileExist = _access(dbFileName.c_str(), 0);
-	int res = sqlite3_open(dbFileName.c_str(), &db);
+	// serialized mode, so the connection may be used from more than one thread
+	int res = sqlite3_open_v2(dbFileName.c_str(), &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX, nullptr);
 
 	if (res != SQLITE_OK)
 	{
@@ -30,29 +51,496 @@ bool DatabaseAccess::open()
 		return false;
 	}
 
-	if (doesFileExist == -1) {
-		// init database
-		char* sqlStatementUsers = "CREATE TABLE IF NOT EXISTS USERS (ID INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, NAME TEXT NOT NULL);";
-		char* sqlStatementAlbums = "CREATE TABLE IF NOT EXISTS ALBUMS (ID INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, NAME TEXT NOT NULL, CREATION_DATE TEXT NOT NULL, USER_ID INTEGER FOREIGN KEY REFERENCES USERS(ID) NOT NULL);";
-		char* sqlStatementPictures = "CREATE TABLE IF NOT EXISTS PICTURES (ID INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, NAME TEXT NOT NULL, LOCATION TEXT NOT NULL, CREATION_DATE TEXT NOT NULL, ALBUM_ID INTEGER FOREIGN KEY REFERENCES ALBUMS(ID) NOT NULL);";
-		char* sqlStatementTags = "CREATE TABLE IF NOT EXISTS TAGS (ID INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, PICTURE_ID INTEGER FOREIGN KEY REFERENCES PICTURES(ID) NOT NULL, USER_ID INTEGER FOREIGN KEY REFERENCES USERS(ID) NOT NULL);";
-
-		if (!(runSqlCommand(sqlStatementUsers) && runSqlCommand(sqlStatementAlbums) && runSqlCommand(sqlStatementPictures) && runSqlCommand(sqlStatementTags)))
-		{
-			std::cout << "Failed to create DB" << std::endl;
+	// write ahead log, so readers of the DB are not blocked by a writer
+	runSqlCommand("PRAGMA journal_mode=WAL;");
+
+	// init database (tables that already exist are left untouched)
+	const char* sqlStatementUsers = "CREATE TABLE IF NOT EXISTS USERS (ID INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, NAME TEXT NOT NULL);";
+	const std::string sqlStatementAlbums = std::string("CREATE TABLE IF NOT EXISTS ALBUMS (") + ALBUMS_COLUMNS + ");";
+	const std::string sqlStatementPictures = std::string("CREATE TABLE IF NOT EXISTS PICTURES (") + PICTURES_COLUMNS + ");";
+	const std::string sqlStatementPictureMetadata = std::string("CREATE TABLE IF NOT EXISTS PICTURE_METADATA (") + PICTURE_METADATA_COLUMNS + ");";
+	const char* sqlStatementTags = "CREATE TABLE IF NOT EXISTS TAGS (ID INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, PICTURE_ID INTEGER NOT NULL REFERENCES PICTURES(ID), USER_ID INTEGER NOT NULL REFERENCES USERS(ID));";
+	// the stamp of the snapshot file that matches the DB (no row if there is none)
+	const char* sqlStatementSnapshotStamp = "CREATE TABLE IF NOT EXISTS SNAPSHOT_STAMP (STAMP INTEGER NOT NULL);";
+
+	// secondary indexes - they cover the statistics queries and the cascading deletes
+	const char* sqlStatementIndexes =
+		"CREATE INDEX IF NOT EXISTS ALBUMS_USER_ID ON ALBUMS (USER_ID);"
+		"CREATE INDEX IF NOT EXISTS PICTURES_ALBUM_ID ON PICTURES (ALBUM_ID);"
+		"CREATE INDEX IF NOT EXISTS PICTURES_CREATION_DATE ON PICTURES (CREATION_DATE);"
+		"CREATE INDEX IF NOT EXISTS PICTURES_CONTENT_HASH ON PICTURES (CONTENT_HASH);"
+		"CREATE INDEX IF NOT EXISTS PICTURE_METADATA_CAPTURE_TIME ON PICTURE_METADATA (CAPTURE_TIME);"
+		"CREATE INDEX IF NOT EXISTS PICTURE_METADATA_CAMERA_MODEL ON PICTURE_METADATA (CAMERA_MODEL, CAPTURE_TIME);"
+		"CREATE INDEX IF NOT EXISTS TAGS_USER_ID ON TAGS (USER_ID, PICTURE_ID);"
+		"CREATE INDEX IF NOT EXISTS TAGS_PICTURE_ID ON TAGS (PICTURE_ID, USER_ID);";
+
+	if (!(runSqlCommand(sqlStatementUsers) && runSqlCommand(sqlStatementAlbums) && runSqlCommand(sqlStatementPictures) && runSqlCommand(sqlStatementPictureMetadata) && runSqlCommand(sqlStatementTags) &&
+		runSqlCommand(sqlStatementSnapshotStamp) && migrateCreationDates() && addMissingColumns() && runSqlCommand(sqlStatementIndexes)))
+	{
+		std::cout << "Failed to create DB" << std::endl;
+		if (doesFileExist == -1) {
 			dropTables();
-			sqlite3_close(db);
-			db = nullptr;
+		}
+		for (auto& statement : m_statements) {
+			sqlite3_finalize(statement.second);
+		}
+		m_statements.clear();
+		sqlite3_close(db);
+		db = nullptr;
+		if (doesFileExist == -1) {
 			remove(dbFileName.c_str());
+		}
+		return false;
+	}
+
+	if (!loadSnapshot() && !loadGallery())
+	{
+		std::cout << "Failed to load gallery from DB" << std::endl;
+		clear();
+
+		// the handle isn't left open behind a failed open()
+		for (auto& statement : m_statements) {
+			sqlite3_finalize(statement.second);
+		}
+		m_statements.clear();
+		m_snapshotFile.close();
+		sqlite3_close(db);
+		db = nullptr;
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+This function converts the creation dates of a DB written by an older version, which kept them
+as "dd/mm/yyyy hh:mm:ss" text in local time, into seconds since the epoch.
+Every table is rebuilt at most once (the column type tells whether it was converted already),
+a date that can't be read becomes 0.
+input: none
+output: true if the DB holds no text dates anymore, false otherwise
+*/
+bool DatabaseAccess::migrateCreationDates()
+{
+	const std::string toTime = "COALESCE(CAST(strftime('%s', substr(CREATION_DATE, 7, 4) || '-' || substr(CREATION_DATE, 4, 2) || '-' || substr(CREATION_DATE, 1, 2) "
+		"|| ' ' || trim(substr(CREATION_DATE, 12, 8)), 'utc') AS INTEGER), 0)";
+
+	const std::vector<std::pair<std::string, std::string>> tables = {
+		{ "ALBUMS", "ID, NAME, CREATION_DATE, USER_ID" },
+		{ "PICTURES", "ID, NAME, LOCATION, CREATION_DATE, ALBUM_ID" }
+	};
+
+	for (const auto& table : tables) {
+		std::string type;
+		if (!runQuery("SELECT type FROM pragma_table_info('" + table.first + "') WHERE name = 'CREATION_DATE';", {}, [&type](sqlite3_stmt* statement) {
+			type = columnText(statement, 0);
+		}))
+		{
+			return false;
+		}
+		if (type != "TEXT") {
+			continue;
+		}
+
+		std::string values = table.second;
+		values.replace(values.find("CREATION_DATE"), std::string("CREATION_DATE").size(), toTime);
+
+		std::string sqlStatement = "BEGIN;"
+			"CREATE TABLE " + table.first + "_NEW (" + (table.first == "ALBUMS" ? ALBUMS_COLUMNS : PICTURES_COLUMNS) + ");"
+			"INSERT INTO " + table.first + "_NEW (" + table.second + ") SELECT " + values + " FROM " + table.first + ";"
+			"DROP TABLE " + table.first + ";"
+			"ALTER TABLE " + table.first + "_NEW RENAME TO " + table.first + ";"
+			"COMMIT;";
+
+		if (!runSqlCommand(sqlStatement))
+		{
+			runSqlCommand("ROLLBACK;");
+			return false;
+		}
+		std::cout << "Converted the creation dates of " << table.first << " to timestamps" << std::endl;
+	}
+
+	return true;
+}
+
+/*
+This function adds to the tables of a DB written by an older version the columns that were added after it
+input: none
+output: true if every table has all its columns, false otherwise
+*/
+bool DatabaseAccess::addMissingColumns()
+{
+	struct Column
+	{
+		std::string table;
+		std::string name;
+		std::string definition;
+	};
+	const std::vector<Column> columns = {
+		{ "PICTURES", "CONTENT_HASH", "INTEGER NOT NULL DEFAULT 0" },
+		{ "PICTURES", "PERCEPTUAL_HASH", "INTEGER NOT NULL DEFAULT 0" },
+		{ "PICTURES", "WIDTH", "INTEGER NOT NULL DEFAULT 0" },
+		{ "PICTURES", "HEIGHT", "INTEGER NOT NULL DEFAULT 0" },
+		{ "PICTURES", "FORMAT", "INTEGER NOT NULL DEFAULT 0" },
+		{ "PICTURES", "FILE_SIZE", "INTEGER NOT NULL DEFAULT 0" }
+	};
+
+	for (const Column& column : columns) {
+		bool exists = false;
+		if (!runQuery("SELECT 1 FROM pragma_table_info('" + column.table + "') WHERE name = '" + column.name + "';", {}, [&exists](sqlite3_stmt*) {
+			exists = true;
+		}))
+		{
+			return false;
+		}
+
+		if (!exists && !runSqlCommand("ALTER TABLE " + column.table + " ADD COLUMN " + column.name + " " + column.definition + ";")) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+/*
+This function loads all the users, albums, pictures and tags from the DB into memory
+(in lazy loading mode only the users and the album headers).
+Every table is streamed once with a prepared statement, and the tags are merged into
+their pictures while the pictures are read (both cursors are ordered by picture id).
+input: none
+output: true if the whole gallery was loaded, false otherwise
+*/
+bool DatabaseAccess::loadGallery()
+{
+	auto startTime = std::chrono::steady_clock::now();
+	long long usersCount = 0, albumsCount = 0, picturesCount = 0, tagsCount = 0;
+	sqlite3_stmt* statement = nullptr;
+
+	clear();
+
+	// users
+	if (sqlite3_prepare_v2(db, "SELECT ID, NAME FROM USERS;", -1, &statement, nullptr) != SQLITE_OK) {
+		return false;
+	}
+	while (sqlite3_step(statement) == SQLITE_ROW) {
+		m_users.emplace_back(sqlite3_column_int(statement, 0), columnText(statement, 1));
+		m_index.addUser(std::prev(m_users.end()));
+		++usersCount;
+	}
+	sqlite3_finalize(statement);
+
+	// albums
+	if (sqlite3_prepare_v2(db, "SELECT ID, NAME, CREATION_DATE, USER_ID FROM ALBUMS;", -1, &statement, nullptr) != SQLITE_OK) {
+		return false;
+	}
+	while (sqlite3_step(statement) == SQLITE_ROW) {
+		m_albums.emplace_back(sqlite3_column_int(statement, 3), columnText(statement, 1), sqlite3_column_int64(statement, 2));
+		m_albums.back().setId(sqlite3_column_int(statement, 0));
+		m_index.addAlbum(std::prev(m_albums.end()));
+		++albumsCount;
+	}
+	sqlite3_finalize(statement);
+
+	// pictures and tags (in lazy loading mode they are loaded album by album, on demand)
+	if (!m_lazyLoading)
+	{
+		// every album gets room for all its pictures at once
+		if (sqlite3_prepare_v2(db, "SELECT ALBUM_ID, COUNT(*) FROM PICTURES GROUP BY ALBUM_ID;", -1, &statement, nullptr) != SQLITE_OK) {
+			return false;
+		}
+		while (sqlite3_step(statement) == SQLITE_ROW) {
+			auto album = m_index.findAlbum(sqlite3_column_int(statement, 0));
+			if (album != m_albums.end()) {
+				album->reservePictures(static_cast<size_t>(sqlite3_column_int64(statement, 1)));
+			}
+		}
+		sqlite3_finalize(statement);
+
+		sqlite3_stmt* tagsStatement = nullptr;
+		const std::string sqlStatementPictures = "SELECT " + PICTURE_FIELDS + ", PICTURES.ALBUM_ID FROM PICTURES" + PICTURE_METADATA_JOIN + " ORDER BY ID;";
+		if (sqlite3_prepare_v2(db, sqlStatementPictures.c_str(), -1, &statement, nullptr) != SQLITE_OK ||
+			sqlite3_prepare_v2(db, "SELECT PICTURE_ID, USER_ID FROM TAGS ORDER BY PICTURE_ID;", -1, &tagsStatement, nullptr) != SQLITE_OK)
+		{
+			sqlite3_finalize(statement);
+			return false;
+		}
+
+		// reused for every row
+		std::string name, location;
+
+		bool hasTag = sqlite3_step(tagsStatement) == SQLITE_ROW;
+		while (sqlite3_step(statement) == SQLITE_ROW) {
+			columnText(statement, 1, name);
+			columnText(statement, 2, location);
+			Picture picture(sqlite3_column_int(statement, 0), name, location, sqlite3_column_int64(statement, 3));
+			columnPictureDetails(statement, picture);
+
+			// skip tags of pictures that no longer exist
+			while (hasTag && sqlite3_column_int(tagsStatement, 0) < picture.getId()) {
+				hasTag = sqlite3_step(tagsStatement) == SQLITE_ROW;
+			}
+			while (hasTag && sqlite3_column_int(tagsStatement, 0) == picture.getId()) {
+				picture.tagUser(sqlite3_column_int(tagsStatement, 1));
+				++tagsCount;
+				hasTag = sqlite3_step(tagsStatement) == SQLITE_ROW;
+			}
+
+			auto album = m_index.findAlbum(sqlite3_column_int(statement, PICTURE_FIELDS_COUNT));
+			if (album != m_albums.end()) {
+				m_index.addPicture(album->getId(), picture);
+				album->addPicture(std::move(picture));
+				++picturesCount;
+			}
+		}
+		sqlite3_finalize(tagsStatement);
+		sqlite3_finalize(statement);
+	}
+
+	std::chrono::duration<double> loadTime = std::chrono::steady_clock::now() - startTime;
+	long long rowsCount = usersCount + albumsCount + picturesCount + tagsCount;
+
+	std::cout << "Loaded " << usersCount << " users, " << albumsCount << " albums, " << picturesCount << " pictures and "
+		<< tagsCount << " tags in " << std::fixed << std::setprecision(3) << loadTime.count() << " sec";
+	if (loadTime.count() > 0) {
+		std::cout << " (" << static_cast<long long>(rowsCount / loadTime.count()) << " rows/sec)";
+	}
+	std::cout << std::defaultfloat << std::endl;
+
+	return true;
+}
+
+
+/*
+This function loads the gallery from the snapshot file, if the DB holds the stamp of that file
+(it holds it from saveSnapshot() until the first change). The file is mapped, so only the users
+and the album headers are built - and in lazy loading mode the file is kept open and the
+albums are loaded from it on demand until the first change, not from the DB.
+input: none
+output: true if the gallery was loaded from the snapshot, false if it must be loaded from the DB
+*/
+bool DatabaseAccess::loadSnapshot()
+{
+	sqlite3_int64 stamp = 0;
+	m_snapshotStamped = false;
+
+	if (!runQuery("SELECT STAMP FROM SNAPSHOT_STAMP;", {}, [&stamp](sqlite3_stmt* statement) { stamp = sqlite3_column_int64(statement, 0); }) || 0 == stamp) {
+		return false;
+	}
+	m_snapshotStamped = true;
+
+	if (!m_snapshotFile.open(snapshotFileName) || m_snapshotFile.getStamp() != static_cast<uint64_t>(stamp)) {
+		m_snapshotFile.close();
+		return false;
+	}
+
+	auto startTime = std::chrono::steady_clock::now();
+	clear();
+
+	for (size_t user = 0; user < m_snapshotFile.getUsersCount(); ++user) {
+		m_users.push_back(m_snapshotFile.getUser(user));
+		m_index.addUser(std::prev(m_users.end()));
+	}
+
+	for (size_t album = 0; album < m_snapshotFile.getAlbumsCount(); ++album) {
+		m_albums.push_back(m_snapshotFile.getAlbum(album));
+		if (!m_lazyLoading && !m_snapshotFile.readPictures(album, m_albums.back())) {
+			std::cout << "The snapshot file is damaged" << std::endl;
+			m_snapshotFile.close();
+			clear();
 			return false;
 		}
+		m_index.addAlbum(std::prev(m_albums.end()));
+	}
+
+	std::chrono::duration<double> loadTime = std::chrono::steady_clock::now() - startTime;
+	std::cout << "Loaded " << m_users.size() << " users, " << m_albums.size() << " albums, " << m_snapshotFile.getPicturesCount() << " pictures and "
+		<< m_snapshotFile.getTagsCount() << " tags from the snapshot in " << std::fixed << std::setprecision(3) << loadTime.count() << " sec"
+		<< std::defaultfloat << std::endl;
+
+	if (!m_lazyLoading) {
+		m_snapshotFile.close();
+	}
+
+	return true;
+}
+
+
+/*
+This function saves a snapshot file of the gallery, which open() loads instead of the DB
+as long as the DB isn't changed. The file and the DB are tied by a random stamp that is kept
+in both, and the first change of the DB drops the stamp from it.
+A change of the DB that doesn't go through this class isn't noticed.
+input: none
+output: true if the snapshot was saved, false otherwise
+*/
+bool DatabaseAccess::saveSnapshot()
+{
+	auto startTime = std::chrono::steady_clock::now();
+
+	flush();
+	// a mapped file can't be replaced on every system
+	m_snapshotFile.close();
+
+	uint64_t stamp = SnapshotFile::newStamp();
+
+	bool success = SnapshotFile::save(snapshotFileName, stamp, m_users, m_albums, [this](const Album& album) {
+		return m_lazyLoading ? queryAlbumPictures(album) : album.getPictures();
+	});
+
+	success = success && runSqlCommand("BEGIN; DELETE FROM SNAPSHOT_STAMP; INSERT INTO SNAPSHOT_STAMP (STAMP) VALUES (" + std::to_string(stamp) + "); COMMIT;");
+	if (!success)
+	{
+		std::cout << "Failed to save snapshot" << std::endl;
+		runSqlCommand("ROLLBACK;");
+		return false;
+	}
+	m_snapshotStamped = true;
+
+	if (m_lazyLoading) {
+		m_snapshotFile.open(snapshotFileName);
 	}
 
+	std::chrono::duration<double> saveTime = std::chrono::steady_clock::now() - startTime;
+	std::cout << "Saved a snapshot of the gallery in " << std::fixed << std::setprecision(3) << saveTime.count() << " sec" << std::defaultfloat << std::endl;
 	return true;
 }
 
+
+/*
+This function drops the stamp of the snapshot file from the DB, so the file isn't loaded anymore.
+It must be called in the transaction of every change of the DB.
+input: none
+output: none
+*/
+void DatabaseAccess::dropSnapshotStamp()
+{
+	if (m_snapshotStamped) {
+		runSqlCommand("DELETE FROM SNAPSHOT_STAMP;");
+		m_snapshotStamped = false;
+		m_snapshotFile.close();
+	}
+}
+
+
+/*
+This function returns the text of a column in the current row of a statement
+input: the statement, the column index
+output: the column text (empty if the column is NULL)
+*/
+std::string DatabaseAccess::columnText(sqlite3_stmt* statement, int column)
+{
+	const unsigned char* text = sqlite3_column_text(statement, column);
+	return text ? std::string(reinterpret_cast<const char*>(text), sqlite3_column_bytes(statement, column)) : std::string();
+}
+
+/*
+This function copies the text of a column in the current row of a statement into a string,
+reusing the string's buffer
+input: the statement, the column index, the string (output parameter, empty if the column is NULL)
+output: none
+*/
+void DatabaseAccess::columnText(sqlite3_stmt* statement, int column, std::string& text)
+{
+	const unsigned char* value = sqlite3_column_text(statement, column);
+	text.assign(value ? reinterpret_cast<const char*>(value) : "", value ? sqlite3_column_bytes(statement, column) : 0);
+}
+
+/*
+This function reads a picture (without its tags) from the current row of a statement
+input: the statement, which selects the PICTURE_FIELDS of a picture
+output: the picture
+*/
+Picture DatabaseAccess::columnPicture(sqlite3_stmt* statement)
+{
+	Picture picture(sqlite3_column_int(statement, 0), columnText(statement, 1), columnText(statement, 2), sqlite3_column_int64(statement, 3));
+	columnPictureDetails(statement, picture);
+	return picture;
+}
+
+/*
+This function reads what was found out about the file of a picture (its hashes, header and metadata) from the current row of a statement
+input: the statement, which selects the PICTURE_FIELDS of a picture, the picture to fill
+output: none
+*/
+void DatabaseAccess::columnPictureDetails(sqlite3_stmt* statement, Picture& picture)
+{
+	picture.setContentHash(static_cast<uint64_t>(sqlite3_column_int64(statement, 4)));
+	picture.setPerceptualHash(static_cast<uint64_t>(sqlite3_column_int64(statement, 5)));
+	picture.setDimensions(sqlite3_column_int(statement, 6), sqlite3_column_int(statement, 7));
+	picture.setFormat(static_cast<ImageFormat>(sqlite3_column_int(statement, 8)));
+	picture.setFileSize(static_cast<uint64_t>(sqlite3_column_int64(statement, 9)));
+
+	// no row in PICTURE_METADATA
+	if (sqlite3_column_type(statement, 10) != SQLITE_NULL) {
+		ExifMetadata metadata;
+		metadata.captureTime = sqlite3_column_int64(statement, 10);
+		columnText(statement, 11, metadata.cameraModel);
+		metadata.hasLocation = sqlite3_column_type(statement, 12) != SQLITE_NULL && sqlite3_column_type(statement, 13) != SQLITE_NULL;
+		if (metadata.hasLocation) {
+			metadata.latitude = sqlite3_column_double(statement, 12);
+			metadata.longitude = sqlite3_column_double(statement, 13);
+		}
+		picture.setMetadata(metadata);
+	}
+}
+
+/*
+This function binds what was found out about the file of a picture (its hashes and header) to the parameters of a statement
+input: the statement, the index of the first of its 6 parameters (CONTENT_HASH, PERCEPTUAL_HASH, WIDTH, HEIGHT, FORMAT, FILE_SIZE), the picture
+output: none
+*/
+void DatabaseAccess::bindPictureDetails(sqlite3_stmt* statement, int firstParameter, const Picture& picture)
+{
+	sqlite3_bind_int64(statement, firstParameter, static_cast<sqlite3_int64>(picture.getContentHash()));
+	sqlite3_bind_int64(statement, firstParameter + 1, static_cast<sqlite3_int64>(picture.getPerceptualHash()));
+	sqlite3_bind_int(statement, firstParameter + 2, picture.getWidth());
+	sqlite3_bind_int(statement, firstParameter + 3, picture.getHeight());
+	sqlite3_bind_int(statement, firstParameter + 4, static_cast<int>(picture.getFormat()));
+	sqlite3_bind_int64(statement, firstParameter + 5, static_cast<sqlite3_int64>(picture.getFileSize()));
+}
+
+/*
+This function binds the metadata of a picture to the parameters of an insert into PICTURE_METADATA
+input: the statement, the picture id, the metadata
+output: none
+*/
+void DatabaseAccess::bindPictureMetadata(sqlite3_stmt* statement, int pictureId, const ExifMetadata& metadata)
+{
+	sqlite3_bind_int(statement, 1, pictureId);
+	sqlite3_bind_int64(statement, 2, metadata.captureTime);
+	sqlite3_bind_text(statement, 3, metadata.cameraModel.c_str(), -1, SQLITE_TRANSIENT);
+	if (metadata.hasLocation) {
+		sqlite3_bind_double(statement, 4, metadata.latitude);
+		sqlite3_bind_double(statement, 5, metadata.longitude);
+	}
+	else {
+		sqlite3_bind_null(statement, 4);
+		sqlite3_bind_null(statement, 5);
+	}
+}
+
 void DatabaseAccess::close()
 {
+	try {
+		flush();
+	}
+	catch (const MyException& e) {
+		std::cout << e.what() << std::endl;
+	}
+
+	if (m_lazyLoading) {
+		std::cout << "Albums cache: " << m_albumsCache.getHits() << " hits, " << m_albumsCache.getMisses() << " misses, "
+			<< m_albumsCache.getEvictions() << " evictions" << std::endl;
+	}
+
+	for (auto& statement : m_statements) {
+		sqlite3_finalize(statement.second);
+	}
+	m_statements.clear();
+	m_snapshotFile.close();
+
 	sqlite3_close(db);
 	db = nullptr;
 }
@@ -60,23 +548,305 @@ void DatabaseAccess::close()
 
 bool DatabaseAccess::runSqlCommand(std::string sqlStatement)
 {
-	char* command = new char[sqlStatement.length() + 1];
-	strcpy(command, sqlStatement.c_str());
+	return sqlite3_exec(db, sqlStatement.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK;
+}
 
-	char** errMessage = nullptr;
-	bool flag = true;
-	int res = sqlite3_exec(db, command, nullptr, nullptr, errMessage);
 
-	if (res != SQLITE_OK)
-		flag = false;
+/*
+This function returns a prepared statement for the given sql, ready to be bound.
+Every statement is prepared once and kept in the statements cache until close().
+input: the sql statement (with ? parameters)
+output: the prepared statement, nullptr if the sql failed to compile
+*/
+sqlite3_stmt* DatabaseAccess::getStatement(const std::string& sqlStatement)
+{
+	auto cached = m_statements.find(sqlStatement);
+	if (cached != m_statements.end()) {
+		sqlite3_reset(cached->second);
+		sqlite3_clear_bindings(cached->second);
+		return cached->second;
+	}
+
+	sqlite3_stmt* statement = nullptr;
+	if (sqlite3_prepare_v3(db, sqlStatement.c_str(), -1, SQLITE_PREPARE_PERSISTENT, &statement, nullptr) != SQLITE_OK) {
+		return nullptr;
+	}
+
+	m_statements[sqlStatement] = statement;
+	return statement;
+}
+
+
+/*
+This function executes a bound change statement from the statements cache.
+Changes are written behind: they join the open transaction, which is committed once
+it holds the flush size of changes or is older than the flush interval (or by flush()),
+so a batch of changes costs one commit instead of one commit each.
+There is no timer - the age of the transaction is checked when a change is written, so a
+transaction that no change follows stays open until flush() (the AlbumManager flushes after
+every command, and close() flushes too).
+input: the statement
+output: true if the statement was executed successfully, false otherwise
+*/
+bool DatabaseAccess::runStatement(sqlite3_stmt* statement)
+{
+	if (nullptr == statement) {
+		return false;
+	}
+
+	if (!m_inTransaction) {
+		m_inTransaction = runSqlCommand("BEGIN;");
+		m_transactionStartTime = std::chrono::steady_clock::now();
+		dropSnapshotStamp();
+	}
+
+	bool res = executeStatement(statement);
+
+	if (m_inTransaction && (++m_pendingChanges >= m_flushSize ||
+		std::chrono::steady_clock::now() - m_transactionStartTime >= m_flushInterval))
+	{
+		flush();
+	}
+
+	return res;
+}
+
+
+/*
+This function executes a bound statement from the statements cache, right away
+input: the statement
+output: true if the statement was executed successfully, false otherwise
+*/
+bool DatabaseAccess::executeStatement(sqlite3_stmt* statement)
+{
+	if (nullptr == statement) {
+		return false;
+	}
+
+	int res = sqlite3_step(statement);
+	sqlite3_reset(statement);
+
+	return res == SQLITE_DONE;
+}
+
+
+/*
+This function commits all the changes that were written behind.
+A commit that fails while the transaction is still open (the DB is busy) is retried. If it
+can't be committed, the changes are rolled back and the gallery is loaded again from the DB,
+so the gallery in memory doesn't keep changes that the DB lost.
+input: none
+output: none (throws MyException if the changes were lost)
+*/
+void DatabaseAccess::flush()
+{
+	if (!m_inTransaction) {
+		return;
+	}
+
+	bool committed = runSqlCommand("COMMIT;");
+	std::chrono::milliseconds delay = COMMIT_RETRY_DELAY;
+	for (int attempt = 1; !committed && attempt < COMMIT_ATTEMPTS && 0 == sqlite3_get_autocommit(db); ++attempt) {
+		std::this_thread::sleep_for(delay);
+		delay *= 2;
+		committed = runSqlCommand("COMMIT;");
+	}
+
+	m_inTransaction = false;
+	m_pendingChanges = 0;
+
+	if (!committed)
+	{
+		// sqlite may have rolled back the transaction by itself already
+		if (0 == sqlite3_get_autocommit(db)) {
+			runSqlCommand("ROLLBACK;");
+		}
+
+		if (!loadGallery()) {
+			throw MyException("Failed to commit changes to DB, and failed to load the gallery again");
+		}
+		throw MyException("Failed to commit changes to DB, the gallery was loaded again without them");
+	}
+}
+
+
+/*
+This function sets when the changes that were written behind are committed
+input: the max count of changes in one transaction, the max age of a transaction
+output: none
+*/
+void DatabaseAccess::setFlushPolicy(int flushSize, std::chrono::milliseconds flushInterval)
+{
+	m_flushSize = flushSize;
+	m_flushInterval = flushInterval;
+}
+
+
+/*
+This function sets whether the user statistics are answered by aggregate queries on the DB
+(using the secondary indexes) or by the gallery in memory
+input: true for the DB, false for the memory
+output: none
+*/
+void DatabaseAccess::setSqlStatistics(bool sqlStatistics)
+{
+	m_sqlStatistics = sqlStatistics;
+}
+
+
+/*
+This function runs a query from the statements cache that has integer or text parameters
+input: the sql statement, the parameters in order (extra ones are ignored), a function that is called with the statement on every result row
+output: true if the query ran successfully, false otherwise
+*/
+bool DatabaseAccess::runQuery(const std::string& sqlStatement, std::initializer_list<QueryParameter> parameters, const std::function<void(sqlite3_stmt*)>& onRow)
+{
+	std::lock_guard<std::mutex> lock(m_queryMutex);
+
+	sqlite3_stmt* statement = getStatement(sqlStatement);
+	if (nullptr == statement) {
+		return false;
+	}
+
+	int index = 1;
+	for (auto iter = parameters.begin(); iter != parameters.end() && index <= sqlite3_bind_parameter_count(statement); ++iter, ++index) {
+		if (iter->text) {
+			sqlite3_bind_text(statement, index, iter->text->c_str(), -1, SQLITE_TRANSIENT);
+		}
+		else {
+			sqlite3_bind_int64(statement, index, iter->number);
+		}
+	}
+
+	int res = SQLITE_ROW;
+	while ((res = sqlite3_step(statement)) == SQLITE_ROW) {
+		onRow(statement);
+	}
+	sqlite3_reset(statement);
+
+	return res == SQLITE_DONE;
+}
+
+
+/*
+This function runs a COUNT query from the statements cache that has one integer parameter
+input: the sql statement, the parameter
+output: the count
+*/
+int DatabaseAccess::queryCount(const std::string& sqlStatement, int parameter)
+{
+	int count = 0;
+
+	if (!runQuery(sqlStatement, { parameter }, [&count](sqlite3_stmt* statement) { count = sqlite3_column_int(statement, 0); }))
+	{
+		std::cout << "Failed to query DB" << std::endl;
+	}
+
+	return count;
+}
+
+
+/*
+This function runs a MAX(ID) query from the statements cache
+input: the sql statement
+output: the id
+*/
+int DatabaseAccess::queryLastId(const std::string& sqlStatement)
+{
+	int lastId = 0;
+
+	if (!runQuery(sqlStatement, {}, [&lastId](sqlite3_stmt* statement) { lastId = sqlite3_column_int(statement, 0); }))
+	{
+		throw MyException("Failed to query DB");
+	}
+
+	return lastId;
+}
+
+
+/*
+This function sets the lazy loading mode (it takes effect on the next open()).
+Only the album headers are kept in memory, an album's pictures and tags are loaded from the DB
+when it is opened and kept in a cache of the given capacity - the least recently used album is
+evicted when a new one is loaded into a full cache. The album headers of getAlbums(),
+getAlbumsOfUser() and the snapshots hold no pictures, and the statistics and queries are
+answered by the DB (see setSqlStatistics).
+input: the capacity of the albums cache, 0 to load the whole gallery into memory
+output: none
+*/
+void DatabaseAccess::setLazyLoading(size_t albumsCacheCapacity)
+{
+	m_lazyLoading = albumsCacheCapacity > 0;
+	m_albumsCache.setCapacity(albumsCacheCapacity);
+
+	if (m_lazyLoading) {
+		m_sqlStatistics = true;
+	}
+}
+
+
+const AlbumsCache& DatabaseAccess::getAlbumsCache() const
+{
+	return m_albumsCache;
+}
+
 
-	delete[] command;
-	return flag;
+/*
+This function returns the most tagged users by an aggregate query on the DB
+input: the count of users
+output: the users, the most tagged first
+*/
+std::list<User> DatabaseAccess::queryTopTaggedUsers(int count)
+{
+	// same order as the tagged users ranking - the most tags first, the bigger id first on a tie
+	const char* sqlStatement = "SELECT USERS.ID, USERS.NAME FROM TAGS JOIN USERS ON USERS.ID = TAGS.USER_ID "
+		"GROUP BY TAGS.USER_ID ORDER BY COUNT(DISTINCT TAGS.PICTURE_ID) DESC, TAGS.USER_ID DESC LIMIT ?;";
+	std::list<User> users;
+
+	if (!runQuery(sqlStatement, { count }, [&users](sqlite3_stmt* statement) {
+		users.emplace_back(sqlite3_column_int(statement, 0), columnText(statement, 1));
+	}))
+	{
+		std::cout << "Failed to query DB" << std::endl;
+	}
+
+	return users;
+}
+
+
+/*
+This function returns the pictures a query selects, with their tags
+input: a query that selects the PICTURE_FIELDS of pictures, its parameters
+output: the pictures
+*/
+std::list<Picture> DatabaseAccess::queryPictures(const std::string& sqlStatement, std::initializer_list<QueryParameter> parameters)
+{
+	std::list<Picture> pictures;
+
+	bool success = runQuery(sqlStatement, parameters, [&pictures](sqlite3_stmt* statement) {
+		pictures.push_back(columnPicture(statement));
+	});
+
+	for (Picture& picture : pictures) {
+		success = success && runQuery("SELECT USER_ID FROM TAGS WHERE PICTURE_ID = ?;", { picture.getId() }, [&picture](sqlite3_stmt* statement) {
+			picture.tagUser(sqlite3_column_int(statement, 0));
+		});
+	}
+
+	if (!success) {
+		std::cout << "Failed to query DB" << std::endl;
+	}
+
+	return pictures;
 }
 
 
 void DatabaseAccess::clear()
 {
+	invalidateSnapshot();
+
+	m_albumsCache.clear();
+	m_index.clear();
 	m_users.clear();
 	m_albums.clear();
 }
@@ -87,211 +857,513 @@ void DatabaseAccess::dropTables()
 	sqlite3_exec(db, "DROP TABLE USERS;", nullptr, nullptr, nullptr);
 	sqlite3_exec(db, "DROP TABLE ALBUMS;", nullptr, nullptr, nullptr);
 	sqlite3_exec(db, "DROP TABLE PICTURES;", nullptr, nullptr, nullptr);
+	sqlite3_exec(db, "DROP TABLE PICTURE_METADATA;", nullptr, nullptr, nullptr);
 	sqlite3_exec(db, "DROP TABLE TAGS;", nullptr, nullptr, nullptr);
+	sqlite3_exec(db, "DROP TABLE SNAPSHOT_STAMP;", nullptr, nullptr, nullptr);
+}
+
+
+auto DatabaseAccess::getAlbumIfExists(const std::string& albumName, int ownerId)
+{
+	auto result = m_index.findAlbum(albumName, ownerId);
+
+	if (result == std::end(m_albums)) {
+		throw ItemNotFoundException("Album not exists: ", albumName);
+	}
+
+	return result;
 }
 
 
-auto DatabaseAccess::getAlbumIfExists(const std::string& albumName)
+DatabaseAccess::DatabaseAccess() :
+	m_index(m_albums, m_users)
+{
+	this->dbFileName = "MyDB.sqlite";
+	this->snapshotFileName = "MyDB.snapshot";
+}
+
+
+std::list<Album> DatabaseAccess::getAlbums()
+{
+	return m_albums;
+}
+
+
+std::list<Album> DatabaseAccess::getAlbumsOfUser(const User& user)
+{
+	std::list<Album> albumsOfUser;
+	for (auto album : m_index.findAlbumsOfUser(user.getId())) {
+		albumsOfUser.push_back(*album);
+	}
+	return albumsOfUser;
+}
+
+
+void DatabaseAccess::createAlbum(const Album& album)
+{
+	invalidateSnapshot();
+
+	sqlite3_stmt* statement = getStatement("INSERT INTO ALBUMS (NAME, CREATION_DATE, USER_ID) VALUES (?, ?, ?);");
+	if (statement) {
+		sqlite3_bind_text(statement, 1, album.getName().c_str(), -1, SQLITE_TRANSIENT);
+		sqlite3_bind_int64(statement, 2, album.getCreationTime());
+		sqlite3_bind_int(statement, 3, album.getOwnerId());
+	}
+
+	if (runStatement(statement))
+	{
+		// the album id is given by the DB
+		m_albums.push_back(album);
+		m_albums.back().setId(static_cast<int>(sqlite3_last_insert_rowid(db)));
+		m_index.addAlbum(std::prev(m_albums.end()));
+	}
+	else
+	{
+		std::cout << "Failed to create album" << std::endl;
+	}
+}
+
+
+/*
+This function creates albums together with their pictures, all in one transaction.
+The albums get their ids from the DB, the pictures keep the ids they were given (like a picture
+that is added to an album) - so the import fails if one of the ids is taken.
+input: the albums
+output: none (throws MyException if the albums weren't imported)
+*/
+void DatabaseAccess::importAlbums(const std::list<Album>& albums)
+{
+	invalidateSnapshot();
+
+	// the import runs in its own transaction, so the changes written behind go first
+	flush();
+
+	bool success = runSqlCommand("BEGIN;");
+	dropSnapshotStamp();
+
+	sqlite3_stmt* albumStatement = success ? getStatement("INSERT INTO ALBUMS (NAME, CREATION_DATE, USER_ID) VALUES (?, ?, ?);") : nullptr;
+	sqlite3_stmt* pictureStatement = success ? getStatement("INSERT INTO PICTURES (ID, NAME, LOCATION, CREATION_DATE, ALBUM_ID, CONTENT_HASH, PERCEPTUAL_HASH, WIDTH, HEIGHT, FORMAT, FILE_SIZE) "
+		"VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);") : nullptr;
+	sqlite3_stmt* metadataStatement = success ? getStatement("INSERT INTO PICTURE_METADATA (PICTURE_ID, CAPTURE_TIME, CAMERA_MODEL, LATITUDE, LONGITUDE) VALUES (?, ?, ?, ?, ?);") : nullptr;
+	std::list<Album> importedAlbums;
+
+	for (auto album = albums.begin(); success && album != albums.end(); ++album) {
+		sqlite3_bind_text(albumStatement, 1, album->getName().c_str(), -1, SQLITE_TRANSIENT);
+		sqlite3_bind_int64(albumStatement, 2, album->getCreationTime());
+		sqlite3_bind_int(albumStatement, 3, album->getOwnerId());
+		success = success && executeStatement(albumStatement);
+
+		importedAlbums.emplace_back(album->getOwnerId(), album->getName(), album->getCreationTime());
+		Album& importedAlbum = importedAlbums.back();
+		importedAlbum.setId(static_cast<int>(sqlite3_last_insert_rowid(db)));
+		// in lazy loading mode only the album header is kept, its pictures are loaded on demand
+		if (!m_lazyLoading) {
+			importedAlbum.reservePictures(album->getPictures().size());
+		}
+
+		// reused for every picture
+		std::string path;
+
+		for (auto picture = album->getPictures().begin(); success && picture != album->getPictures().end(); ++picture) {
+			path = picture->getPath();
+			sqlite3_bind_int(pictureStatement, 1, picture->getId());
+			sqlite3_bind_text(pictureStatement, 2, picture->getName().c_str(), -1, SQLITE_TRANSIENT);
+			sqlite3_bind_text(pictureStatement, 3, path.c_str(), -1, SQLITE_STATIC);
+			sqlite3_bind_int64(pictureStatement, 4, picture->getCreationTime());
+			sqlite3_bind_int(pictureStatement, 5, importedAlbum.getId());
+			bindPictureDetails(pictureStatement, 6, *picture);
+			success = success && executeStatement(pictureStatement);
+
+			// only the pictures that have metadata have a row
+			if (success && !picture->getMetadata().isEmpty()) {
+				bindPictureMetadata(metadataStatement, picture->getId(), picture->getMetadata());
+				success = executeStatement(metadataStatement);
+			}
+
+			if (!m_lazyLoading) {
+				importedAlbum.addPicture(*picture);
+			}
+		}
+	}
+
+	if (!(success && runSqlCommand("COMMIT;")))
+	{
+		runSqlCommand("ROLLBACK;");
+		// nothing was imported - the caller must not report the pictures as imported
+		throw MyException("Failed to import albums");
+	}
+
+	for (Album& importedAlbum : importedAlbums) {
+		m_albums.push_back(std::move(importedAlbum));
+		m_index.addAlbum(std::prev(m_albums.end()));
+	}
+}
+
+
+void DatabaseAccess::deleteAlbum(const std::string& albumName, int userId)
+{
+	invalidateSnapshot();
+
+	auto album = m_index.findAlbum(albumName, userId);
+	if (album == m_albums.end()) {
+		return;
+	}
+	// read before the pictures are deleted from the DB
+	std::vector<Picture> indexedPictures = getIndexedPictures(album);
+
+	const std::string deleteAlbumSql[] = {
+		"DELETE FROM TAGS WHERE PICTURE_ID IN (SELECT ID FROM PICTURES WHERE ALBUM_ID = ?);",
+		"DELETE FROM PICTURE_METADATA WHERE PICTURE_ID IN (SELECT ID FROM PICTURES WHERE ALBUM_ID = ?);",
+		"DELETE FROM PICTURES WHERE ALBUM_ID = ?;",
+		"DELETE FROM ALBUMS WHERE ID = ?;"
+	};
+	bool success = true;
+
+	for (const auto& sql : deleteAlbumSql) {
+		sqlite3_stmt* statement = getStatement(sql);
+		if (statement) {
+			sqlite3_bind_int(statement, 1, album->getId());
+		}
+		success = success && runStatement(statement);
+	}
+
+	if (success)
+	{
+		removeAlbumFromGallery(album, indexedPictures);
+	}
+	else
+	{
+		std::cout << "Failed to delete album" << std::endl;
+	}
+}
+
+
+/*
+This function returns the pictures of an album that the index may hold entries of, besides
+the pictures of the album header. In lazy loading mode the header holds no pictures, while the index
+holds the pictures that were added or tagged since the gallery was loaded (also of albums that were
+evicted from the cache since) - so the pictures are taken from the cached album, or read from the DB.
+input: the album (header)
+output: the pictures (none if the gallery is loaded into memory)
+*/
+std::vector<Picture> DatabaseAccess::getIndexedPictures(std::list<Album>::iterator album)
 {
-	auto result = std::find_if(std::begin(m_albums), std::end(m_albums), [&](auto& album) { return album.getName() == albumName; });
-
-	if (result == std::end(m_albums)) {
-		throw ItemNotFoundException("Album not exists: ", albumName);
+	if (!m_lazyLoading) {
+		return std::vector<Picture>();
 	}
 
-	return result;
+	Album* cachedAlbum = m_albumsCache.find(album->getId());
+	return cachedAlbum ? cachedAlbum->getPictures() : queryAlbumPictures(*album);
 }
 
 
-DatabaseAccess::DatabaseAccess()
+/*
+This function removes an album, with the index entries of its pictures, from the gallery in memory
+input: the album (header), the pictures of the album that aren't in its header (see getIndexedPictures)
+output: none
+*/
+void DatabaseAccess::removeAlbumFromGallery(std::list<Album>::iterator album, const std::vector<Picture>& indexedPictures)
 {
-	this->dbFileName = "MyDB.sqlite";
+	for (const Picture& picture : indexedPictures) {
+		m_index.removePicture(album->getId(), picture);
+	}
+
+	m_albumsCache.erase(album->getId());
+	m_index.removeAlbum(album);
+	m_albums.erase(album);
 }
 
 
-const std::list<Album> DatabaseAccess::getAlbums()
+bool DatabaseAccess::doesAlbumExists(const std::string& albumName, int userId)
 {
-	return m_albums;
+	return m_index.findAlbum(albumName, userId) != m_albums.end();
 }
 
 
-std::list<Album> DatabaseAccess::getAlbumsOfUser(const User& user)
+Album DatabaseAccess::openAlbum(const std::string& albumName, int userId)
 {
-	std::list<Album> albumsOfUser;
-	for (const auto& album : m_albums) {
-		if (album.getOwnerId() == user.getId()) {
-			albumsOfUser.push_back(album);
-		}
+	auto album = m_index.findAlbum(albumName, userId);
+	if (album == m_albums.end()) {
+		throw MyException("No album with name " + albumName + " of user @" + std::to_string(userId) + " exists");
 	}
-	return albumsOfUser;
+
+	return getLoadedAlbum(album);
 }
 
 
-void DatabaseAccess::createAlbum(const Album& album)
+/*
+This function returns an album with all its pictures and tags.
+In lazy loading mode the album headers hold no pictures - the whole album is taken from
+the albums cache, and loaded into it from the DB if it is not there.
+input: the album (header)
+output: the whole album
+*/
+Album& DatabaseAccess::getLoadedAlbum(std::list<Album>::iterator album)
 {
-	std::string strCommand = "INSERT INTO ALBUMS VALUES (" + std::to_string(album.getId()) + ", \"" + album.getName() + "\", \"" + album.getCreationDate() + "\", " + std::to_string(album.getOwnerId()) + ");";
-
-	if (runSqlCommand(strCommand))
-	{
-		m_albums.push_back(album);
-	}
-	else
-	{
-		std::cout << "Failed to create album" << std::endl;
+	if (!m_lazyLoading) {
+		return *album;
 	}
-}
 
-
-void DatabaseAccess::deleteAlbum(const std::string& albumName, int userId)
-{
-	for (auto iter = m_albums.begin(); iter != m_albums.end(); iter++) {
-		if (iter->getName() == albumName && iter->getOwnerId() == userId)
-		{
-			std::string strCommand = "DELETE FROM ALBUMS WHERE NAME = \"" + albumName + "\";";
-			
-			if (runSqlCommand(strCommand))
-			{
-				iter = m_albums.erase(iter);
-			}
-			else
-			{
-				std::cout << "Failed to delete album" << std::endl;
-			}
-			
-			return;
-		}
+	Album* cachedAlbum = m_albumsCache.find(album->getId());
+	if (cachedAlbum) {
+		return *cachedAlbum;
 	}
-}
 
+	// from the snapshot file while it matches the DB
+	Album loadedAlbum = *album;
+	size_t snapshotAlbum = m_snapshotFile.isOpen() ? m_snapshotFile.findAlbum(album->getId()) : SnapshotFile::NOT_FOUND;
 
-bool DatabaseAccess::doesAlbumExists(const std::string& albumName, int userId)
-{
-	for (const auto& album : m_albums) {
-		if ((album.getName() == albumName) && (album.getOwnerId() == userId)) {
-			return true;
+	if (SnapshotFile::NOT_FOUND == snapshotAlbum || !m_snapshotFile.readPictures(snapshotAlbum, loadedAlbum))
+	{
+		loadedAlbum = *album;
+		std::vector<Picture> pictures = queryAlbumPictures(*album);
+
+		loadedAlbum.reservePictures(pictures.size());
+		for (Picture& loadedPicture : pictures) {
+			loadedAlbum.addPicture(std::move(loadedPicture));
 		}
 	}
 
-	return false;
+	return m_albumsCache.insert(std::move(loadedAlbum));
 }
 
 
-Album DatabaseAccess::openAlbum(const std::string& albumName)
+/*
+This function reads the pictures of an album, with their tags, from the DB
+input: the album
+output: the pictures, ordered by id
+*/
+std::vector<Picture> DatabaseAccess::queryAlbumPictures(const Album& album)
 {
-	for (auto& album : m_albums) {
-		if (albumName == album.getName()) {
-			return album;
+	std::vector<Picture> pictures;
+	size_t picture = 0;
+
+	bool success = runQuery("SELECT " + PICTURE_FIELDS + " FROM PICTURES" + PICTURE_METADATA_JOIN + " WHERE ALBUM_ID = ? ORDER BY ID;", { album.getId() }, [&pictures](sqlite3_stmt* statement) {
+		pictures.push_back(columnPicture(statement));
+	});
+
+	// both are ordered by picture id
+	success = success && runQuery("SELECT TAGS.PICTURE_ID, TAGS.USER_ID FROM TAGS JOIN PICTURES ON PICTURES.ID = TAGS.PICTURE_ID WHERE PICTURES.ALBUM_ID = ? ORDER BY TAGS.PICTURE_ID;", { album.getId() }, [&](sqlite3_stmt* statement) {
+		int pictureId = sqlite3_column_int(statement, 0);
+		while (picture < pictures.size() && pictures[picture].getId() < pictureId) {
+			++picture;
+		}
+		if (picture < pictures.size() && pictures[picture].getId() == pictureId) {
+			pictures[picture].tagUser(sqlite3_column_int(statement, 1));
 		}
+	});
+
+	if (!success) {
+		throw MyException("Failed to load album " + album.getName() + " from DB");
 	}
-	throw MyException("No album with name " + albumName + " exists");
+
+	return pictures;
 }
 
 
-void DatabaseAccess::addPictureToAlbumByName(const std::string& albumName, const Picture& picture)
+void DatabaseAccess::addPictureToAlbumByName(const std::string& albumName, int ownerId, const Picture& picture)
 {
+	invalidateSnapshot();
+
 	try
 	{
-		auto result = getAlbumIfExists(albumName);
+		auto result = getAlbumIfExists(albumName, ownerId);
+		Album& album = getLoadedAlbum(result);
+
+		sqlite3_stmt* statement = getStatement("INSERT INTO PICTURES (ID, NAME, LOCATION, CREATION_DATE, ALBUM_ID, CONTENT_HASH, PERCEPTUAL_HASH, WIDTH, HEIGHT, FORMAT, FILE_SIZE) "
+			"VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
+		if (statement) {
+			sqlite3_bind_int(statement, 1, picture.getId());
+			sqlite3_bind_text(statement, 2, picture.getName().c_str(), -1, SQLITE_TRANSIENT);
+			sqlite3_bind_text(statement, 3, picture.getPath().c_str(), -1, SQLITE_TRANSIENT);
+			sqlite3_bind_int64(statement, 4, picture.getCreationTime());
+			sqlite3_bind_int(statement, 5, result->getId());
+			bindPictureDetails(statement, 6, picture);
+		}
+		bool success = runStatement(statement);
 
-		std::string strCommand = "INSERT INTO PICTURES VALUES (" + picture.getId() + std::string(", \"") + picture.getName() + std::string("\", \"") + picture.getPath() + std::string("\", \"") + picture.getCreationDate() + std::string("\", ") + std::to_string(result->getOwnerId()) + ");";
+		// only the pictures that have metadata have a row
+		if (success && !picture.getMetadata().isEmpty()) {
+			statement = getStatement("INSERT INTO PICTURE_METADATA (PICTURE_ID, CAPTURE_TIME, CAMERA_MODEL, LATITUDE, LONGITUDE) VALUES (?, ?, ?, ?, ?);");
+			if (statement) {
+				bindPictureMetadata(statement, picture.getId(), picture.getMetadata());
+			}
+			success = runStatement(statement);
+		}
 
-		if (runSqlCommand(strCommand))
+		if (success)
 		{
-			(*result).addPicture(picture);
+			album.addPicture(picture);
+			m_index.addPicture(result->getId(), picture);
 		}
 		else
 		{
-			std::cout << "Failed to delete add picture to album by name" << std::endl;
+			// the id may be taken already - the caller must not report the picture as added
+			throw MyException("Failed to add picture to album by name");
 		}
 	}
 
-	catch (std::exception& e)
+	catch (std::exception&)
 	{
-		throw e;
+		// rethrown as it is, so the message of a MyException isn't lost
+		throw;
 	}
 }
 
+/*
+This function returns the biggest picture id in the DB, so new pictures are given ids after it
+(the DB holds every picture, also those of albums that aren't loaded in lazy loading mode)
+input: none
+output: the id, 0 if there are no pictures
+*/
+int DatabaseAccess::getLastPictureId()
+{
+	return queryLastId("SELECT IFNULL(MAX(ID), 0) FROM PICTURES;");
+}
+
 
-void DatabaseAccess::removePictureFromAlbumByName(const std::string& albumName, const std::string& pictureName)
+void DatabaseAccess::removePictureFromAlbumByName(const std::string& albumName, int ownerId, const std::string& pictureName)
 {
+	invalidateSnapshot();
+
 	try
 	{
-		auto result = getAlbumIfExists(albumName);
+		auto result = getAlbumIfExists(albumName, ownerId);
+		Album& album = getLoadedAlbum(result);
+
+		const Picture& picture = album.getPicture(pictureName);
+		bool success = true;
 
-		std::string strCommand = "DELETE FROM PICTURES WHERE NAME = \"" + pictureName + "\");";
+		for (const auto& sql : { "DELETE FROM TAGS WHERE PICTURE_ID = ?;", "DELETE FROM PICTURE_METADATA WHERE PICTURE_ID = ?;", "DELETE FROM PICTURES WHERE ID = ?;" }) {
+			sqlite3_stmt* statement = getStatement(sql);
+			if (statement) {
+				sqlite3_bind_int(statement, 1, picture.getId());
+			}
+			success = success && runStatement(statement);
+		}
 
-		if (!(runSqlCommand(strCommand)))
+		if (!success)
 		{
 			std::cout << "Failed to remove picture from album by name" << std::endl;
 		}
 		else
 		{
-			(*result).removePicture(pictureName);
+			m_index.removePicture(result->getId(), picture);
+			album.removePicture(pictureName);
 		}
 	}
 
-	catch (std::exception& e)
+	catch (std::exception&)
 	{
-		throw e;
+		throw;
 	}
 }
 
 
-void DatabaseAccess::tagUserInPicture(const std::string& albumName, const std::string& pictureName, int userId)
+void DatabaseAccess::tagUserInPicture(const std::string& albumName, int ownerId, const std::string& pictureName, int userId)
 {
+	invalidateSnapshot();
+
 	try
 	{
-		auto result = getAlbumIfExists(albumName);
+		auto result = getAlbumIfExists(albumName, ownerId);
+		Album& album = getLoadedAlbum(result);
+
+		const Picture& picture = album.getPicture(pictureName);
+		if (picture.isUserTagged(userId)) {
+			return;
+		}
 
-		Picture picture = (*result).getPicture(pictureName);
-		std::string strCommand = "INSERT INTO TAGS (PICTURE_ID, USER_ID) VALUES (" + std::to_string(picture.getId()) + ", \"" + std::to_string(userId) + ");";
+		sqlite3_stmt* statement = getStatement("INSERT INTO TAGS (PICTURE_ID, USER_ID) VALUES (?, ?);");
+		if (statement) {
+			sqlite3_bind_int(statement, 1, picture.getId());
+			sqlite3_bind_int(statement, 2, userId);
+		}
 
-		if (!(runSqlCommand(strCommand)))
+		if (!(runStatement(statement)))
 		{
 			std::cout << "Failed to delete tag user in picture" << std::endl;
 		}
 		else
 		{
-			(*result).tagUserInPicture(userId, pictureName);
+			// the picture may have been moved by the change, so it is found again
+			album.tagUserInPicture(userId, pictureName);
+			m_index.addTag(userId, result->getId(), album.getPicture(pictureName).getId());
 		}
 	}
 
-	catch (std::exception& e)
+	catch (std::exception&)
 	{
-		throw e;
+		throw;
 	}
 }
 
 
-void DatabaseAccess::untagUserInPicture(const std::string& albumName, const std::string& pictureName, int userId)
+void DatabaseAccess::untagUserInPicture(const std::string& albumName, int ownerId, const std::string& pictureName, int userId)
 {
+	invalidateSnapshot();
+
 	try
 	{
-		auto result = getAlbumIfExists(albumName);
-
-		Picture picture = (*result).getPicture(pictureName);
-		std::string strCommand = "DELETE FROM TAGS WHERE PICTURE_ID = " + std::to_string(picture.getId()) + "AND USER_ID = " + std::to_string(userId) + ";";
+		auto result = getAlbumIfExists(albumName, ownerId);
+		Album& album = getLoadedAlbum(result);
+
+		const Picture& picture = album.getPicture(pictureName);
+		sqlite3_stmt* statement = getStatement("DELETE FROM TAGS WHERE PICTURE_ID = ? AND USER_ID = ?;");
+		if (statement) {
+			sqlite3_bind_int(statement, 1, picture.getId());
+			sqlite3_bind_int(statement, 2, userId);
+		}
 
-		if (!(runSqlCommand(strCommand)))
+		if (!(runStatement(statement)))
 		{
 			std::cout << "Failed to delete tag user in picture" << std::endl;
 		}
 		else
 		{
-			(*result).untagUserInPicture(userId, pictureName);
+			album.untagUserInPicture(userId, pictureName);
+			m_index.removeTag(userId, result->getId(), album.getPicture(pictureName).getId());
 		}
 	}
 
-	catch (std::exception& e)
+	catch (std::exception&)
 	{
-		throw e;
+		throw;
 	}
 }
 
 
-void DatabaseAccess::closeAlbum(Album&)
+void DatabaseAccess::closeAlbum(const Album&)
+{
+	// nothing to release, openAlbum hands out a copy of the stored album
+}
+
+
+/*
+This function returns a snapshot of the gallery as it is now.
+The snapshot is built once per version of the gallery and shared by all the readers of that version.
+input: none
+output: the snapshot
+*/
+std::shared_ptr<const GallerySnapshot> DatabaseAccess::getSnapshot()
+{
+	if (!m_snapshot) {
+		m_snapshot = std::make_shared<const GallerySnapshot>(m_version, m_albums, m_users);
+	}
+
+	return m_snapshot;
+}
+
+/*
+This function must be called before every change of the gallery. It drops the cached
+snapshot first, so albums that no reader holds anymore are changed in place and not copied.
+input: none
+output: none
+*/
+void DatabaseAccess::invalidateSnapshot()
 {
-	// basically here we would like to delete the allocated memory we got from openAlbum
+	m_snapshot.reset();
+	++m_version;
 }
 
 
@@ -309,68 +1381,77 @@ void DatabaseAccess::printUsers()
 
 
 User DatabaseAccess::getUser(int userId) {
-	for (const auto& user : m_users) {
-		if (user.getId() == userId) {
-			return user;
-		}
+	auto user = m_index.findUser(userId);
+	if (user == m_users.end()) {
+		throw ItemNotFoundException("User", userId);
 	}
 
-	throw ItemNotFoundException("User", userId);
+	return *user;
 }
 
 
 void DatabaseAccess::createUser(User& user)
 {
-	std::string strCommand = "INSERT INTO USERS VALUES (" + std::to_string(user.getId());
-	strCommand.append(", \"");
-	strCommand.append(user.getName() + "\");");
+	invalidateSnapshot();
 
-	if (runSqlCommand(strCommand))
+	sqlite3_stmt* statement = getStatement("INSERT INTO USERS (ID, NAME) VALUES (?, ?);");
+	if (statement) {
+		sqlite3_bind_int(statement, 1, user.getId());
+		sqlite3_bind_text(statement, 2, user.getName().c_str(), -1, SQLITE_TRANSIENT);
+	}
+
+	if (runStatement(statement))
 	{
 		m_users.push_back(user);
+		m_index.addUser(std::prev(m_users.end()));
 	}
 	else
 	{
-		std::cout << "Failed to create user" << std::endl;
+		// the id may be taken already - the caller must not report the user as created
+		throw MyException("Failed to create user");
 	}
 }
 
 
 void DatabaseAccess::deleteUser(const User& user)
 {
-	if (doesUserExists(user.getId())) {
+	invalidateSnapshot();
 
-		for (auto iter = m_users.begin(); iter != m_users.end(); ++iter) {
-			if (*iter == user) {
+	auto iter = m_index.findUser(user.getId());
+	if (iter == m_users.end()) {
+		return;
+	}
 
-				std::string strCommand = "DELETE FROM USERS WHERE ID = " + std::to_string(user.getId()) + ";";
+	sqlite3_stmt* statement = getStatement("DELETE FROM USERS WHERE ID = ?;");
+	if (statement) {
+		sqlite3_bind_int(statement, 1, user.getId());
+	}
 
-				if (runSqlCommand(strCommand))
-				{
-					iter = m_users.erase(iter);
-				}
-				else
-				{
-					std::cout << "Failed to remove picture from album by name" << std::endl;
-				}
-				
-				return;
-			}
-		}
+	if (runStatement(statement))
+	{
+		m_index.removeUser(iter);
+		m_users.erase(iter);
+	}
+	else
+	{
+		std::cout << "Failed to delete user" << std::endl;
 	}
 }
 
 
 bool DatabaseAccess::doesUserExists(int userId)
 {
-	auto iter = m_users.begin();
-	for (const auto& user : m_users) {
-		if (user.getId() == userId) {
-			return true;
-		}
-	}
+	return m_index.findUser(userId) != m_users.end();
+}
 
-	return false;
+/*
+This function returns the biggest user id in the DB, so new users are given ids after it
+input: none
+output: the id, 0 if there are no users
+*/
+int DatabaseAccess::getLastUserId()
+{
+	return queryLastId("SELECT IFNULL(MAX(ID), 0) FROM USERS;");
 }
 
 
@@ -389,9 +1470,9 @@ void DatabaseAccess::deleteUsersAlbums(const User& user)
 		}
 	}
 
-	catch (std::exception& e)
+	catch (std::exception&)
 	{
-		throw e;
+		throw;
 	}
 }
 
@@ -403,22 +1484,117 @@ output: none
 */
 void DatabaseAccess::deleteUserTags(const User& user)
 {
-	try
+	invalidateSnapshot();
+
+	sqlite3_stmt* statement = getStatement("DELETE FROM TAGS WHERE USER_ID = ?;");
+	if (statement) {
+		sqlite3_bind_int(statement, 1, user.getId());
+	}
+
+	if (!runStatement(statement))
 	{
-		for (const auto& album : m_albums) {
-			const std::list<Picture>& pics = album.getPictures();
+		std::cout << "Failed to delete user tags" << std::endl;
+		return;
+	}
 
-			for (const auto& picture : pics) {
-				if (picture.isUserTagged(user)) {
-					untagUserInPicture(album.getName(), picture.getName(), user.getId());
-				}
-			}
+	// copied, since the index entries are removed while iterating
+	const GalleryIndex::TaggedPictures taggedPictures = m_index.getTaggedPicturesOfUser(user.getId());
+	for (const auto& albumPictures : taggedPictures) {
+		auto album = m_index.findAlbum(albumPictures.first);
+
+		for (int pictureId : albumPictures.second) {
+			album->untagUserInPicture(user.getId(), pictureId);
+			m_index.removeTag(user.getId(), albumPictures.first, pictureId);
+		}
+	}
+	for (Album& album : m_albumsCache.getAlbums()) {
+		album.untagUserInAlbum(user.getId());
+	}
+}
+
+
+/*
+This function deletes a user together with everything related to it - the user's tags,
+the user's albums with their pictures and the tags of those pictures.
+The rows are removed by one set based statement per table, all in a single transaction,
+so either the whole user is gone or nothing was changed.
+input: the user
+output: none
+*/
+void DatabaseAccess::deleteUserCascade(const User& user)
+{
+	static const char* const cascade[] = {
+		"DELETE FROM TAGS WHERE USER_ID = ?;",
+		"DELETE FROM TAGS WHERE PICTURE_ID IN (SELECT PICTURES.ID FROM PICTURES JOIN ALBUMS ON PICTURES.ALBUM_ID = ALBUMS.ID WHERE ALBUMS.USER_ID = ?);",
+		"DELETE FROM PICTURE_METADATA WHERE PICTURE_ID IN (SELECT PICTURES.ID FROM PICTURES JOIN ALBUMS ON PICTURES.ALBUM_ID = ALBUMS.ID WHERE ALBUMS.USER_ID = ?);",
+		"DELETE FROM PICTURES WHERE ALBUM_ID IN (SELECT ID FROM ALBUMS WHERE USER_ID = ?);",
+		"DELETE FROM ALBUMS WHERE USER_ID = ?;",
+		"DELETE FROM USERS WHERE ID = ?;"
+	};
+
+	invalidateSnapshot();
+
+	// the cascade runs in its own transaction, so the changes written behind go first
+	flush();
+
+	// read before the pictures are deleted from the DB
+	std::map<int, std::vector<Picture>> indexedPictures;
+	for (auto album : m_index.findAlbumsOfUser(user.getId())) {
+		indexedPictures[album->getId()] = getIndexedPictures(album);
+	}
+
+	bool success = runSqlCommand("BEGIN;");
+	dropSnapshotStamp();
+	for (const char* sql : cascade) {
+		sqlite3_stmt* statement = success ? getStatement(sql) : nullptr;
+		if (statement) {
+			sqlite3_bind_int(statement, 1, user.getId());
 		}
+		success = success && executeStatement(statement);
 	}
 
-	catch (std::exception& e)
+	if (!(success && runSqlCommand("COMMIT;")))
 	{
-		throw e;
+		std::cout << "Failed to delete user" << std::endl;
+		runSqlCommand("ROLLBACK;");
+		return;
+	}
+
+	removeUserFromGallery(user, indexedPictures);
+}
+
+
+/*
+This function removes a user, its tags and its albums from the gallery in memory
+input: the user, the pictures of its albums that aren't in their headers by album id (see getIndexedPictures)
+output: none
+*/
+void DatabaseAccess::removeUserFromGallery(const User& user, const std::map<int, std::vector<Picture>>& indexedPictures)
+{
+	// copied, since the index entries are removed while iterating
+	const GalleryIndex::TaggedPictures taggedPictures = m_index.getTaggedPicturesOfUser(user.getId());
+	for (const auto& albumPictures : taggedPictures) {
+		auto album = m_index.findAlbum(albumPictures.first);
+
+		for (int pictureId : albumPictures.second) {
+			album->untagUserInPicture(user.getId(), pictureId);
+			m_index.removeTag(user.getId(), albumPictures.first, pictureId);
+		}
+	}
+	for (Album& album : m_albumsCache.getAlbums()) {
+		album.untagUserInAlbum(user.getId());
+	}
+
+	static const std::vector<Picture> noPictures;
+	for (auto album : m_index.findAlbumsOfUser(user.getId())) {
+		auto pictures = indexedPictures.find(album->getId());
+		removeAlbumFromGallery(album, pictures == indexedPictures.end() ? noPictures : pictures->second);
+	}
+
+	auto iter = m_index.findUser(user.getId());
+	if (iter != m_users.end()) {
+		m_index.removeUser(iter);
+		m_users.erase(iter);
 	}
 }
 
@@ -428,52 +1604,31 @@ void DatabaseAccess::deleteUserTags(const User& user)
 
 int DatabaseAccess::countAlbumsOwnedOfUser(const User& user)
 {
-	int albumsCount = 0;
-
-	for (const auto& album : m_albums) {
-		if (album.getOwnerId() == user.getId()) {
-			++albumsCount;
-		}
+	if (m_sqlStatistics) {
+		return queryCount("SELECT COUNT(*) FROM ALBUMS WHERE USER_ID = ?;", user.getId());
 	}
 
-	return albumsCount;
+	return m_index.countAlbumsOfUser(user.getId());
 }
 
 
 int DatabaseAccess::countAlbumsTaggedOfUser(const User& user)
 {
-	int albumsCount = 0;
-
-	for (const auto& album : m_albums) {
-		const std::list<Picture>& pics = album.getPictures();
-
-		for (const auto& picture : pics) {
-			if (picture.isUserTagged(user)) {
-				albumsCount++;
-				break;
-			}
-		}
+	if (m_sqlStatistics) {
+		return queryCount("SELECT COUNT(DISTINCT PICTURES.ALBUM_ID) FROM TAGS JOIN PICTURES ON PICTURES.ID = TAGS.PICTURE_ID WHERE TAGS.USER_ID = ?;", user.getId());
 	}
 
-	return albumsCount;
+	return m_index.countAlbumsTaggedOfUser(user.getId());
 }
 
 
 int DatabaseAccess::countTagsOfUser(const User& user)
 {
-	int tagsCount = 0;
-
-	for (const auto& album : m_albums) {
-		const std::list<Picture>& pics = album.getPictures();
-
-		for (const auto& picture : pics) {
-			if (picture.isUserTagged(user)) {
-				tagsCount++;
-			}
-		}
+	if (m_sqlStatistics) {
+		return queryCount("SELECT COUNT(DISTINCT PICTURE_ID) FROM TAGS WHERE USER_ID = ?;", user.getId());
 	}
 
-	return tagsCount;
+	return m_index.countTagsOfUser(user.getId());
 }
 
 
@@ -492,84 +1647,69 @@ float DatabaseAccess::averageTagsPerAlbumOfUser(const User& user)
 
 User DatabaseAccess::getTopTaggedUser()
 {
-	std::map<int, int> userTagsCountMap;
+	if (m_sqlStatistics)
+	{
+		std::list<User> topTaggedUsers = queryTopTaggedUsers(1);
 
-	auto albumsIter = m_albums.begin();
-	for (const auto& album : m_albums) {
-		for (const auto& picture : album.getPictures()) {
-			const std::set<int>& userTags = picture.getUserTags();
-			for (const auto& user : userTags) {
-				//As map creates default constructed values, 
-				//users which we haven't yet encountered will start from 0
-				userTagsCountMap[user]++;
-			}
+		if (topTaggedUsers.empty()) {
+			throw MyException("There isn't any tagged user.");
 		}
-	}
 
-	if (userTagsCountMap.size() == 0) {
-		throw MyException("There isn't any tagged user.");
+		return topTaggedUsers.front();
 	}
 
-	int topTaggedUser = -1;
-	int currentMax = -1;
-	for (auto entry : userTagsCountMap) {
-		if (entry.second < currentMax) {
-			continue;
-		}
-
-		topTaggedUser = entry.first;
-		currentMax = entry.second;
-	}
+	std::vector<int> topTaggedUsers = m_index.getTopTaggedUsers(1);
 
-	if (-1 == topTaggedUser) {
-		throw MyException("Failed to find most tagged user");
+	if (topTaggedUsers.empty()) {
+		throw MyException("There isn't any tagged user.");
 	}
 
-	if (!doesUserExists(topTaggedUser))
+	if (!doesUserExists(topTaggedUsers.front()))
 	{
 		throw MyException("The most tagged user is no longer exists");
 	}
 
-	return getUser(topTaggedUser);
+	return getUser(topTaggedUsers.front());
 }
 
 
 Picture DatabaseAccess::getTopTaggedPicture()
 {
-	int currentMax = -1;
-	const Picture* mostTaggedPic = nullptr;
-	for (const auto& album : m_albums) {
-		for (const Picture& picture : album.getPictures()) {
-			int tagsCount = picture.getTagsCount();
-			if (tagsCount == 0) {
-				continue;
-			}
-
-			if (tagsCount <= currentMax) {
-				continue;
-			}
+	if (m_sqlStatistics)
+	{
+		std::list<Picture> topTaggedPictures = getTopTaggedPictures(1);
 
-			mostTaggedPic = &picture;
-			currentMax = tagsCount;
+		if (topTaggedPictures.empty()) {
+			throw MyException("There isn't any tagged picture.");
 		}
+
+		return topTaggedPictures.front();
 	}
-	if (nullptr == mostTaggedPic) {
+
+	std::vector<GalleryIndex::PictureKey> topTaggedPictures = m_index.getTopTaggedPictures(1);
+
+	if (topTaggedPictures.empty()) {
 		throw MyException("There isn't any tagged picture.");
 	}
 
-	return *mostTaggedPic;
+	return m_index.findAlbum(topTaggedPictures.front().first)->getPicture(topTaggedPictures.front().second);
 }
 
 
 std::list<Picture> DatabaseAccess::getTaggedPicturesOfUser(const User& user)
 {
+	if (m_sqlStatistics) {
+		return queryPictures("SELECT " + PICTURE_FIELDS + " FROM TAGS JOIN PICTURES ON PICTURES.ID = TAGS.PICTURE_ID" + PICTURE_METADATA_JOIN + " "
+			"WHERE TAGS.USER_ID = ? GROUP BY PICTURES.ID ORDER BY PICTURES.ALBUM_ID, PICTURES.ID;", { user.getId() });
+	}
+
 	std::list<Picture> pictures;
 
-	for (const auto& album : m_albums) {
-		for (const auto& picture : album.getPictures()) {
-			if (picture.isUserTagged(user)) {
-				pictures.push_back(picture);
-			}
+	for (const auto& albumPictures : m_index.getTaggedPicturesOfUser(user.getId())) {
+		auto album = m_index.findAlbum(albumPictures.first);
+
+		for (int pictureId : albumPictures.second) {
+			pictures.push_back(album->getPicture(pictureId));
 		}
 	}
 
@@ -577,124 +1717,235 @@ std::list<Picture> DatabaseAccess::getTaggedPicturesOfUser(const User& user)
 }
 
 
-int DatabaseAccess::usersCallback(void* data, int argc, char** argv, char** azColName)
+std::list<User> DatabaseAccess::getTopTaggedUsers(int count)
 {
-	User user;
+	if (m_sqlStatistics) {
+		return queryTopTaggedUsers(count);
+	}
 
-	for (int i = 0; i < argc; i++) {
-		if (std::string(azColName[i]) == "ID") {
-			user.setId(atoi(argv[i]));
-		}
-		else if (std::string(azColName[i]) == "NAME") {
-			user.setName(argv[i]);
+	std::list<User> users;
+
+	for (int userId : m_index.getTopTaggedUsers(count)) {
+		// users that no longer exist are skipped
+		if (doesUserExists(userId)) {
+			users.push_back(getUser(userId));
 		}
 	}
 
-	this->m_users.push_back(user);
-	return 0;
+	return users;
 }
 
 
-int DatabaseAccess::albumsCallback(void* data, int argc, char** argv, char** azColName)
+std::list<Picture> DatabaseAccess::getTopTaggedPictures(int count)
 {
-	Album album;
+	if (m_sqlStatistics)
+	{
+		// same order as the tagged pictures ranking - the most tags first, then by album and picture id
+		return queryPictures("SELECT " + PICTURE_FIELDS + " FROM TAGS JOIN PICTURES ON PICTURES.ID = TAGS.PICTURE_ID" + PICTURE_METADATA_JOIN + " "
+			"GROUP BY TAGS.PICTURE_ID ORDER BY COUNT(DISTINCT TAGS.USER_ID) DESC, PICTURES.ALBUM_ID, PICTURES.ID LIMIT ?;", { count });
+	}
 
-	for (int i = 0; i < argc; i++) {
-		if (std::string(azColName[i]) == "NAME") {
-			album.setName(argv[i]);
-		}
-		else if (std::string(azColName[i]) == "CREATION_DATE") {
-			album.setCreationDate(argv[i]);
-		}
-		else if (std::string(azColName[i]) == "USER_ID") {
-			album.setOwner(atoi(argv[i]));
-		}
-		else if (std::string(azColName[i]) == "ID") {
-			album.setId(atoi(argv[i]));
-		}
+	std::list<Picture> pictures;
+
+	for (const auto& picture : m_index.getTopTaggedPictures(count)) {
+		pictures.push_back(m_index.findAlbum(picture.first)->getPicture(picture.second));
 	}
 
-	this->m_albums.push_back(album);
-	return 0;
+	return pictures;
 }
 
 
-int DatabaseAccess::picturesCallback(void* data, int argc, char** argv, char** azColName)
+/*
+This function returns the pictures created in a time range, the oldest one first
+input: the first and last creation times of the range (seconds since the epoch, both included)
+output: the pictures
+*/
+std::list<Picture> DatabaseAccess::getPicturesCreatedBetween(int64_t from, int64_t to)
 {
-	unsigned albumId = 0;
-	Picture pic;
+	if (m_sqlStatistics)
+	{
+		// a range scan of the PICTURES_CREATION_DATE index, same order as the gallery index
+		return queryPictures("SELECT " + PICTURE_FIELDS + " FROM PICTURES" + PICTURE_METADATA_JOIN + " WHERE CREATION_DATE BETWEEN ? AND ? "
+			"ORDER BY CREATION_DATE, ALBUM_ID, ID;", { from, to });
+	}
 
-	for (int i = 0; i < argc; i++) {
-		if (std::string(azColName[i]) == "NAME") {
-			pic.setName(argv[i]);
-		}
-		else if (std::string(azColName[i]) == "CREATION_DATE") {
-			pic.setCreationDate(argv[i]);
-		}
-		else if (std::string(azColName[i]) == "ALBUM_ID") {
-			albumId = atoi(argv[i]);
-		}
-		else if (std::string(azColName[i]) == "ID") {
-			pic.setId(atoi(argv[i]));
-		}
-		else if (std::string(azColName[i]) == "LOCATION") {
-			pic.setPath(argv[i]);
-		}
+	std::list<Picture> pictures;
+
+	for (const auto& picture : m_index.getPicturesCreatedBetween(from, to)) {
+		pictures.push_back(m_index.findAlbum(picture.first)->getPicture(picture.second));
 	}
 
-	try
+	return pictures;
+}
+
+/*
+This function returns the groups of pictures that have the same content (the same file, copied or added twice)
+input: none
+output: the pictures of every group, ordered by id
+*/
+std::list<std::list<Picture>> DatabaseAccess::getDuplicatePictures()
+{
+	std::list<std::list<Picture>> groups;
+
+	if (m_sqlStatistics)
 	{
-		auto result = getAlbumById(albumId);
-		result.addPicture(pic);
+		// the hashes that repeat are found on the PICTURES_CONTENT_HASH index, same order as the gallery index
+		std::list<Picture> pictures = queryPictures("SELECT " + PICTURE_FIELDS + " FROM PICTURES" + PICTURE_METADATA_JOIN + " "
+			"JOIN (SELECT CONTENT_HASH, MIN(ID) AS FIRST_ID FROM PICTURES WHERE CONTENT_HASH != 0 GROUP BY CONTENT_HASH HAVING COUNT(*) > 1) AS DUPLICATES "
+			"ON PICTURES.CONTENT_HASH = DUPLICATES.CONTENT_HASH ORDER BY DUPLICATES.FIRST_ID, PICTURES.ID;", {});
+
+		// the pictures of a group are one after the other
+		for (Picture& picture : pictures) {
+			if (groups.empty() || groups.back().front().getContentHash() != picture.getContentHash()) {
+				groups.emplace_back();
+			}
+			groups.back().push_back(std::move(picture));
+		}
+		return groups;
 	}
 
-	catch (std::exception& e)
+	return getPictureGroups(m_index.getDuplicatePictures());
+}
+
+/*
+This function returns the groups of pictures that look alike - pictures whose perceptual hashes
+differ in at most the given number of bits, or that are linked by a chain of such pictures
+input: the max distance (0 to 64 bits, about 10 finds resized or recompressed copies)
+output: the pictures of every group, ordered by id
+*/
+std::list<std::list<Picture>> DatabaseAccess::getSimilarPictures(int maxDistance)
+{
+	if (!m_sqlStatistics)
 	{
-		throw e;
+		return getPictureGroups(m_index.getSimilarPictures(maxDistance));
 	}
 
-	return 0;
-}
+	// SQL has no Hamming distance - only the hashes are read, into a hash index like the one of the gallery index
+	HammingIndex picturesByPerceptualHash;
+	std::list<std::list<Picture>> groups;
+
+	bool success = runQuery("SELECT ALBUM_ID, ID, PERCEPTUAL_HASH FROM PICTURES WHERE PERCEPTUAL_HASH != 0;", {}, [&picturesByPerceptualHash](sqlite3_stmt* statement) {
+		picturesByPerceptualHash.add(static_cast<uint64_t>(sqlite3_column_int64(statement, 2)),
+			HammingIndex::PictureKey(sqlite3_column_int(statement, 0), sqlite3_column_int(statement, 1)));
+	});
+	if (!success) {
+		std::cout << "Failed to query DB" << std::endl;
+		return groups;
+	}
+
+	for (const auto& group : picturesByPerceptualHash.findGroups(maxDistance)) {
+		groups.emplace_back();
+		for (const auto& picture : group) {
+			groups.back().splice(groups.back().end(), queryPictures("SELECT " + PICTURE_FIELDS + " FROM PICTURES" + PICTURE_METADATA_JOIN + " WHERE ID = ?;", { picture.second }));
+		}
+	}
 
+	return groups;
+}
 
-int DatabaseAccess::tagsCallback(void* data, int argc, char** argv, char** azColName)
+/*
+This function returns the pictures of an album that are larger than a size - wider or taller than it
+input: the album name, the id of its owner, the size in pixels
+output: the pictures, ordered by id (pictures whose header wasn't read have no size, and are left out)
+*/
+std::list<Picture> DatabaseAccess::getPicturesLargerThan(const std::string& albumName, int ownerId, int pixels)
 {
-	int userId = 0;
-	int picId = 0;
+	auto album = getAlbumIfExists(albumName, ownerId);
 
-	for (unsigned int i = 0; i < argc; i++) {
-		if (std::string(azColName[i]) == "USER_ID") {
-			userId = atoi(argv[i]);
-		}
-		
-		else if (std::string(azColName[i]) == "PICTURE_ID") {
-			picId = atoi(argv[i]);
+	if (m_sqlStatistics)
+	{
+		// the album's pictures are found on the PICTURES_ALBUM_ID index, an album is small enough to check all of them
+		return queryPictures("SELECT " + PICTURE_FIELDS + " FROM PICTURES" + PICTURE_METADATA_JOIN + " WHERE ALBUM_ID = ? AND MAX(WIDTH, HEIGHT) > ? ORDER BY ID;",
+			{ album->getId(), pixels });
+	}
+
+	std::list<Picture> pictures;
+
+	for (const Picture& picture : getLoadedAlbum(album).getPictures()) {
+		if (std::max(picture.getWidth(), picture.getHeight()) > pixels) {
+			pictures.push_back(picture);
 		}
 	}
 
-	// finding the picture in all the albums that the user owns
-	for (auto& currAlbum : getAlbumsOfUser(getUser(userId)))
+	return pictures;
+}
+
+/*
+This function returns the pictures taken in a time range (by their EXIF capture time), the oldest one first
+input: the first and last capture times of the range (seconds since the epoch, both included)
+output: the pictures (pictures with no capture time are left out)
+*/
+std::list<Picture> DatabaseAccess::getPicturesCapturedBetween(int64_t from, int64_t to)
+{
+	if (m_sqlStatistics)
+	{
+		// a range scan of the PICTURE_METADATA_CAPTURE_TIME index, same order as the gallery index
+		return queryPictures("SELECT " + PICTURE_FIELDS + " FROM PICTURE_METADATA JOIN PICTURES ON PICTURES.ID = PICTURE_METADATA.PICTURE_ID "
+			"WHERE CAPTURE_TIME BETWEEN ? AND ? AND CAPTURE_TIME != 0 ORDER BY CAPTURE_TIME, PICTURES.ALBUM_ID, PICTURES.ID;", { from, to });
+	}
+
+	std::list<Picture> pictures;
+
+	for (const auto& picture : m_index.getPicturesCapturedBetween(from, to)) {
+		pictures.push_back(m_index.findAlbum(picture.first)->getPicture(picture.second));
+	}
+
+	return pictures;
+}
+
+/*
+This function returns the pictures taken with a camera, the oldest one first
+input: the camera model (case insensitive)
+output: the pictures
+*/
+std::list<Picture> DatabaseAccess::getPicturesOfCamera(const std::string& cameraModel)
+{
+	if (cameraModel.empty()) {
+		return std::list<Picture>();
+	}
+
+	if (m_sqlStatistics)
 	{
-		for (auto& currPic : currAlbum.getPictures())
-		{
-			if (currPic.getId() == picId)
-			{
-				currAlbum.tagUserInPicture(userId, currPic.getName());
-			}
-			break;
+		// a lookup on the PICTURE_METADATA_CAMERA_MODEL index, which is ordered by capture time too - same order as the gallery index
+		return queryPictures("SELECT " + PICTURE_FIELDS + " FROM PICTURE_METADATA JOIN PICTURES ON PICTURES.ID = PICTURE_METADATA.PICTURE_ID "
+			"WHERE CAMERA_MODEL = ? ORDER BY CAPTURE_TIME, PICTURES.ALBUM_ID, PICTURES.ID;", { cameraModel });
+	}
+
+	std::list<Picture> pictures;
+
+	for (const auto& picture : m_index.getPicturesOfCamera(cameraModel)) {
+		pictures.push_back(m_index.findAlbum(picture.first)->getPicture(picture.second));
+	}
+
+	return pictures;
+}
+
+/*
+This function turns groups of pictures of the gallery index into the pictures themselves
+input: (album id, picture id) of the pictures of every group
+output: the pictures of every group, in the same order
+*/
+std::list<std::list<Picture>> DatabaseAccess::getPictureGroups(const std::vector<std::vector<GalleryIndex::PictureKey>>& pictureGroups)
+{
+	std::list<std::list<Picture>> groups;
+
+	for (const auto& group : pictureGroups) {
+		groups.emplace_back();
+		for (const auto& picture : group) {
+			groups.back().push_back(m_index.findAlbum(picture.first)->getPicture(picture.second));
 		}
 	}
 
-	return 0;
+	return groups;
 }
 
+
 Album DatabaseAccess::getAlbumById(const int albumId)
 {
-	for (auto& currAlbum : m_albums) {
-		if (currAlbum.getId() == albumId) {
-			return currAlbum;
-		}
+	auto album = m_index.findAlbum(albumId);
+	if (album == m_albums.end()) {
+		throw ItemNotFoundException("Album", albumId);
 	}
 
-	throw ItemNotFoundException("Album", albumId);
+	return getLoadedAlbum(album);
 }
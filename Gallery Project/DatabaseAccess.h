@@ -1,8 +1,17 @@
 #pragma once
+#include <chrono>
+#include <functional>
 #include <list>
+#include <map>
+#include <mutex>
+#include <unordered_map>
 #include "Album.h"
 #include "User.h"
 #include "IDataAccess.h"
+#include "GalleryIndex.h"
+#include "GallerySnapshot.h"
+#include "AlbumsCache.h"
+#include "SnapshotFile.h"
 #include <stdio.h>
 
 class DatabaseAccess : public IDataAccess
@@ -13,30 +22,35 @@ public:
 	virtual ~DatabaseAccess() = default;
 
 	// album related
-	const std::list<Album> getAlbums() override;
+	std::list<Album> getAlbums() override;
 	std::list<Album> getAlbumsOfUser(const User& user) override;
 	void createAlbum(const Album& album) override;
+	void importAlbums(const std::list<Album>& albums) override;
 	void deleteAlbum(const std::string& albumName, int userId) override;
 	bool doesAlbumExists(const std::string& albumName, int userId) override;
-	Album openAlbum(const std::string& albumName) override;
+	Album openAlbum(const std::string& albumName, int userId) override;
 	Album getAlbumById(const int albumId) override;
-	void closeAlbum(Album& pAlbum) override;
+	void closeAlbum(const Album& pAlbum) override;
 	void printAlbums() override;
+	std::shared_ptr<const GallerySnapshot> getSnapshot() override;
 
 	// picture related
-	void addPictureToAlbumByName(const std::string& albumName, const Picture& picture) override;
-	void removePictureFromAlbumByName(const std::string& albumName, const std::string& pictureName) override;
-	void tagUserInPicture(const std::string& albumName, const std::string& pictureName, int userId) override;
-	void untagUserInPicture(const std::string& albumName, const std::string& pictureName, int userId) override;
+	void addPictureToAlbumByName(const std::string& albumName, int ownerId, const Picture& picture) override;
+	void removePictureFromAlbumByName(const std::string& albumName, int ownerId, const std::string& pictureName) override;
+	void tagUserInPicture(const std::string& albumName, int ownerId, const std::string& pictureName, int userId) override;
+	void untagUserInPicture(const std::string& albumName, int ownerId, const std::string& pictureName, int userId) override;
+	int getLastPictureId() override;
 
 	// user related
 	void printUsers() override;
 	void createUser(User& user) override;
 	void deleteUser(const User& user) override;
 	bool doesUserExists(int userId) override;
+	int getLastUserId() override;
 	User getUser(int userId) override;
 	void deleteUsersAlbums(const User& user) override;
 	void deleteUserTags(const User& user) override;
+	void deleteUserCascade(const User& user) override;
 
 	// user statistics
 	int countAlbumsOwnedOfUser(const User& user) override;
@@ -48,25 +62,94 @@ public:
 	User getTopTaggedUser() override;
 	Picture getTopTaggedPicture() override;
 	std::list<Picture> getTaggedPicturesOfUser(const User& user) override;
-
-	// callback functions
-	int usersCallback(void* data, int argc, char** argv, char** azColName) override;
-	int albumsCallback(void* data, int argc, char** argv, char** azColName) override;
-	int picturesCallback(void* data, int argc, char** argv, char** azColName) override;
-	int tagsCallback(void* data, int argc, char** argv, char** azColName) override;
+	std::list<User> getTopTaggedUsers(int count) override;
+	std::list<Picture> getTopTaggedPictures(int count) override;
+	std::list<Picture> getPicturesCreatedBetween(int64_t from, int64_t to) override;
+	std::list<std::list<Picture>> getDuplicatePictures() override;
+	std::list<std::list<Picture>> getSimilarPictures(int maxDistance) override;
+	std::list<Picture> getPicturesLargerThan(const std::string& albumName, int ownerId, int pixels) override;
+	std::list<Picture> getPicturesCapturedBetween(int64_t from, int64_t to) override;
+	std::list<Picture> getPicturesOfCamera(const std::string& cameraModel) override;
 
 	bool open() override;
 	void close() override;
 	void clear() override;
+	void flush() override;
+	bool saveSnapshot() override;
+	void setFlushPolicy(int flushSize, std::chrono::milliseconds flushInterval);
+	void setSqlStatistics(bool sqlStatistics);
+	void setLazyLoading(size_t albumsCacheCapacity);
+	const AlbumsCache& getAlbumsCache() const;
 	bool runSqlCommand(std::string sqlStatement) override;
 	void dropTables() override;
 
 private:
+	// a parameter of runQuery() - an integer, or a text (which must outlive the call)
+	struct QueryParameter
+	{
+		QueryParameter(sqlite3_int64 number) : number(number) {}
+		QueryParameter(const std::string& text) : text(&text) {}
+
+		sqlite3_int64 number { 0 };
+		const std::string* text { nullptr };
+	};
+
 	std::list<Album> m_albums;
 	std::list<User> m_users;
+	GalleryIndex m_index;
+	std::shared_ptr<const GallerySnapshot> m_snapshot;
+	unsigned long long m_version { 0 };
 	sqlite3* db;
 	std::string dbFileName;
+	std::unordered_map<std::string, sqlite3_stmt*> m_statements;
+
+	// write behind
+	bool m_inTransaction { false };
+	int m_pendingChanges { 0 };
+	int m_flushSize { 1000 };
+	std::chrono::milliseconds m_flushInterval { 1000 };
+	std::chrono::steady_clock::time_point m_transactionStartTime;
+
+	// statistics answered by the DB instead of the gallery in memory
+	bool m_sqlStatistics { false };
+	// queries may run from several threads at once (see ConcurrentAccess), they take turns on the statements cache
+	std::mutex m_queryMutex;
+
+	// lazy loading - only the album headers are kept in m_albums, whole albums are loaded on demand into the cache
+	bool m_lazyLoading { false };
+	AlbumsCache m_albumsCache;
+
+	// snapshot file - loaded on open while the DB holds its stamp, the first change drops the stamp
+	std::string snapshotFileName;
+	SnapshotFile m_snapshotFile;
+	bool m_snapshotStamped { false };
 
-	auto getAlbumIfExists(const std::string& albumName);
+	auto getAlbumIfExists(const std::string& albumName, int ownerId);
+	void invalidateSnapshot();
+	bool migrateCreationDates();
+	bool addMissingColumns();
+	bool loadGallery();
+	bool loadSnapshot();
+	void dropSnapshotStamp();
+	static std::string columnText(sqlite3_stmt* statement, int column);
+	static void columnText(sqlite3_stmt* statement, int column, std::string& text);
+	static Picture columnPicture(sqlite3_stmt* statement);
+	static void columnPictureDetails(sqlite3_stmt* statement, Picture& picture);
+	static void bindPictureDetails(sqlite3_stmt* statement, int firstParameter, const Picture& picture);
+	static void bindPictureMetadata(sqlite3_stmt* statement, int pictureId, const ExifMetadata& metadata);
+	sqlite3_stmt* getStatement(const std::string& sqlStatement);
+	bool runStatement(sqlite3_stmt* statement);
+	bool executeStatement(sqlite3_stmt* statement);
+	bool runQuery(const std::string& sqlStatement, std::initializer_list<QueryParameter> parameters, const std::function<void(sqlite3_stmt*)>& onRow);
+	int queryCount(const std::string& sqlStatement, int parameter);
+	int queryLastId(const std::string& sqlStatement);
+	std::list<User> queryTopTaggedUsers(int count);
+	std::list<Picture> queryPictures(const std::string& sqlStatement, std::initializer_list<QueryParameter> parameters);
+	Album& getLoadedAlbum(std::list<Album>::iterator album);
+	std::vector<Picture> queryAlbumPictures(const Album& album);
+	std::vector<Picture> getIndexedPictures(std::list<Album>::iterator album);
+	void removeAlbumFromGallery(std::list<Album>::iterator album, const std::vector<Picture>& indexedPictures);
+	void removeUserFromGallery(const User& user, const std::map<int, std::vector<Picture>>& indexedPictures);
+	std::list<std::list<Picture>> getPictureGroups(const std::vector<std::vector<GalleryIndex::PictureKey>>& pictureGroups);
 	//void cleanUserData(const User& userId);
 };
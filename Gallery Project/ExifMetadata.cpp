@@ -0,0 +1,352 @@
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include "ExifMetadata.h"
+
+// the segments before the EXIF one are a few small ones (JFIF), a lot more is most likely a damaged file
+static const int MAX_JPEG_SEGMENTS = 64;
+// the identifier that starts the data of an EXIF segment, the TIFF structure follows it
+static const char EXIF_IDENTIFIER[] = { 'E', 'x', 'i', 'f', '\0', '\0' };
+
+// the TIFF tags that are read
+static const uint16_t TAG_MODEL = 0x0110;
+static const uint16_t TAG_DATE_TIME = 0x0132;
+static const uint16_t TAG_EXIF_IFD = 0x8769;
+static const uint16_t TAG_GPS_IFD = 0x8825;
+static const uint16_t TAG_DATE_TIME_ORIGINAL = 0x9003;
+static const uint16_t TAG_GPS_LATITUDE_REF = 0x0001;
+static const uint16_t TAG_GPS_LATITUDE = 0x0002;
+static const uint16_t TAG_GPS_LONGITUDE_REF = 0x0003;
+static const uint16_t TAG_GPS_LONGITUDE = 0x0004;
+
+// the TIFF types of the values that are read
+static const uint16_t TYPE_ASCII = 2;
+static const uint16_t TYPE_SHORT = 3;
+static const uint16_t TYPE_LONG = 4;
+static const uint16_t TYPE_RATIONAL = 5;
+
+static const uint32_t IFD_ENTRY_SIZE = 12;
+
+
+// reads the values of the TIFF structure of an EXIF segment, in its byte order, checking every offset against its size
+class ExifMetadata::TiffReader
+{
+public:
+	TiffReader(const unsigned char* data, size_t size, bool bigEndian) :
+		m_data(data), m_size(size), m_bigEndian(bigEndian)
+	{
+		// Left empty
+	}
+
+	bool read16(uint32_t offset, uint16_t& value) const
+	{
+		if (static_cast<uint64_t>(offset) + 2 > m_size) {
+			return false;
+		}
+		const unsigned char* bytes = m_data + offset;
+		value = m_bigEndian ? static_cast<uint16_t>((bytes[0] << 8) | bytes[1]) : static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+		return true;
+	}
+
+	bool read32(uint32_t offset, uint32_t& value) const
+	{
+		uint16_t first = 0, second = 0;
+		if (!read16(offset, first) || !read16(offset + 2, second)) {
+			return false;
+		}
+		value = m_bigEndian ? (static_cast<uint32_t>(first) << 16) | second : (static_cast<uint32_t>(second) << 16) | first;
+		return true;
+	}
+
+	// calls onEntry with the tag and the offset of every entry of an IFD (image file directory)
+	template <class OnEntry>
+	bool forEachEntry(uint32_t ifd, OnEntry onEntry) const
+	{
+		uint16_t entriesCount = 0;
+		if (!read16(ifd, entriesCount) || static_cast<uint64_t>(ifd) + 2 + static_cast<uint64_t>(entriesCount) * IFD_ENTRY_SIZE > m_size) {
+			return false;
+		}
+
+		for (uint32_t entry = ifd + 2; entry < ifd + 2 + entriesCount * IFD_ENTRY_SIZE; entry += IFD_ENTRY_SIZE) {
+			uint16_t tag = 0;
+			read16(entry, tag);
+			onEntry(tag, entry);
+		}
+		return true;
+	}
+
+	// the value of an entry is in the entry itself when it fits in 4 bytes, otherwise the entry holds its offset
+	bool value(uint32_t entry, uint16_t expectedType, uint32_t valueSize, uint32_t& count, uint32_t& offset) const
+	{
+		uint16_t type = 0;
+		if (!read16(entry + 2, type) || type != expectedType || !read32(entry + 4, count)) {
+			return false;
+		}
+
+		uint64_t size = static_cast<uint64_t>(count) * valueSize;
+		if (size <= 4) {
+			offset = entry + 8;
+		}
+		else if (!read32(entry + 8, offset)) {
+			return false;
+		}
+		return offset + size <= m_size;
+	}
+
+	bool readText(uint32_t entry, std::string& text) const
+	{
+		uint32_t count = 0, offset = 0;
+		if (!value(entry, TYPE_ASCII, 1, count, offset)) {
+			return false;
+		}
+
+		// the text ends with a NUL, some cameras pad it with spaces too
+		text.assign(reinterpret_cast<const char*>(m_data + offset), count);
+		text.erase(std::min(text.find('\0'), text.size()));
+		text.erase(text.find_last_not_of(' ') + 1);
+		return true;
+	}
+
+	bool readLong(uint32_t entry, uint32_t& number) const
+	{
+		uint32_t count = 0, offset = 0;
+		uint16_t shortNumber = 0;
+		if (value(entry, TYPE_LONG, 4, count, offset) && count > 0) {
+			return read32(offset, number);
+		}
+		if (value(entry, TYPE_SHORT, 2, count, offset) && count > 0 && read16(offset, shortNumber)) {
+			number = shortNumber;
+			return true;
+		}
+		return false;
+	}
+
+	bool readRational(uint32_t entry, uint32_t index, double& number) const
+	{
+		uint32_t count = 0, offset = 0, numerator = 0, denominator = 0;
+		if (!value(entry, TYPE_RATIONAL, 8, count, offset) || index >= count ||
+			!read32(offset + index * 8, numerator) || !read32(offset + index * 8 + 4, denominator) || 0 == denominator)
+		{
+			return false;
+		}
+
+		number = static_cast<double>(numerator) / denominator;
+		return true;
+	}
+
+private:
+	const unsigned char* m_data;
+	size_t m_size;
+	bool m_bigEndian;
+};
+
+
+bool ExifMetadata::isEmpty() const
+{
+	return 0 == captureTime && cameraModel.empty() && !hasLocation;
+}
+
+/*
+This function reads the EXIF metadata of a JPEG file
+input: the file path, the metadata to fill
+output: true if the file has EXIF metadata that was read, false otherwise
+*/
+bool ExifMetadata::read(const std::string& path, ExifMetadata& metadata)
+{
+	FILE* file = std::fopen(path.c_str(), "rb");
+	if (nullptr == file) {
+		return false;
+	}
+
+	// every read is one read of the file, the stream doesn't read ahead of it
+	std::setvbuf(file, nullptr, _IONBF, 0);
+
+	unsigned char start[2] = {};
+	bool succeeded = false;
+	if (std::fread(start, 1, sizeof(start), file) == sizeof(start) && 0xFF == start[0] && 0xD8 == start[1]) {
+		long offset = sizeof(start);
+
+		// the marker and length of a segment, then the identifier of an APP1 segment, in one read
+		for (int segment = 0; segment < MAX_JPEG_SEGMENTS; ++segment) {
+			unsigned char header[4 + sizeof(EXIF_IDENTIFIER)] = {};
+			size_t readCount = std::fseek(file, offset, SEEK_SET) == 0 ? std::fread(header, 1, sizeof(header), file) : 0;
+			if (readCount < 4 || header[0] != 0xFF) {
+				break;
+			}
+			if (0xFF == header[1]) {
+				// a fill byte before the marker
+				++offset;
+				continue;
+			}
+			if (0xD9 == header[1] || 0xDA == header[1] || (header[1] >= 0xC0 && header[1] <= 0xCF && header[1] != 0xC4 && header[1] != 0xC8 && header[1] != 0xCC)) {
+				// the EXIF segment comes before the frame and the image data
+				break;
+			}
+
+			uint16_t length = static_cast<uint16_t>((header[2] << 8) | header[3]);
+			if (length < 2) {
+				break;
+			}
+
+			if (0xE1 == header[1] && readCount == sizeof(header) && length >= 2 + sizeof(EXIF_IDENTIFIER) &&
+				std::memcmp(header + 4, EXIF_IDENTIFIER, sizeof(EXIF_IDENTIFIER)) == 0)
+			{
+				std::vector<unsigned char> data(length - 2 - sizeof(EXIF_IDENTIFIER));
+				ExifMetadata result;
+				succeeded = std::fread(data.data(), 1, data.size(), file) == data.size() && parse(data.data(), data.size(), result);
+				if (succeeded) {
+					metadata = std::move(result);
+				}
+				break;
+			}
+
+			if (offset > LONG_MAX - 2 - length) {
+				break;
+			}
+			offset += 2 + length;
+		}
+	}
+	std::fclose(file);
+
+	return succeeded;
+}
+
+/*
+This function parses the TIFF structure of an EXIF segment (what follows its identifier)
+input: the structure, its size, the metadata to fill
+output: true if any of the metadata was found, false otherwise
+*/
+bool ExifMetadata::parse(const unsigned char* data, size_t size, ExifMetadata& metadata)
+{
+	// the byte order, the number 42 and the offset of the first IFD
+	if (size < 8 || data[0] != data[1] || ('M' != data[0] && 'I' != data[0])) {
+		return false;
+	}
+
+	TiffReader tiff(data, size, 'M' == data[0]);
+	uint16_t magic = 0;
+	uint32_t firstIfd = 0;
+	if (!tiff.read16(2, magic) || magic != 42 || !tiff.read32(4, firstIfd)) {
+		return false;
+	}
+
+	ExifMetadata result;
+	std::string dateTime, dateTimeOriginal;
+	uint32_t exifIfd = 0, gpsIfd = 0;
+
+	tiff.forEachEntry(firstIfd, [&](uint16_t tag, uint32_t entry) {
+		switch (tag) {
+		case TAG_MODEL:
+			tiff.readText(entry, result.cameraModel);
+			break;
+		case TAG_DATE_TIME:
+			tiff.readText(entry, dateTime);
+			break;
+		case TAG_EXIF_IFD:
+			tiff.readLong(entry, exifIfd);
+			break;
+		case TAG_GPS_IFD:
+			tiff.readLong(entry, gpsIfd);
+			break;
+		}
+	});
+
+	if (exifIfd != 0) {
+		tiff.forEachEntry(exifIfd, [&](uint16_t tag, uint32_t entry) {
+			if (TAG_DATE_TIME_ORIGINAL == tag) {
+				tiff.readText(entry, dateTimeOriginal);
+			}
+		});
+	}
+
+	// the time the photo was taken, or else the time the file was last changed by the camera
+	if (!parseTime(dateTimeOriginal, result.captureTime)) {
+		parseTime(dateTime, result.captureTime);
+	}
+
+	if (gpsIfd != 0) {
+		std::string latitudeReference, longitudeReference;
+		uint32_t latitudeEntry = 0, longitudeEntry = 0;
+		tiff.forEachEntry(gpsIfd, [&](uint16_t tag, uint32_t entry) {
+			switch (tag) {
+			case TAG_GPS_LATITUDE_REF:
+				tiff.readText(entry, latitudeReference);
+				break;
+			case TAG_GPS_LATITUDE:
+				latitudeEntry = entry;
+				break;
+			case TAG_GPS_LONGITUDE_REF:
+				tiff.readText(entry, longitudeReference);
+				break;
+			case TAG_GPS_LONGITUDE:
+				longitudeEntry = entry;
+				break;
+			}
+		});
+
+		result.hasLocation = latitudeEntry != 0 && longitudeEntry != 0 &&
+			readCoordinate(tiff, latitudeEntry, latitudeReference, 'S', result.latitude) && std::fabs(result.latitude) <= 90 &&
+			readCoordinate(tiff, longitudeEntry, longitudeReference, 'W', result.longitude) && std::fabs(result.longitude) <= 180;
+		if (!result.hasLocation) {
+			result.latitude = result.longitude = 0;
+		}
+	}
+
+	if (result.isEmpty()) {
+		return false;
+	}
+
+	metadata = std::move(result);
+	return true;
+}
+
+/*
+This function parses an EXIF time ("yyyy:mm:dd hh:mm:ss", local time)
+input: the string, the parsed time (output parameter)
+output: true if the string is a valid time, false otherwise (cameras write zeros when they don't know the time)
+*/
+bool ExifMetadata::parseTime(const std::string& str, int64_t& time)
+{
+	std::tm localTime = {};
+	std::istringstream iss(str);
+
+	iss >> std::get_time(&localTime, "%Y:%m:%d %H:%M:%S");
+	if (iss.fail()) {
+		return false;
+	}
+
+	// let mktime find out whether daylight saving time was in effect
+	localTime.tm_isdst = -1;
+	time_t value = mktime(&localTime);
+	if (value == static_cast<time_t>(-1) || 0 == value) {
+		return false;
+	}
+
+	time = static_cast<int64_t>(value);
+	return true;
+}
+
+/*
+This function reads a GPS coordinate - degrees, minutes and seconds
+input: the TIFF structure, the entry of the coordinate, its reference (N / S or E / W), the reference of
+negative coordinates, the coordinate in degrees (output parameter)
+output: true if the coordinate was read, false otherwise
+*/
+bool ExifMetadata::readCoordinate(const TiffReader& tiff, uint32_t entry, const std::string& reference, char negativeReference, double& degrees)
+{
+	double wholeDegrees = 0, minutes = 0, seconds = 0;
+	if (!tiff.readRational(entry, 0, wholeDegrees) || !tiff.readRational(entry, 1, minutes) || !tiff.readRational(entry, 2, seconds)) {
+		return false;
+	}
+
+	degrees = wholeDegrees + minutes / 60 + seconds / 3600;
+	if (!reference.empty() && negativeReference == reference[0]) {
+		degrees = -degrees;
+	}
+	return true;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+What the camera wrote about a photo in the EXIF segment (APP1) of its JPEG file: when it was
+taken, with which camera, and where. Only that segment is read - the file is walked from marker
+to marker up to it, and the segment (at most 64 KB) is read in one go.
+Times are kept like the creation times of the pictures (see TimeFormat); EXIF times have no time
+zone, so they're taken as local time.
+*/
+class ExifMetadata
+{
+public:
+	// seconds since the epoch, 0 if the photo has no capture time
+	int64_t captureTime { 0 };
+	std::string cameraModel;
+	bool hasLocation { false };
+	// degrees, north and east are positive
+	double latitude { 0 };
+	double longitude { 0 };
+
+	bool isEmpty() const;
+
+	static bool read(const std::string& path, ExifMetadata& metadata);
+	static bool parse(const unsigned char* data, size_t size, ExifMetadata& metadata);
+
+private:
+	class TiffReader;
+
+	static bool parseTime(const std::string& str, int64_t& time);
+	static bool readCoordinate(const TiffReader& tiff, uint32_t entry, const std::string& reference, char negativeReference, double& degrees);
+};
@@ -1,8 +1,11 @@
 #include <iostream>
 #include <string>
 #include <ctime>
+#include <memory>
+#include <stdexcept>
 #include "MemoryAccess.h"
 #include "DatabaseAccess.h"
+#include "ConcurrentAccess.h"
 #include "AlbumManager.h"
 
 
@@ -31,14 +34,26 @@ int getCommandNumberFromUser()
 }
 
 void printSystemInfo();
+bool configureDataAccess(int argc, char* argv[], DatabaseAccess& dataAccess);
 
-int main(void)
+int main(int argc, char* argv[])
 {
 	// initialization data access
 	DatabaseAccess dataAccess;
+	if (!configureDataAccess(argc, argv, dataAccess)) {
+		return 1;
+	}
+	// every call goes through a reader/writer lock, so the data access may be used from more than one thread
+	ConcurrentAccess concurrentAccess(dataAccess);
 
-	// initialize album manager
-	AlbumManager albumManager(dataAccess);
+	// initialize album manager (it opens the gallery)
+	std::unique_ptr<AlbumManager> albumManager;
+	try {
+		albumManager = std::make_unique<AlbumManager>(concurrentAccess);
+	} catch (std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
 
 	std::string albumName;
 
@@ -51,7 +66,7 @@ int main(void)
 		int commandNumber = getCommandNumberFromUser();
 		
 		try	{
-			albumManager.executeCommand(static_cast<CommandType>(commandNumber));
+			albumManager->executeCommand(static_cast<CommandType>(commandNumber));
 		} catch (std::exception& e) {	
 			std::cout << e.what() << std::endl;
 		}
@@ -60,6 +75,49 @@ int main(void)
 }
 
 
+/*
+This function applies the command line options to the data access:
+  --flush-policy <changes> <milliseconds>   commit the changes that were written behind every <changes> changes,
+                                            or on the first change after <milliseconds> (1000 and 1000 by default)
+  --lazy-loading <albums>                   load the albums on demand, keeping up to <albums> whole albums in memory
+input: the arguments of main, the data access
+output: true if the options are valid, false otherwise (the usage is printed)
+*/
+bool configureDataAccess(int argc, char* argv[], DatabaseAccess& dataAccess)
+{
+	try {
+		for (int i = 1; i < argc; ++i) {
+			std::string option(argv[i]);
+
+			if (option == "--flush-policy" && i + 2 < argc) {
+				int flushSize = std::stoi(argv[++i]);
+				int flushInterval = std::stoi(argv[++i]);
+				if (flushSize <= 0 || flushInterval < 0) {
+					throw std::invalid_argument(option);
+				}
+				dataAccess.setFlushPolicy(flushSize, std::chrono::milliseconds(flushInterval));
+			}
+			else if (option == "--lazy-loading" && i + 1 < argc) {
+				int albumsCacheCapacity = std::stoi(argv[++i]);
+				if (albumsCacheCapacity <= 0) {
+					throw std::invalid_argument(option);
+				}
+				dataAccess.setLazyLoading(static_cast<size_t>(albumsCacheCapacity));
+			}
+			else {
+				throw std::invalid_argument(option);
+			}
+		}
+	}
+	catch (const std::logic_error&) {
+		std::cout << "Usage: Gallery [--flush-policy <changes> <milliseconds>] [--lazy-loading <albums>]" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+
 /*
 This function prints the system information on the screen
 input: none
@@ -0,0 +1,455 @@
+#include "GalleryIndex.h"
+#include <algorithm>
+#include <climits>
+
+
+GalleryIndex::GalleryIndex(std::list<Album>& albums, std::list<User>& users) :
+	m_albums(albums), m_users(users),
+	m_albumsById(&m_memory), m_albumsByOwnerAndName(&m_memory), m_albumsByOwner(&m_memory),
+	m_usersById(&m_memory), m_tagsByUser(&m_memory), m_tagsCountByPicture(&m_memory),
+	m_usersRanking(&m_memory), m_picturesRanking(&m_memory), m_picturesByCreationTime(&m_memory),
+	m_picturesByContentHash(&m_memory), m_duplicateContentHashes(&m_memory), m_picturesByCaptureTime(&m_memory),
+	m_picturesByCameraModel(&m_memory)
+{
+	// Left empty
+}
+
+/*
+This function empties the index and gives its memory pool back
+input: none
+output: none
+*/
+void GalleryIndex::clear()
+{
+	// new empty containers (a cleared hash table keeps its buckets), then no block of the pool is in use
+	m_albumsById = decltype(m_albumsById)(&m_memory);
+	m_albumsByOwnerAndName = decltype(m_albumsByOwnerAndName)(&m_memory);
+	m_albumsByOwner = decltype(m_albumsByOwner)(&m_memory);
+	m_usersById = decltype(m_usersById)(&m_memory);
+	m_tagsByUser = decltype(m_tagsByUser)(&m_memory);
+	m_tagsCountByPicture = decltype(m_tagsCountByPicture)(&m_memory);
+	m_usersRanking = decltype(m_usersRanking)(&m_memory);
+	m_picturesRanking = decltype(m_picturesRanking)(&m_memory);
+	m_picturesByCreationTime = decltype(m_picturesByCreationTime)(&m_memory);
+	m_picturesByContentHash = decltype(m_picturesByContentHash)(&m_memory);
+	m_duplicateContentHashes = decltype(m_duplicateContentHashes)(&m_memory);
+	m_picturesByPerceptualHash.clear();
+	m_picturesByCaptureTime = decltype(m_picturesByCaptureTime)(&m_memory);
+	m_picturesByCameraModel = decltype(m_picturesByCameraModel)(&m_memory);
+
+	m_memory.release();
+}
+
+
+// ******************* Album *******************
+void GalleryIndex::addAlbum(AlbumIterator album)
+{
+	m_albumsById[album->getId()] = album;
+	m_albumsByOwnerAndName[AlbumKey(album->getOwnerId(), album->getName())] = album;
+	m_albumsByOwner[album->getOwnerId()][album->getId()] = album;
+
+	for (const auto& picture : album->getPictures()) {
+		addPicture(album->getId(), picture);
+	}
+}
+
+void GalleryIndex::removeAlbum(AlbumIterator album)
+{
+	for (const auto& picture : album->getPictures()) {
+		removePicture(album->getId(), picture);
+	}
+
+	m_albumsById.erase(album->getId());
+	m_albumsByOwnerAndName.erase(AlbumKey(album->getOwnerId(), album->getName()));
+
+	auto ownerAlbums = m_albumsByOwner.find(album->getOwnerId());
+	if (ownerAlbums != m_albumsByOwner.end()) {
+		ownerAlbums->second.erase(album->getId());
+		if (ownerAlbums->second.empty()) {
+			m_albumsByOwner.erase(ownerAlbums);
+		}
+	}
+}
+
+GalleryIndex::AlbumIterator GalleryIndex::findAlbum(int albumId) const
+{
+	auto result = m_albumsById.find(albumId);
+	return result == m_albumsById.end() ? m_albums.end() : result->second;
+}
+
+GalleryIndex::AlbumIterator GalleryIndex::findAlbum(const std::string& albumName, int ownerId) const
+{
+	auto result = m_albumsByOwnerAndName.find(AlbumKey(ownerId, albumName));
+	return result == m_albumsByOwnerAndName.end() ? m_albums.end() : result->second;
+}
+
+std::vector<GalleryIndex::AlbumIterator> GalleryIndex::findAlbumsOfUser(int ownerId) const
+{
+	std::vector<AlbumIterator> albums;
+
+	auto ownerAlbums = m_albumsByOwner.find(ownerId);
+	if (ownerAlbums != m_albumsByOwner.end()) {
+		for (const auto& album : ownerAlbums->second) {
+			albums.push_back(album.second);
+		}
+	}
+
+	return albums;
+}
+
+int GalleryIndex::countAlbumsOfUser(int ownerId) const
+{
+	auto ownerAlbums = m_albumsByOwner.find(ownerId);
+	return ownerAlbums == m_albumsByOwner.end() ? 0 : static_cast<int>(ownerAlbums->second.size());
+}
+
+
+// ******************* User *******************
+void GalleryIndex::addUser(UserIterator user)
+{
+	m_usersById[user->getId()] = user;
+}
+
+void GalleryIndex::removeUser(UserIterator user)
+{
+	m_usersById.erase(user->getId());
+}
+
+GalleryIndex::UserIterator GalleryIndex::findUser(int userId) const
+{
+	auto result = m_usersById.find(userId);
+	return result == m_usersById.end() ? m_users.end() : result->second;
+}
+
+
+// ******************* Picture *******************
+void GalleryIndex::addPicture(int albumId, const Picture& picture)
+{
+	m_picturesByCreationTime.emplace(picture.getCreationTime(), PictureKey(albumId, picture.getId()));
+
+	if (picture.getContentHash() != 0) {
+		auto& sameContent = m_picturesByContentHash[picture.getContentHash()];
+		sameContent.emplace_back(albumId, picture.getId());
+		if (sameContent.size() == 2) {
+			m_duplicateContentHashes.insert(picture.getContentHash());
+		}
+	}
+
+	if (picture.getPerceptualHash() != 0) {
+		m_picturesByPerceptualHash.add(picture.getPerceptualHash(), PictureKey(albumId, picture.getId()));
+	}
+
+	const ExifMetadata& metadata = picture.getMetadata();
+	if (metadata.captureTime != 0) {
+		m_picturesByCaptureTime.emplace(metadata.captureTime, PictureKey(albumId, picture.getId()));
+	}
+	if (!metadata.cameraModel.empty()) {
+		m_picturesByCameraModel[cameraKey(metadata.cameraModel)].emplace(metadata.captureTime, PictureKey(albumId, picture.getId()));
+	}
+
+	for (int userId : picture.getUserTags()) {
+		addTag(userId, albumId, picture.getId());
+	}
+}
+
+void GalleryIndex::removePicture(int albumId, const Picture& picture)
+{
+	m_picturesByCreationTime.erase(std::make_pair(picture.getCreationTime(), PictureKey(albumId, picture.getId())));
+
+	auto sameContent = m_picturesByContentHash.find(picture.getContentHash());
+	if (sameContent != m_picturesByContentHash.end()) {
+		auto& pictures = sameContent->second;
+		pictures.erase(std::remove(pictures.begin(), pictures.end(), PictureKey(albumId, picture.getId())), pictures.end());
+
+		if (pictures.size() < 2) {
+			m_duplicateContentHashes.erase(sameContent->first);
+		}
+		if (pictures.empty()) {
+			m_picturesByContentHash.erase(sameContent);
+		}
+	}
+
+	m_picturesByPerceptualHash.remove(picture.getPerceptualHash(), PictureKey(albumId, picture.getId()));
+
+	const ExifMetadata& metadata = picture.getMetadata();
+	m_picturesByCaptureTime.erase(std::make_pair(metadata.captureTime, PictureKey(albumId, picture.getId())));
+	auto sameCamera = m_picturesByCameraModel.find(cameraKey(metadata.cameraModel));
+	if (sameCamera != m_picturesByCameraModel.end()) {
+		sameCamera->second.erase(std::make_pair(metadata.captureTime, PictureKey(albumId, picture.getId())));
+		if (sameCamera->second.empty()) {
+			m_picturesByCameraModel.erase(sameCamera);
+		}
+	}
+
+	for (int userId : picture.getUserTags()) {
+		removeTag(userId, albumId, picture.getId());
+	}
+}
+
+/*
+This function returns the pictures created in a time range, the oldest one first
+input: the first and last creation times of the range (seconds since the epoch, both included)
+output: (album id, picture id) of every picture
+*/
+std::vector<GalleryIndex::PictureKey> GalleryIndex::getPicturesCreatedBetween(int64_t from, int64_t to) const
+{
+	std::vector<PictureKey> pictures;
+	auto iter = m_picturesByCreationTime.lower_bound(std::make_pair(from, PictureKey(INT_MIN, INT_MIN)));
+
+	for (; iter != m_picturesByCreationTime.end() && iter->first <= to; ++iter) {
+		pictures.push_back(iter->second);
+	}
+
+	return pictures;
+}
+
+/*
+This function returns the groups of pictures that have the same content
+input: none
+output: (album id, picture id) of the pictures of every group, ordered by picture id,
+the groups are ordered by their first picture id
+*/
+std::vector<std::vector<GalleryIndex::PictureKey>> GalleryIndex::getDuplicatePictures() const
+{
+	auto byPictureId = [](const PictureKey& first, const PictureKey& second) {
+		return first.second < second.second;
+	};
+
+	std::vector<std::vector<PictureKey>> groups;
+	groups.reserve(m_duplicateContentHashes.size());
+
+	for (uint64_t contentHash : m_duplicateContentHashes) {
+		const auto& pictures = m_picturesByContentHash.at(contentHash);
+		groups.emplace_back(pictures.begin(), pictures.end());
+		std::sort(groups.back().begin(), groups.back().end(), byPictureId);
+	}
+
+	std::sort(groups.begin(), groups.end(), [&byPictureId](const std::vector<PictureKey>& first, const std::vector<PictureKey>& second) {
+		return byPictureId(first.front(), second.front());
+	});
+	return groups;
+}
+
+/*
+This function returns the groups of pictures that look alike (see HammingIndex::findGroups)
+input: the max distance between the perceptual hashes of similar pictures
+output: (album id, picture id) of the pictures of every group, ordered by picture id,
+the groups are ordered by their first picture id
+*/
+std::vector<std::vector<GalleryIndex::PictureKey>> GalleryIndex::getSimilarPictures(int maxDistance) const
+{
+	return m_picturesByPerceptualHash.findGroups(maxDistance);
+}
+
+/*
+This function returns the pictures taken in a time range, the oldest one first
+input: the first and last capture times of the range (seconds since the epoch, both included)
+output: (album id, picture id) of every picture
+*/
+std::vector<GalleryIndex::PictureKey> GalleryIndex::getPicturesCapturedBetween(int64_t from, int64_t to) const
+{
+	std::vector<PictureKey> pictures;
+	auto iter = m_picturesByCaptureTime.lower_bound(std::make_pair(from, PictureKey(INT_MIN, INT_MIN)));
+
+	for (; iter != m_picturesByCaptureTime.end() && iter->first <= to; ++iter) {
+		pictures.push_back(iter->second);
+	}
+
+	return pictures;
+}
+
+/*
+This function returns the pictures taken with a camera, the oldest one first
+input: the camera model (case insensitive)
+output: (album id, picture id) of every picture
+*/
+std::vector<GalleryIndex::PictureKey> GalleryIndex::getPicturesOfCamera(const std::string& cameraModel) const
+{
+	std::vector<PictureKey> pictures;
+	auto sameCamera = m_picturesByCameraModel.find(cameraKey(cameraModel));
+
+	if (sameCamera != m_picturesByCameraModel.end()) {
+		for (const auto& picture : sameCamera->second) {
+			pictures.push_back(picture.second);
+		}
+	}
+
+	return pictures;
+}
+
+/*
+This function makes the key of a camera model - the models are compared like the DB does (NOCASE, ASCII letters only)
+input: the camera model
+output: the model in lower case
+*/
+std::string GalleryIndex::cameraKey(const std::string& cameraModel)
+{
+	std::string key = cameraModel;
+	std::transform(key.begin(), key.end(), key.begin(), [](char c) {
+		return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+	});
+	return key;
+}
+
+
+// ******************* Tags *******************
+
+void GalleryIndex::addTag(int userId, int albumId, int pictureId)
+{
+	UserTags& userTags = m_tagsByUser[userId];
+	if (!userTags.pictures[albumId].insert(pictureId).second) {
+		return;
+	}
+
+	rerank(m_usersRanking, UserRank(userTags.tagsCount, userId), UserRank(userTags.tagsCount + 1, userId));
+	++userTags.tagsCount;
+
+	int& pictureTagsCount = m_tagsCountByPicture[PictureKey(albumId, pictureId)];
+	rerank(m_picturesRanking, PictureRank { pictureTagsCount, albumId, pictureId }, PictureRank { pictureTagsCount + 1, albumId, pictureId });
+	++pictureTagsCount;
+}
+
+void GalleryIndex::removeTag(int userId, int albumId, int pictureId)
+{
+	auto userTags = m_tagsByUser.find(userId);
+	if (userTags == m_tagsByUser.end()) {
+		return;
+	}
+
+	auto album = userTags->second.pictures.find(albumId);
+	if (album == userTags->second.pictures.end() || 0 == album->second.erase(pictureId)) {
+		return;
+	}
+
+	if (userTags->second.tagsCount > 1) {
+		rerank(m_usersRanking, UserRank(userTags->second.tagsCount, userId), UserRank(userTags->second.tagsCount - 1, userId));
+	}
+	else {
+		m_usersRanking.erase(UserRank(userTags->second.tagsCount, userId));
+	}
+	--userTags->second.tagsCount;
+
+	auto pictureTagsCount = m_tagsCountByPicture.find(PictureKey(albumId, pictureId));
+	if (pictureTagsCount->second > 1) {
+		rerank(m_picturesRanking, PictureRank { pictureTagsCount->second, albumId, pictureId }, PictureRank { pictureTagsCount->second - 1, albumId, pictureId });
+		--pictureTagsCount->second;
+	}
+	else {
+		m_picturesRanking.erase({ pictureTagsCount->second, albumId, pictureId });
+		m_tagsCountByPicture.erase(pictureTagsCount);
+	}
+
+	if (album->second.empty()) {
+		userTags->second.pictures.erase(album);
+	}
+	if (userTags->second.pictures.empty()) {
+		m_tagsByUser.erase(userTags);
+	}
+}
+
+const GalleryIndex::TaggedPictures& GalleryIndex::getTaggedPicturesOfUser(int userId) const
+{
+	static const TaggedPictures noPictures;
+
+	auto userTags = m_tagsByUser.find(userId);
+	return userTags == m_tagsByUser.end() ? noPictures : userTags->second.pictures;
+}
+
+int GalleryIndex::countTagsOfUser(int userId) const
+{
+	auto userTags = m_tagsByUser.find(userId);
+	return userTags == m_tagsByUser.end() ? 0 : userTags->second.tagsCount;
+}
+
+int GalleryIndex::countAlbumsTaggedOfUser(int userId) const
+{
+	auto userTags = m_tagsByUser.find(userId);
+	return userTags == m_tagsByUser.end() ? 0 : static_cast<int>(userTags->second.pictures.size());
+}
+
+/*
+This function returns the most tagged users, the most tagged one first
+(on equal tags count the user with the higher id comes first)
+input: how many users to return
+output: the ids of the users
+*/
+std::vector<int> GalleryIndex::getTopTaggedUsers(size_t count) const
+{
+	std::vector<int> usersIds;
+
+	for (auto iter = m_usersRanking.begin(); iter != m_usersRanking.end() && usersIds.size() < count; ++iter) {
+		usersIds.push_back(iter->second);
+	}
+
+	return usersIds;
+}
+
+/*
+This function returns the most tagged pictures, the most tagged one first
+(on equal tags count the picture of the older album comes first)
+input: how many pictures to return
+output: (album id, picture id) of every picture
+*/
+std::vector<GalleryIndex::PictureKey> GalleryIndex::getTopTaggedPictures(size_t count) const
+{
+	std::vector<PictureKey> pictures;
+
+	for (auto iter = m_picturesRanking.begin(); iter != m_picturesRanking.end() && pictures.size() < count; ++iter) {
+		pictures.emplace_back(iter->albumId, iter->pictureId);
+	}
+
+	return pictures;
+}
+
+
+/*
+This function moves an entry of a ranking to its new place, reusing its node (the entry is added if it isn't there)
+input: the ranking, the old and new entries
+output: none
+*/
+template <class Ranking, class Rank>
+void GalleryIndex::rerank(Ranking& ranking, const Rank& oldRank, const Rank& newRank)
+{
+	auto node = ranking.extract(oldRank);
+	if (node.empty()) {
+		ranking.insert(newRank);
+		return;
+	}
+
+	node.value() = newRank;
+	ranking.insert(std::move(node));
+}
+
+
+GalleryIndex::UserTags::UserTags(const allocator_type& allocator) :
+	pictures(allocator)
+{
+	// Left empty
+}
+
+GalleryIndex::UserTags::UserTags(const UserTags& other, const allocator_type& allocator) :
+	pictures(other.pictures, allocator), tagsCount(other.tagsCount)
+{
+	// Left empty
+}
+
+bool GalleryIndex::PictureRank::operator<(const PictureRank& other) const
+{
+	if (tagsCount != other.tagsCount) {
+		return tagsCount > other.tagsCount;
+	}
+	if (albumId != other.albumId) {
+		return albumId < other.albumId;
+	}
+	return pictureId < other.pictureId;
+}
+
+size_t GalleryIndex::PictureKeyHash::operator()(const PictureKey& key) const
+{
+	return std::hash<int>()(key.second) ^ (std::hash<int>()(key.first) * 0x9e3779b9u);
+}
+
+size_t GalleryIndex::AlbumKeyHash::operator()(const AlbumKey& key) const
+{
+	return std::hash<std::string>()(key.second) ^ (std::hash<int>()(key.first) * 0x9e3779b9u);
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <set>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include "Album.h"
+#include "HammingIndex.h"
+#include "User.h"
+
+/*
+Secondary indexes over the albums and users lists of a data access.
+The lists stay the owners of the objects, the index only keeps iterators to them,
+so it must be told about every album / user / tag that is added or removed.
+Every find function returns the end() of the matching list if nothing was found.
+The index nodes (about five per picture tag on a big gallery) are carved out of a memory pool
+owned by the index instead of being allocated one by one, and clear() gives the whole pool back
+(it still destroys the nodes one by one, but frees none of them alone).
+The albums and pictures themselves aren't in the pool.
+*/
+class GalleryIndex
+{
+public:
+	using AlbumIterator = std::list<Album>::iterator;
+	using UserIterator = std::list<User>::iterator;
+	// album id -> ids of the pictures in that album
+	using TaggedPictures = std::pmr::unordered_map<int, std::pmr::unordered_set<int>>;
+	// album id, picture id
+	using PictureKey = std::pair<int, int>;
+
+	GalleryIndex(std::list<Album>& albums, std::list<User>& users);
+	GalleryIndex(const GalleryIndex&) = delete;
+	GalleryIndex& operator=(const GalleryIndex&) = delete;
+
+	void clear();
+
+	// album related
+	void addAlbum(AlbumIterator album);
+	void removeAlbum(AlbumIterator album);
+	AlbumIterator findAlbum(int albumId) const;
+	AlbumIterator findAlbum(const std::string& albumName, int ownerId) const;
+	std::vector<AlbumIterator> findAlbumsOfUser(int ownerId) const;
+	int countAlbumsOfUser(int ownerId) const;
+
+	// user related
+	void addUser(UserIterator user);
+	void removeUser(UserIterator user);
+	UserIterator findUser(int userId) const;
+
+	// picture related
+	void addPicture(int albumId, const Picture& picture);
+	void removePicture(int albumId, const Picture& picture);
+	std::vector<PictureKey> getPicturesCreatedBetween(int64_t from, int64_t to) const;
+	std::vector<std::vector<PictureKey>> getDuplicatePictures() const;
+	std::vector<std::vector<PictureKey>> getSimilarPictures(int maxDistance) const;
+	std::vector<PictureKey> getPicturesCapturedBetween(int64_t from, int64_t to) const;
+	std::vector<PictureKey> getPicturesOfCamera(const std::string& cameraModel) const;
+
+	// tag related
+	void addTag(int userId, int albumId, int pictureId);
+	void removeTag(int userId, int albumId, int pictureId);
+	const TaggedPictures& getTaggedPicturesOfUser(int userId) const;
+	int countTagsOfUser(int userId) const;
+	int countAlbumsTaggedOfUser(int userId) const;
+	std::vector<int> getTopTaggedUsers(size_t count) const;
+	std::vector<PictureKey> getTopTaggedPictures(size_t count) const;
+
+private:
+	using AlbumKey = std::pair<int, std::string>;
+
+	struct AlbumKeyHash
+	{
+		size_t operator()(const AlbumKey& key) const;
+	};
+
+	struct PictureKeyHash
+	{
+		size_t operator()(const PictureKey& key) const;
+	};
+
+	// built in the pool of the index that holds it
+	struct UserTags
+	{
+		using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+		explicit UserTags(const allocator_type& allocator);
+		UserTags(const UserTags& other, const allocator_type& allocator);
+
+		TaggedPictures pictures;
+		int tagsCount { 0 };
+	};
+
+	// tags count, user id - ordered so the most tagged user is the first one
+	using UserRank = std::pair<int, int>;
+
+	// ordered so the most tagged picture is the first one
+	struct PictureRank
+	{
+		int tagsCount;
+		int albumId;
+		int pictureId;
+
+		bool operator<(const PictureRank& other) const;
+	};
+
+	std::list<Album>& m_albums;
+	std::list<User>& m_users;
+
+	// not thread safe - the index is only changed by one thread at a time (see ConcurrentAccess)
+	// must be declared before the containers that use it
+	std::pmr::unsynchronized_pool_resource m_memory;
+
+	std::pmr::unordered_map<int, AlbumIterator> m_albumsById;
+	std::pmr::unordered_map<AlbumKey, AlbumIterator, AlbumKeyHash> m_albumsByOwnerAndName;
+	// owner id -> album id -> album, so the albums of a user are listed in creation order
+	std::pmr::unordered_map<int, std::pmr::map<int, AlbumIterator>> m_albumsByOwner;
+	std::pmr::unordered_map<int, UserIterator> m_usersById;
+	std::pmr::unordered_map<int, UserTags> m_tagsByUser;
+	std::pmr::unordered_map<PictureKey, int, PictureKeyHash> m_tagsCountByPicture;
+	std::pmr::set<UserRank, std::greater<UserRank>> m_usersRanking;
+	std::pmr::set<PictureRank> m_picturesRanking;
+	// creation time, (album id, picture id) - ordered so a time range is one contiguous run
+	std::pmr::set<std::pair<int64_t, PictureKey>> m_picturesByCreationTime;
+	// content hash -> the pictures of that content (pictures that weren't hashed are left out)
+	std::pmr::unordered_map<uint64_t, std::pmr::vector<PictureKey>> m_picturesByContentHash;
+	// the content hashes that more than one picture has, so the duplicates are found without a full scan
+	std::pmr::unordered_set<uint64_t> m_duplicateContentHashes;
+	// perceptual hash -> the pictures that look like it (pictures that weren't decoded are left out)
+	HammingIndex m_picturesByPerceptualHash;
+	// capture time, (album id, picture id) - like the creation times (pictures with no capture time are left out)
+	std::pmr::set<std::pair<int64_t, PictureKey>> m_picturesByCaptureTime;
+	// camera model (lower case) -> capture time, (album id, picture id) of the pictures taken with that camera
+	std::pmr::unordered_map<std::string, std::pmr::set<std::pair<int64_t, PictureKey>>> m_picturesByCameraModel;
+
+	static std::string cameraKey(const std::string& cameraModel);
+
+	template <class Ranking, class Rank>
+	static void rerank(Ranking& ranking, const Rank& oldRank, const Rank& newRank);
+};
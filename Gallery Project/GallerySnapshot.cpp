@@ -0,0 +1,41 @@
+#include "GallerySnapshot.h"
+
+
+GallerySnapshot::GallerySnapshot(unsigned long long version, const std::list<Album>& albums, const std::list<User>& users) :
+	m_version(version), m_albums(albums.begin(), albums.end()), m_users(users.begin(), users.end())
+{
+	for (size_t i = 0; i < m_albums.size(); ++i) {
+		m_albumsById[m_albums[i].getId()] = i;
+	}
+
+	for (size_t i = 0; i < m_users.size(); ++i) {
+		m_usersById[m_users[i].getId()] = i;
+	}
+}
+
+unsigned long long GallerySnapshot::getVersion() const
+{
+	return m_version;
+}
+
+const std::vector<Album>& GallerySnapshot::getAlbums() const
+{
+	return m_albums;
+}
+
+const Album* GallerySnapshot::findAlbum(int albumId) const
+{
+	auto result = m_albumsById.find(albumId);
+	return result == m_albumsById.end() ? nullptr : &m_albums[result->second];
+}
+
+const std::vector<User>& GallerySnapshot::getUsers() const
+{
+	return m_users;
+}
+
+const User* GallerySnapshot::findUser(int userId) const
+{
+	auto result = m_usersById.find(userId);
+	return result == m_usersById.end() ? nullptr : &m_users[result->second];
+}
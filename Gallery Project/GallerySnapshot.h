@@ -0,0 +1,34 @@
+#pragma once
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include "Album.h"
+#include "User.h"
+
+/*
+An immutable, point-in-time view of the whole gallery.
+The albums of the snapshot share their pictures with the data access albums they were
+taken from (see Album), so taking a snapshot copies no picture. A writer that changes
+an album afterwards gets its own copy of that album's pictures, while the snapshot
+keeps seeing the old ones - readers holding a snapshot never need a lock.
+*/
+class GallerySnapshot
+{
+public:
+	GallerySnapshot(unsigned long long version, const std::list<Album>& albums, const std::list<User>& users);
+
+	unsigned long long getVersion() const;
+
+	const std::vector<Album>& getAlbums() const;
+	const Album* findAlbum(int albumId) const;
+
+	const std::vector<User>& getUsers() const;
+	const User* findUser(int userId) const;
+
+private:
+	unsigned long long m_version;
+	std::vector<Album> m_albums;
+	std::vector<User> m_users;
+	std::unordered_map<int, size_t> m_albumsById;
+	std::unordered_map<int, size_t> m_usersById;
+};
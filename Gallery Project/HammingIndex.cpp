@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <numeric>
+#include "HammingIndex.h"
+#include "PerceptualHash.h"
+
+static bool byPictureId(const HammingIndex::PictureKey& first, const HammingIndex::PictureKey& second)
+{
+	return first.second < second.second;
+}
+
+// every 16 bit value ordered by the number of bits it has set, so the masks of up to n bits are a prefix
+static const std::vector<uint16_t>& masksByBitsCount()
+{
+	static const std::vector<uint16_t> masks = []() {
+		std::vector<uint16_t> values(1 << 16);
+		std::iota(values.begin(), values.end(), 0);
+		std::stable_sort(values.begin(), values.end(), [](uint16_t first, uint16_t second) {
+			return PerceptualHash::distance(first, 0) < PerceptualHash::distance(second, 0);
+		});
+		return values;
+	}();
+	return masks;
+}
+
+
+void HammingIndex::add(uint64_t hash, const PictureKey& picture)
+{
+	std::vector<PictureKey>& pictures = m_pictures[hash];
+	if (pictures.empty()) {
+		if (m_buckets.empty()) {
+			m_buckets.resize(CHUNKS * BUCKETS);
+		}
+		for (int index = 0; index < CHUNKS; ++index) {
+			bucket(hash, index).push_back(hash);
+		}
+	}
+
+	pictures.push_back(picture);
+	++m_picturesCount;
+}
+
+void HammingIndex::remove(uint64_t hash, const PictureKey& picture)
+{
+	auto sameHash = m_pictures.find(hash);
+	if (sameHash == m_pictures.end()) {
+		return;
+	}
+
+	auto& pictures = sameHash->second;
+	auto found = std::find(pictures.begin(), pictures.end(), picture);
+	if (found == pictures.end()) {
+		return;
+	}
+
+	pictures.erase(found);
+	--m_picturesCount;
+	if (pictures.empty()) {
+		m_pictures.erase(sameHash);
+		// the order of a bucket doesn't matter, the last hash takes the place of the removed one
+		for (int index = 0; index < CHUNKS; ++index) {
+			std::vector<uint64_t>& hashes = bucket(hash, index);
+			*std::find(hashes.begin(), hashes.end(), hash) = hashes.back();
+			hashes.pop_back();
+		}
+	}
+}
+
+void HammingIndex::clear()
+{
+	// new empty containers give their memory back
+	m_buckets = decltype(m_buckets)();
+	m_pictures = decltype(m_pictures)();
+	m_picturesCount = 0;
+}
+
+size_t HammingIndex::size() const
+{
+	return m_picturesCount;
+}
+
+/*
+This function finds the pictures whose hashes are within a distance of a hash
+input: the hash, the max distance (number of bits that may differ)
+output: the pictures, ordered by picture id
+*/
+std::vector<HammingIndex::PictureKey> HammingIndex::findSimilar(uint64_t hash, int maxDistance) const
+{
+	std::vector<PictureKey> similar;
+
+	search(hash, maxDistance, [&](uint64_t matchHash) {
+		const auto& pictures = m_pictures.at(matchHash);
+		similar.insert(similar.end(), pictures.begin(), pictures.end());
+	});
+
+	std::sort(similar.begin(), similar.end(), byPictureId);
+	return similar;
+}
+
+/*
+This function groups the pictures that are similar - two pictures are in a group if their
+hashes are within the distance, or if a chain of such pictures leads from one to the other
+input: the max distance (number of bits that may differ)
+output: the groups of more than one picture, the pictures of a group ordered by picture id,
+the groups ordered by their first picture id
+*/
+std::vector<std::vector<HammingIndex::PictureKey>> HammingIndex::findGroups(int maxDistance) const
+{
+	// union-find over the distinct hashes
+	std::unordered_map<uint64_t, size_t> hashIndex;
+	std::vector<uint64_t> hashes;
+	hashIndex.reserve(m_pictures.size());
+	hashes.reserve(m_pictures.size());
+	for (const auto& sameHash : m_pictures) {
+		hashIndex.emplace(sameHash.first, hashes.size());
+		hashes.push_back(sameHash.first);
+	}
+
+	std::vector<size_t> parent(hashes.size());
+	std::iota(parent.begin(), parent.end(), 0);
+	auto root = [&parent](size_t index) {
+		while (parent[index] != index) {
+			index = parent[index] = parent[parent[index]];
+		}
+		return index;
+	};
+
+	for (size_t index = 0; index < hashes.size(); ++index) {
+		search(hashes[index], maxDistance, [&](uint64_t matchHash) {
+			size_t first = root(index), second = root(hashIndex.at(matchHash));
+			if (first != second) {
+				parent[std::max(first, second)] = std::min(first, second);
+			}
+		});
+	}
+
+	std::unordered_map<size_t, std::vector<PictureKey>> groupsByRoot;
+	for (size_t index = 0; index < hashes.size(); ++index) {
+		const auto& pictures = m_pictures.at(hashes[index]);
+		auto& group = groupsByRoot[root(index)];
+		group.insert(group.end(), pictures.begin(), pictures.end());
+	}
+
+	std::vector<std::vector<PictureKey>> groups;
+	for (auto& group : groupsByRoot) {
+		if (group.second.size() > 1) {
+			std::sort(group.second.begin(), group.second.end(), byPictureId);
+			groups.push_back(std::move(group.second));
+		}
+	}
+	std::sort(groups.begin(), groups.end(), [](const std::vector<PictureKey>& first, const std::vector<PictureKey>& second) {
+		return byPictureId(first.front(), second.front());
+	});
+
+	return groups;
+}
+
+uint16_t HammingIndex::chunk(uint64_t hash, int index)
+{
+	return static_cast<uint16_t>(hash >> (index * CHUNK_BITS));
+}
+
+std::vector<uint64_t>& HammingIndex::bucket(uint64_t hash, int index)
+{
+	return m_buckets[index * BUCKETS + chunk(hash, index)];
+}
+
+// calls onMatch once with every hash within the distance
+template <class OnMatch>
+void HammingIndex::search(uint64_t hash, int maxDistance, OnMatch onMatch) const
+{
+	if (m_buckets.empty() || maxDistance < 0) {
+		return;
+	}
+
+	// a match has a chunk within this distance
+	const int chunkDistance = std::min(maxDistance / CHUNKS, CHUNK_BITS);
+	const std::vector<uint16_t>& masks = masksByBitsCount();
+
+	for (int index = 0; index < CHUNKS; ++index) {
+		const uint16_t ownChunk = chunk(hash, index);
+
+		for (uint16_t mask : masks) {
+			if (PerceptualHash::distance(mask, 0) > chunkDistance) {
+				break;
+			}
+
+			for (uint64_t candidate : m_buckets[index * BUCKETS + (ownChunk ^ mask)]) {
+				if (PerceptualHash::distance(hash, candidate) > maxDistance) {
+					continue;
+				}
+
+				// a match whose earlier chunk is close enough was already found in that chunk's table
+				bool foundBefore = false;
+				for (int earlier = 0; earlier < index && !foundBefore; ++earlier) {
+					foundBefore = PerceptualHash::distance(chunk(hash, earlier), chunk(candidate, earlier)) <= chunkDistance;
+				}
+				if (!foundBefore) {
+					onMatch(candidate);
+				}
+			}
+		}
+	}
+}
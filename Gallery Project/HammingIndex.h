@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+An index of perceptual hashes (see PerceptualHash), to find the pictures whose hashes are within
+a Hamming distance of a hash without comparing it to every other hash (multi-index hashing).
+A hash is cut into 4 chunks of 16 bits, and every chunk has a table of 2^16 buckets that holds
+every hash under the value of that chunk. Two hashes that are within r bits of each other have
+at least one chunk that is within r / 4 bits (if every chunk differed in more, the hashes would
+differ in more than r), so a search only reads the buckets within r / 4 bits of the hash's own
+chunks - for r = 10 that's 137 buckets of each table, out of 65536.
+Every distinct hash is kept once, the pictures that have it are kept next to the tables.
+*/
+class HammingIndex
+{
+public:
+	// album id, picture id
+	using PictureKey = std::pair<int, int>;
+
+	void add(uint64_t hash, const PictureKey& picture);
+	void remove(uint64_t hash, const PictureKey& picture);
+	void clear();
+	size_t size() const;
+
+	std::vector<PictureKey> findSimilar(uint64_t hash, int maxDistance) const;
+	std::vector<std::vector<PictureKey>> findGroups(int maxDistance) const;
+
+private:
+	static constexpr int CHUNKS = 4;
+	static constexpr int CHUNK_BITS = 16;
+	static constexpr size_t BUCKETS = size_t(1) << CHUNK_BITS;
+
+	// CHUNKS tables of BUCKETS buckets one after the other, allocated with the first hash
+	std::vector<std::vector<uint64_t>> m_buckets;
+	std::unordered_map<uint64_t, std::vector<PictureKey>> m_pictures;
+	size_t m_picturesCount { 0 };
+
+	static uint16_t chunk(uint64_t hash, int index);
+	std::vector<uint64_t>& bucket(uint64_t hash, int index);
+	template <class OnMatch>
+	void search(uint64_t hash, int maxDistance, OnMatch onMatch) const;
+};
@@ -2,6 +2,7 @@
 #include <list>
 #include "Album.h"
 #include "User.h"
+#include "GallerySnapshot.h"
 #include "sqlite3.h"
 #include <io.h>
 
@@ -11,21 +12,24 @@ public:
 	virtual ~IDataAccess() = default;
 
 	// album related
-	virtual const std::list<Album> getAlbums() = 0;
+	virtual std::list<Album> getAlbums() = 0;
 	virtual std::list<Album> getAlbumsOfUser(const User& user) = 0;
 	virtual void createAlbum(const Album& album) = 0;
+	virtual void importAlbums(const std::list<Album>& albums) = 0;
 	virtual void deleteAlbum(const std::string& albumName, int userId) = 0;
 	virtual bool doesAlbumExists(const std::string& albumName, int userId) = 0;
-	virtual Album openAlbum(const std::string& albumName) = 0;
+	virtual Album openAlbum(const std::string& albumName, int userId) = 0;
 	virtual Album getAlbumById(const int albumId) = 0;
-	virtual void closeAlbum(Album& pAlbum) = 0;
+	virtual void closeAlbum(const Album& pAlbum) = 0;
 	virtual void printAlbums() = 0;
+	virtual std::shared_ptr<const GallerySnapshot> getSnapshot() = 0;
 
     // picture related
-	virtual void addPictureToAlbumByName(const std::string& albumName, const Picture& picture) = 0;
-	virtual void removePictureFromAlbumByName(const std::string& albumName, const std::string& pictureName) = 0;
-	virtual void tagUserInPicture(const std::string& albumName, const std::string& pictureName, int userId) = 0;
-	virtual void untagUserInPicture(const std::string& albumName, const std::string& pictureName, int userId) = 0;
+	virtual void addPictureToAlbumByName(const std::string& albumName, int ownerId, const Picture& picture) = 0;
+	virtual void removePictureFromAlbumByName(const std::string& albumName, int ownerId, const std::string& pictureName) = 0;
+	virtual void tagUserInPicture(const std::string& albumName, int ownerId, const std::string& pictureName, int userId) = 0;
+	virtual void untagUserInPicture(const std::string& albumName, int ownerId, const std::string& pictureName, int userId) = 0;
+	virtual int getLastPictureId() = 0;
 
 	// user related
 	virtual void deleteUsersAlbums(const User& user) = 0;
@@ -34,7 +38,9 @@ public:
 	virtual void createUser(User& user ) = 0;
 	virtual void deleteUser(const User& user) = 0;
 	virtual bool doesUserExists(int userId) = 0 ;
+	virtual int getLastUserId() = 0;
 	virtual void deleteUserTags(const User& user) = 0;
+	virtual void deleteUserCascade(const User& user) = 0;
 	
 
 	// user statistics
@@ -47,16 +53,20 @@ public:
 	virtual User getTopTaggedUser() = 0;
 	virtual Picture getTopTaggedPicture() = 0;
 	virtual std::list<Picture> getTaggedPicturesOfUser(const User& user) = 0;
+	virtual std::list<User> getTopTaggedUsers(int count) = 0;
+	virtual std::list<Picture> getTopTaggedPictures(int count) = 0;
+	virtual std::list<Picture> getPicturesCreatedBetween(int64_t from, int64_t to) = 0;
+	virtual std::list<std::list<Picture>> getDuplicatePictures() = 0;
+	virtual std::list<std::list<Picture>> getSimilarPictures(int maxDistance) = 0;
+	virtual std::list<Picture> getPicturesLargerThan(const std::string& albumName, int ownerId, int pixels) = 0;
+	virtual std::list<Picture> getPicturesCapturedBetween(int64_t from, int64_t to) = 0;
+	virtual std::list<Picture> getPicturesOfCamera(const std::string& cameraModel) = 0;
 	
-	// callback functions
-	virtual int usersCallback(void* data, int argc, char** argv, char** azColName) = 0;
-	virtual int albumsCallback(void* data, int argc, char** argv, char** azColName) = 0;
-	virtual int picturesCallback(void* data, int argc, char** argv, char** azColName) = 0;
-	virtual int tagsCallback(void* data, int argc, char** argv, char** azColName) = 0;
-
 	virtual bool open() = 0;
 	virtual void close() = 0;
 	virtual void clear() = 0;
+	virtual void flush() = 0;
+	virtual bool saveSnapshot() = 0;
 	virtual bool runSqlCommand(std::string sqlStatement) = 0;
 	virtual void dropTables() = 0;
 };
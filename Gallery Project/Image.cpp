@@ -0,0 +1,442 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include "Image.h"
+
+// a bigger header is most likely a damaged file - it would take gigabytes to decode
+static const int64_t MAX_PIXELS_COUNT = 1 << 28;
+static const size_t BMP_FILE_HEADER_SIZE = 14;
+static const size_t BMP_INFO_HEADER_SIZE = 40;
+static const uint32_t BMP_RGB = 0;
+static const uint32_t BMP_BITFIELDS = 3;
+
+
+static inline uint16_t readLittle16(const unsigned char* bytes)
+{
+	return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+static inline uint32_t readLittle32(const unsigned char* bytes)
+{
+	return static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+		(static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+static inline void writeLittle16(unsigned char* bytes, uint16_t value)
+{
+	bytes[0] = static_cast<unsigned char>(value);
+	bytes[1] = static_cast<unsigned char>(value >> 8);
+}
+
+static inline void writeLittle32(unsigned char* bytes, uint32_t value)
+{
+	writeLittle16(bytes, static_cast<uint16_t>(value));
+	writeLittle16(bytes + 2, static_cast<uint16_t>(value >> 16));
+}
+
+// a plain loop over whole rows the compiler turns into vector instructions (the pointers never overlap)
+static void addRow(uint32_t* __restrict sums, const uint8_t* __restrict row, size_t size)
+{
+	for (size_t i = 0; i < size; ++i) {
+		sums[i] += row[i];
+	}
+}
+
+
+Image::Image(int width, int height) :
+	m_width(width), m_height(height), m_pixels(static_cast<size_t>(width) * height * CHANNELS)
+{
+	// Left empty
+}
+
+/*
+This function reads a picture file and decodes it
+input: the file path, the image to fill
+output: true if the file was decoded, false if it can't be read or its format isn't supported
+*/
+bool Image::load(const std::string& path, Image& image)
+{
+	FILE* file = std::fopen(path.c_str(), "rb");
+	if (nullptr == file) {
+		return false;
+	}
+
+	// the whole file is needed anyway, it's read in one go
+	std::vector<unsigned char> data;
+	bool succeeded = std::fseek(file, 0, SEEK_END) == 0;
+	long size = succeeded ? std::ftell(file) : -1;
+	succeeded = size > 0 && std::fseek(file, 0, SEEK_SET) == 0;
+	if (succeeded) {
+		data.resize(static_cast<size_t>(size));
+		std::setvbuf(file, nullptr, _IONBF, 0);
+		succeeded = std::fread(data.data(), 1, data.size(), file) == data.size();
+	}
+	std::fclose(file);
+
+	return succeeded && decode(data.data(), data.size(), image);
+}
+
+/*
+This function writes the image as a 24 bit uncompressed BMP file (any viewer opens it, and load() reads it back)
+input: the file path
+output: true if the file was written, false otherwise
+*/
+bool Image::saveBmp(const std::string& path) const
+{
+	if (isEmpty()) {
+		return false;
+	}
+
+	// rows are stored bottom up, BGR, every row padded to 4 bytes
+	const size_t rowSize = ((static_cast<size_t>(m_width) * CHANNELS + 3) / 4) * 4;
+	const size_t headersSize = BMP_FILE_HEADER_SIZE + BMP_INFO_HEADER_SIZE;
+	std::vector<unsigned char> data(headersSize + rowSize * m_height, 0);
+
+	data[0] = 'B';
+	data[1] = 'M';
+	writeLittle32(&data[2], static_cast<uint32_t>(data.size()));
+	writeLittle32(&data[10], static_cast<uint32_t>(headersSize));
+	unsigned char* info = &data[BMP_FILE_HEADER_SIZE];
+	writeLittle32(info, static_cast<uint32_t>(BMP_INFO_HEADER_SIZE));
+	writeLittle32(info + 4, static_cast<uint32_t>(m_width));
+	writeLittle32(info + 8, static_cast<uint32_t>(m_height));
+	writeLittle16(info + 12, 1);
+	writeLittle16(info + 14, 24);
+	writeLittle32(info + 16, BMP_RGB);
+	writeLittle32(info + 20, static_cast<uint32_t>(rowSize * m_height));
+
+	for (int y = 0; y < m_height; ++y) {
+		unsigned char* target = &data[headersSize + rowSize * (m_height - 1 - y)];
+		const uint8_t* pixel = getPixel(0, y);
+		for (int x = 0; x < m_width; ++x, pixel += CHANNELS, target += CHANNELS) {
+			target[0] = pixel[2];
+			target[1] = pixel[1];
+			target[2] = pixel[0];
+		}
+	}
+
+	FILE* file = std::fopen(path.c_str(), "wb");
+	if (nullptr == file) {
+		return false;
+	}
+	bool succeeded = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+	// a full disk may only show up when the buffer is flushed
+	succeeded = 0 == std::fclose(file) && succeeded;
+
+	return succeeded;
+}
+
+/*
+This function decodes a picture that was read into memory, its format is found by its first bytes
+input: the bytes of the file, their count, the image to fill
+output: true if the picture was decoded, false otherwise
+*/
+bool Image::decode(const unsigned char* data, size_t size, Image& image)
+{
+	if (size >= 2 && 'B' == data[0] && 'M' == data[1]) {
+		return decodeBmp(data, size, image);
+	}
+	if (size >= 2 && 'P' == data[0] && ('5' == data[1] || '6' == data[1])) {
+		return decodePpm(data, size, image);
+	}
+	return false;
+}
+
+/*
+This function checks by its extension if a file may be decoded natively
+input: the file path
+output: true if it's a BMP or a PPM / PGM file, false otherwise
+*/
+bool Image::isDecodable(const std::string& path)
+{
+	size_t dot = path.find_last_of('.');
+	if (dot == std::string::npos) {
+		return false;
+	}
+
+	std::string extension = path.substr(dot);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) {
+		return static_cast<char>(std::tolower(c));
+	});
+	return ".bmp" == extension || ".ppm" == extension || ".pgm" == extension;
+}
+
+int Image::getWidth() const
+{
+	return m_width;
+}
+
+int Image::getHeight() const
+{
+	return m_height;
+}
+
+bool Image::isEmpty() const
+{
+	return m_pixels.empty();
+}
+
+const uint8_t* Image::getPixel(int x, int y) const
+{
+	return m_pixels.data() + (static_cast<size_t>(y) * m_width + x) * CHANNELS;
+}
+
+uint8_t* Image::getPixel(int x, int y)
+{
+	return m_pixels.data() + (static_cast<size_t>(y) * m_width + x) * CHANNELS;
+}
+
+/*
+This function shrinks the image with a box filter - every pixel of the result is the average
+of the pixels it covers, so every pixel of the image is read once
+input: the size of the result (a size bigger than the image's takes its nearest pixels instead)
+output: the shrunk image
+*/
+Image Image::scaledDown(int width, int height) const
+{
+	Image result(width, height);
+	if (isEmpty() || result.isEmpty()) {
+		return result;
+	}
+
+	// the columns of the image every column of the result covers are columnStarts[x] to columnStarts[x + 1]
+	std::vector<int> columnStarts(static_cast<size_t>(width) + 1, m_width);
+	for (int x = m_width - 1; x >= 0; --x) {
+		columnStarts[static_cast<size_t>(static_cast<int64_t>(x) * width / m_width)] = x;
+	}
+	for (int targetX = width - 1; targetX >= 0; --targetX) {
+		// a column of the result that covers nothing (the result is wider than the image) starts where the next one does
+		columnStarts[targetX] = std::min(columnStarts[targetX], columnStarts[targetX + 1]);
+	}
+
+	// the rows that make one row of the result are first added up column by column (see addRow),
+	// then every run of columns is added up
+	const size_t rowSize = static_cast<size_t>(m_width) * CHANNELS;
+	std::vector<uint32_t> columnSums(rowSize);
+	std::vector<uint64_t> sums(static_cast<size_t>(width) * CHANNELS);
+
+	auto addColumnSums = [&]() {
+		for (int targetX = 0; targetX < width; ++targetX) {
+			uint64_t* sum = &sums[static_cast<size_t>(targetX) * CHANNELS];
+			for (int x = columnStarts[targetX]; x < columnStarts[targetX + 1]; ++x) {
+				const uint32_t* columnSum = &columnSums[static_cast<size_t>(x) * CHANNELS];
+				sum[0] += columnSum[0];
+				sum[1] += columnSum[1];
+				sum[2] += columnSum[2];
+			}
+		}
+		std::fill(columnSums.begin(), columnSums.end(), 0);
+	};
+
+	int y = 0;
+	for (int targetY = 0; targetY < height; ++targetY) {
+		std::fill(sums.begin(), sums.end(), 0);
+		uint32_t rowsCount = 0, summedRowsCount = 0;
+
+		for (; y < m_height && static_cast<int64_t>(y) * height / m_height == targetY; ++y) {
+			addRow(columnSums.data(), getPixel(0, y), rowSize);
+			++rowsCount;
+
+			// the sums of a column can't overflow before this many rows
+			if (++summedRowsCount == UINT32_MAX / UINT8_MAX) {
+				addColumnSums();
+				summedRowsCount = 0;
+			}
+		}
+		if (summedRowsCount > 0) {
+			addColumnSums();
+		}
+
+		for (int targetX = 0; targetX < width; ++targetX) {
+			uint8_t* target = result.getPixel(targetX, targetY);
+			uint64_t count = static_cast<uint64_t>(columnStarts[targetX + 1] - columnStarts[targetX]) * rowsCount;
+			if (count > 0) {
+				for (int channel = 0; channel < CHANNELS; ++channel) {
+					target[channel] = static_cast<uint8_t>((sums[static_cast<size_t>(targetX) * CHANNELS + channel] + count / 2) / count);
+				}
+			}
+			else {
+				// the result is bigger than the image here
+				const uint8_t* source = getPixel(static_cast<int>(static_cast<int64_t>(targetX) * m_width / width),
+					static_cast<int>(static_cast<int64_t>(targetY) * m_height / height));
+				std::memcpy(target, source, CHANNELS);
+			}
+		}
+	}
+
+	return result;
+}
+
+/*
+This function decodes an uncompressed BMP file (BITMAPINFOHEADER or a later version of it)
+input: the bytes of the file, their count, the image to fill
+output: true if the picture was decoded, false otherwise
+*/
+bool Image::decodeBmp(const unsigned char* data, size_t size, Image& image)
+{
+	if (size < BMP_FILE_HEADER_SIZE + BMP_INFO_HEADER_SIZE) {
+		return false;
+	}
+
+	const unsigned char* info = data + BMP_FILE_HEADER_SIZE;
+	uint32_t pixelsOffset = readLittle32(data + 10);
+	uint32_t infoSize = readLittle32(info);
+	int32_t width = static_cast<int32_t>(readLittle32(info + 4));
+	int32_t height = static_cast<int32_t>(readLittle32(info + 8));
+	uint16_t bitsPerPixel = readLittle16(info + 14);
+	uint32_t compression = readLittle32(info + 16);
+	uint32_t paletteSize = readLittle32(info + 32);
+
+	// a negative height is a picture stored from its top row
+	bool topDown = height < 0;
+	int64_t rows = topDown ? -static_cast<int64_t>(height) : height;
+
+	bool isFormatSupported = (BMP_RGB == compression && (1 == bitsPerPixel || 4 == bitsPerPixel || 8 == bitsPerPixel || 24 == bitsPerPixel || 32 == bitsPerPixel)) ||
+		(BMP_BITFIELDS == compression && 32 == bitsPerPixel);
+	if (infoSize < BMP_INFO_HEADER_SIZE || BMP_FILE_HEADER_SIZE + infoSize > pixelsOffset || !isFormatSupported || !isSizeValid(width, rows)) {
+		return false;
+	}
+
+	// rows are padded to 4 bytes
+	size_t rowSize = ((static_cast<size_t>(width) * bitsPerPixel + 31) / 32) * 4;
+	if (pixelsOffset > size || rowSize * rows > size - pixelsOffset) {
+		return false;
+	}
+
+	// a palette of BGRX entries follows the info header
+	const unsigned char* palette = info + infoSize;
+	size_t paletteCount = 0;
+	if (bitsPerPixel <= 8) {
+		paletteCount = paletteSize ? paletteSize : (size_t(1) << bitsPerPixel);
+		if (paletteCount > (pixelsOffset - BMP_FILE_HEADER_SIZE - infoSize) / 4) {
+			return false;
+		}
+	}
+
+	// the byte of the red / green / blue channels in a 32 bit pixel, the usual BGRX unless its masks say otherwise
+	int redByte = 2, greenByte = 1, blueByte = 0;
+	if (BMP_BITFIELDS == compression) {
+		// the red, green and blue masks are right after the BITMAPINFOHEADER fields
+		if (BMP_FILE_HEADER_SIZE + BMP_INFO_HEADER_SIZE + 12 > pixelsOffset) {
+			return false;
+		}
+		auto maskByte = [](uint32_t mask) {
+			for (int byte = 0; byte < 4; ++byte) {
+				if ((0xFFu << (byte * 8)) == mask) {
+					return byte;
+				}
+			}
+			return -1;
+		};
+		redByte = maskByte(readLittle32(info + 40));
+		greenByte = maskByte(readLittle32(info + 44));
+		blueByte = maskByte(readLittle32(info + 48));
+		if (redByte < 0 || greenByte < 0 || blueByte < 0) {
+			return false;
+		}
+	}
+
+	image = Image(width, static_cast<int>(rows));
+
+	for (int64_t row = 0; row < rows; ++row) {
+		const unsigned char* source = data + pixelsOffset + rowSize * (topDown ? row : rows - 1 - row);
+		uint8_t* target = image.getPixel(0, static_cast<int>(row));
+
+		for (int x = 0; x < width; ++x, target += CHANNELS) {
+			switch (bitsPerPixel) {
+			case 32:
+				target[0] = source[x * 4 + redByte];
+				target[1] = source[x * 4 + greenByte];
+				target[2] = source[x * 4 + blueByte];
+				break;
+			case 24:
+				target[0] = source[x * 3 + 2];
+				target[1] = source[x * 3 + 1];
+				target[2] = source[x * 3];
+				break;
+			default:
+			{
+				// the pixels of a byte are packed from its high bits
+				int pixelsPerByte = 8 / bitsPerPixel;
+				int shift = 8 - bitsPerPixel * (x % pixelsPerByte + 1);
+				size_t index = (source[x / pixelsPerByte] >> shift) & ((1 << bitsPerPixel) - 1);
+				if (index >= paletteCount) {
+					return false;
+				}
+				target[0] = palette[index * 4 + 2];
+				target[1] = palette[index * 4 + 1];
+				target[2] = palette[index * 4];
+				break;
+			}
+			}
+		}
+	}
+
+	return true;
+}
+
+/*
+This function decodes a binary PPM (P6) or PGM (P5) file, a PGM's gray is copied to every channel
+input: the bytes of the file, their count, the image to fill
+output: true if the picture was decoded, false otherwise
+*/
+bool Image::decodePpm(const unsigned char* data, size_t size, Image& image)
+{
+	size_t position = 2;
+	int64_t fields[3] = {};
+
+	// width, height and the max value, separated by white space and comments
+	for (int64_t& field : fields) {
+		while (position < size && (std::isspace(data[position]) || '#' == data[position])) {
+			if ('#' == data[position]) {
+				while (position < size && data[position] != '\n') {
+					++position;
+				}
+			}
+			else {
+				++position;
+			}
+		}
+		if (position >= size || !std::isdigit(data[position])) {
+			return false;
+		}
+		for (; position < size && std::isdigit(data[position]) && field < MAX_PIXELS_COUNT; ++position) {
+			field = field * 10 + (data[position] - '0');
+		}
+	}
+	// one white space character ends the header
+	++position;
+
+	int64_t width = fields[0], height = fields[1], maxValue = fields[2];
+	int channels = ('6' == data[1]) ? 3 : 1;
+	// values over 255 take two bytes, the most significant first
+	int valueSize = (maxValue > 255) ? 2 : 1;
+
+	if (!isSizeValid(width, height) || maxValue <= 0 || maxValue > 65535 ||
+		position > size || static_cast<uint64_t>(width * height * channels * valueSize) > size - position)
+	{
+		return false;
+	}
+
+	image = Image(static_cast<int>(width), static_cast<int>(height));
+	const unsigned char* source = data + position;
+	uint8_t* target = image.getPixel(0, 0);
+
+	for (int64_t pixel = 0; pixel < width * height; ++pixel, target += CHANNELS) {
+		for (int channel = 0; channel < channels; ++channel, source += valueSize) {
+			uint32_t value = (2 == valueSize) ? static_cast<uint32_t>((source[0] << 8) | source[1]) : source[0];
+			target[channel] = static_cast<uint8_t>((value * 255 + maxValue / 2) / maxValue);
+		}
+		if (1 == channels) {
+			target[1] = target[2] = target[0];
+		}
+	}
+
+	return true;
+}
+
+bool Image::isSizeValid(int64_t width, int64_t height)
+{
+	return width > 0 && height > 0 && width * height <= MAX_PIXELS_COUNT;
+}
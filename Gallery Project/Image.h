@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+A decoded picture - 8 bit RGB pixels, row after row from the top left corner.
+Only the formats that need no codec library are decoded natively: uncompressed BMP
+(24 / 32 bits per pixel, or 1 / 4 / 8 bits with a palette) and binary PPM / PGM (P6 / P5).
+*/
+class Image
+{
+public:
+	static const int CHANNELS = 3;
+
+	Image() = default;
+	Image(int width, int height);
+
+	static bool load(const std::string& path, Image& image);
+	static bool decode(const unsigned char* data, size_t size, Image& image);
+	static bool isDecodable(const std::string& path);
+	bool saveBmp(const std::string& path) const;
+
+	int getWidth() const;
+	int getHeight() const;
+	bool isEmpty() const;
+	const uint8_t* getPixel(int x, int y) const;
+	uint8_t* getPixel(int x, int y);
+
+	Image scaledDown(int width, int height) const;
+
+private:
+	int m_width { 0 };
+	int m_height { 0 };
+	std::vector<uint8_t> m_pixels;
+
+	static bool decodeBmp(const unsigned char* data, size_t size, Image& image);
+	static bool decodePpm(const unsigned char* data, size_t size, Image& image);
+	static bool isSizeValid(int64_t width, int64_t height);
+};
@@ -0,0 +1,319 @@
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include "ImageHeader.h"
+
+// the first read of a file - every header but a JPEG's is in it
+static const size_t BLOCK_SIZE = 4096;
+// a JPEG has a few metadata segments before its frame header, a lot more is most likely a damaged file
+static const int MAX_JPEG_SEGMENTS = 64;
+
+
+static inline uint16_t readLittle16(const unsigned char* bytes)
+{
+	return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+static inline uint32_t readLittle32(const unsigned char* bytes)
+{
+	return static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+		(static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+static inline uint16_t readBig16(const unsigned char* bytes)
+{
+	return static_cast<uint16_t>((bytes[0] << 8) | bytes[1]);
+}
+
+static inline uint32_t readBig32(const unsigned char* bytes)
+{
+	return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) |
+		(static_cast<uint32_t>(bytes[2]) << 8) | static_cast<uint32_t>(bytes[3]);
+}
+
+
+// reads a file a block at a time - the small reads of a header that are close to each other cost one read of the file
+class ImageHeader::BlockReader
+{
+public:
+	explicit BlockReader(FILE* file) :
+		m_file(file)
+	{
+		// Left empty
+	}
+
+	bool read(uint64_t offset, unsigned char* bytes, size_t count)
+	{
+		if (offset < m_blockOffset || offset + count > m_blockOffset + m_blockSize) {
+			if (count > BLOCK_SIZE || offset > LONG_MAX || std::fseek(m_file, static_cast<long>(offset), SEEK_SET) != 0) {
+				return false;
+			}
+			m_blockOffset = offset;
+			m_blockSize = std::fread(m_block, 1, BLOCK_SIZE, m_file);
+			if (count > m_blockSize) {
+				return false;
+			}
+		}
+
+		std::memcpy(bytes, m_block + (offset - m_blockOffset), count);
+		return true;
+	}
+
+private:
+	FILE* m_file;
+	unsigned char m_block[BLOCK_SIZE];
+	uint64_t m_blockOffset { 0 };
+	size_t m_blockSize { 0 };
+};
+
+
+/*
+This function reads the format and size of a picture from the header of its file
+input: the file path, the header to fill
+output: true if the format is known and the size was read, false otherwise
+(the size of the file is filled anyway when the file exists)
+*/
+bool ImageHeader::read(const std::string& path, ImageHeader& header)
+{
+	std::error_code error;
+	uint64_t fileSize = std::filesystem::file_size(path, error);
+	if (error) {
+		return false;
+	}
+
+	header = ImageHeader();
+	header.fileSize = fileSize;
+
+	FILE* file = std::fopen(path.c_str(), "rb");
+	if (nullptr == file) {
+		return false;
+	}
+
+	// every read of the reader is one read of the file, the stream doesn't read ahead of it
+	std::setvbuf(file, nullptr, _IONBF, 0);
+	BlockReader reader(file);
+
+	// the format is told by the first bytes, not by the extension
+	unsigned char magic[2] = {};
+	ImageHeader result = header;
+	bool succeeded = false;
+	if (reader.read(0, magic, sizeof(magic))) {
+		if ('B' == magic[0] && 'M' == magic[1]) {
+			succeeded = readBmp(reader, result);
+		}
+		else if (0x89 == magic[0] && 'P' == magic[1]) {
+			succeeded = readPng(reader, result);
+		}
+		else if (0xFF == magic[0] && 0xD8 == magic[1]) {
+			succeeded = readJpeg(reader, result);
+		}
+		else if ('G' == magic[0] && 'I' == magic[1]) {
+			succeeded = readGif(reader, result);
+		}
+		else if ('P' == magic[0] && magic[1] >= '1' && magic[1] <= '6') {
+			succeeded = readPpm(reader, result);
+		}
+	}
+	std::fclose(file);
+
+	if (!succeeded || result.width <= 0 || result.height <= 0) {
+		return false;
+	}
+
+	header = result;
+	return true;
+}
+
+/*
+This function returns the name of a format, to show it
+input: the format
+output: its name
+*/
+const char* ImageHeader::formatName(ImageFormat format)
+{
+	switch (format) {
+	case ImageFormat::BMP:
+		return "BMP";
+	case ImageFormat::PNG:
+		return "PNG";
+	case ImageFormat::JPEG:
+		return "JPEG";
+	case ImageFormat::GIF:
+		return "GIF";
+	case ImageFormat::PPM:
+		return "PPM";
+	default:
+		return "unknown";
+	}
+}
+
+bool ImageHeader::readBmp(BlockReader& reader, ImageHeader& header)
+{
+	// the file header, then the size of the info header and the size fields
+	unsigned char bytes[26];
+	if (!reader.read(0, bytes, sizeof(bytes))) {
+		return false;
+	}
+
+	header.format = ImageFormat::BMP;
+	if (12 == readLittle32(bytes + 14)) {
+		// the old OS/2 header, its sizes are 16 bits
+		header.width = readLittle16(bytes + 18);
+		header.height = readLittle16(bytes + 20);
+		return true;
+	}
+
+	// a negative height is a picture stored top down
+	int64_t width = static_cast<int32_t>(readLittle32(bytes + 18));
+	int64_t height = static_cast<int32_t>(readLittle32(bytes + 22));
+	height = height < 0 ? -height : height;
+	if (width > INT_MAX || height > INT_MAX) {
+		return false;
+	}
+
+	header.width = static_cast<int>(width);
+	header.height = static_cast<int>(height);
+	return true;
+}
+
+bool ImageHeader::readPng(BlockReader& reader, ImageHeader& header)
+{
+	static const unsigned char SIGNATURE[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+	// the signature, then the IHDR chunk (its length, its type, the width and the height) is always first
+	unsigned char bytes[24];
+	if (!reader.read(0, bytes, sizeof(bytes)) || std::memcmp(bytes, SIGNATURE, sizeof(SIGNATURE)) != 0 ||
+		std::memcmp(bytes + 12, "IHDR", 4) != 0)
+	{
+		return false;
+	}
+
+	uint32_t width = readBig32(bytes + 16);
+	uint32_t height = readBig32(bytes + 20);
+	if (width > INT_MAX || height > INT_MAX) {
+		return false;
+	}
+
+	header.format = ImageFormat::PNG;
+	header.width = static_cast<int>(width);
+	header.height = static_cast<int>(height);
+	return true;
+}
+
+bool ImageHeader::readJpeg(BlockReader& reader, ImageHeader& header)
+{
+	uint64_t offset = 2;
+
+	// every segment starts with a marker and its length, the metadata segments (EXIF, its thumbnail, ICC
+	// profiles) are skipped by their length until the frame header, which comes before the image data
+	for (int segment = 0; segment < MAX_JPEG_SEGMENTS; ++segment) {
+		unsigned char marker[4];
+		if (!reader.read(offset, marker, 2) || marker[0] != 0xFF) {
+			return false;
+		}
+
+		if (0xFF == marker[1]) {
+			// a fill byte before the marker
+			++offset;
+			continue;
+		}
+		if (0x01 == marker[1] || (marker[1] >= 0xD0 && marker[1] <= 0xD7)) {
+			// a marker without a length
+			offset += 2;
+			continue;
+		}
+		if (0xD9 == marker[1] || 0xDA == marker[1]) {
+			// the end of the picture or the start of the image data, with no frame header
+			return false;
+		}
+
+		if (!reader.read(offset + 2, marker + 2, 2)) {
+			return false;
+		}
+		uint16_t length = readBig16(marker + 2);
+		if (length < 2) {
+			return false;
+		}
+
+		// SOF0 to SOF15, except DHT, JPG and DAC that share their range
+		if (marker[1] >= 0xC0 && marker[1] <= 0xCF && marker[1] != 0xC4 && marker[1] != 0xC8 && marker[1] != 0xCC) {
+			// the precision, then the height and the width
+			unsigned char frame[5];
+			if (length < 2 + sizeof(frame) || !reader.read(offset + 4, frame, sizeof(frame))) {
+				return false;
+			}
+
+			header.format = ImageFormat::JPEG;
+			header.height = readBig16(frame + 1);
+			header.width = readBig16(frame + 3);
+			return true;
+		}
+
+		offset += 2 + length;
+	}
+
+	return false;
+}
+
+bool ImageHeader::readGif(BlockReader& reader, ImageHeader& header)
+{
+	// the signature and version, then the size of the logical screen
+	unsigned char bytes[10];
+	if (!reader.read(0, bytes, sizeof(bytes)) || (std::memcmp(bytes, "GIF87a", 6) != 0 && std::memcmp(bytes, "GIF89a", 6) != 0)) {
+		return false;
+	}
+
+	header.format = ImageFormat::GIF;
+	header.width = readLittle16(bytes + 6);
+	header.height = readLittle16(bytes + 8);
+	return true;
+}
+
+bool ImageHeader::readPpm(BlockReader& reader, ImageHeader& header)
+{
+	uint64_t offset = 2;
+
+	// the width and the height are text, separated by white space and comments (from # to the end of the line)
+	auto readNumber = [&reader, &offset](int& number) {
+		unsigned char c = 0;
+		bool inComment = false;
+		while (true) {
+			if (offset >= BLOCK_SIZE || !reader.read(offset, &c, 1)) {
+				return false;
+			}
+			if ('#' == c) {
+				inComment = true;
+			}
+			else if ('\n' == c || '\r' == c) {
+				inComment = false;
+			}
+			else if (!inComment && !std::isspace(c)) {
+				break;
+			}
+			++offset;
+		}
+
+		int64_t value = 0;
+		if (!std::isdigit(c)) {
+			return false;
+		}
+		while (std::isdigit(c)) {
+			value = value * 10 + (c - '0');
+			if (value > INT_MAX) {
+				return false;
+			}
+			++offset;
+			if (offset >= BLOCK_SIZE || !reader.read(offset, &c, 1)) {
+				break;
+			}
+		}
+
+		number = static_cast<int>(value);
+		return true;
+	};
+
+	header.format = ImageFormat::PPM;
+	return readNumber(header.width) && readNumber(header.height);
+}
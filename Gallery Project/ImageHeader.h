@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// the formats are stored by their number (in the DB, the snapshot and the log) - new ones go last
+enum class ImageFormat : uint8_t
+{
+	UNKNOWN = 0,
+	BMP,
+	PNG,
+	JPEG,
+	GIF,
+	PPM
+};
+
+/*
+The format, size in pixels and size on disk of a picture file, read from the first bytes of the
+file without decoding it: the BMP / PNG / GIF / PPM headers, and the frame header (SOF marker)
+of a JPEG, which is reached by skipping from segment to segment.
+Only a few small reads are made - usually one read of the first block of the file, and for a
+JPEG one more read past the metadata segments.
+*/
+class ImageHeader
+{
+public:
+	ImageFormat format { ImageFormat::UNKNOWN };
+	int width { 0 };
+	int height { 0 };
+	uint64_t fileSize { 0 };
+
+	static bool read(const std::string& path, ImageHeader& header);
+	static const char* formatName(ImageFormat format);
+
+private:
+	class BlockReader;
+
+	static bool readBmp(BlockReader& reader, ImageHeader& header);
+	static bool readPng(BlockReader& reader, ImageHeader& header);
+	static bool readJpeg(BlockReader& reader, ImageHeader& header);
+	static bool readGif(BlockReader& reader, ImageHeader& header);
+	static bool readPpm(BlockReader& reader, ImageHeader& header);
+};
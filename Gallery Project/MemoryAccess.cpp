@@ -1,11 +1,21 @@
 ﻿#include <map>
 #include <algorithm>
+#include <chrono>
+#include <cstring>
 
 #include "ItemNotFoundException.h"
 #include "MemoryAccess.h"
+#include "SnapshotFile.h"
 
 
 
+MemoryAccess::MemoryAccess() :
+	m_index(m_albums, m_users)
+{
+	this->snapshotFileName = "MyGallery.snapshot";
+	this->logFileName = "MyGallery.log";
+}
+
 void MemoryAccess::printAlbums() 
 {
 	if(m_albums.empty()) {
@@ -18,31 +28,68 @@ void MemoryAccess::printAlbums()
 	}
 }
 
+/*
+This function loads the gallery - from the snapshot file, and then the changes since the snapshot from the operation log.
+A new gallery (without a snapshot or logged changes) starts with some dummy users and albums.
+input: none
+output: true if the gallery was loaded, false otherwise
+*/
 bool MemoryAccess::open()
 {
-	// create some dummy albums
-	for (int i=0; i<5; ++i) {
-		// create some dummy users
-		std::stringstream name("User_"+std::to_string(i));
+	auto startTime = std::chrono::steady_clock::now();
+	uint64_t stamp = 0;
+	size_t replayed = 0;
+
+	clear();
+	m_lastAlbumId = 0;
+
+	bool success = loadSnapshot(stamp) && m_log.open(logFileName, stamp, [this, &replayed](const OperationLog::Entry& entry) {
+		replay(entry);
+		++replayed;
+	});
+	if (!success)
+	{
+		std::cout << "Failed to load gallery" << std::endl;
+		clear();
+		return false;
+	}
+
+	if (0 == stamp && 0 == replayed) {
+		// create some dummy albums
+		for (int i=0; i<5; ++i) {
+			// create some dummy users
+			std::stringstream name("User_"+std::to_string(i));
 
-		User user(i, name.str());
-		createUser(user);
+			User user(i, name.str());
+			createUser(user);
 
-		m_albums.push_back(createDummyAlbum(user));
+			createAlbum(createDummyAlbum(user));
+		}
 	}
 
+	std::chrono::duration<double> loadTime = std::chrono::steady_clock::now() - startTime;
+	std::cout << "Loaded " << m_users.size() << " users and " << m_albums.size() << " albums (" << replayed << " changes replayed from the log) in "
+		<< std::fixed << std::setprecision(3) << loadTime.count() << " sec" << std::defaultfloat << std::endl;
 	return true;
 }
 
+void MemoryAccess::close()
+{
+	m_log.close();
+}
+
 void MemoryAccess::clear()
 {
+	invalidateSnapshot();
+
+	m_index.clear();
 	m_users.clear();
 	m_albums.clear();
 }
 
-auto MemoryAccess::getAlbumIfExists(const std::string & albumName)
+auto MemoryAccess::getAlbumIfExists(const std::string & albumName, int ownerId)
 {
-	auto result = std::find_if(std::begin(m_albums), std::end(m_albums), [&](auto& album) { return album.getName() == albumName; });
+	auto result = m_index.findAlbum(albumName, ownerId);
 
 	if (result == std::end(m_albums)) {
 		throw ItemNotFoundException("Album not exists: ", albumName);
@@ -69,89 +116,241 @@ Album MemoryAccess::createDummyAlbum(const User& user)
 	return album;
 }
 
-const std::list<Album> MemoryAccess::getAlbums() 
+std::list<Album> MemoryAccess::getAlbums() 
 {
 	return m_albums;
 }
 
-std::list<Album> MemoryAccess::getAlbumsOfUser(const User& user) 
-{	
+std::list<Album> MemoryAccess::getAlbumsOfUser(const User& user)
+{
 	std::list<Album> albumsOfUser;
-	for (const auto& album: m_albums) {
-		if (album.getOwnerId() == user.getId()) {
-			albumsOfUser.push_back(album);
-		}
+	for (auto album : m_index.findAlbumsOfUser(user.getId())) {
+		albumsOfUser.push_back(*album);
 	}
 	return albumsOfUser;
 }
 
 void MemoryAccess::createAlbum(const Album& album)
 {
-	m_albums.push_back(album);
+	invalidateSnapshot();
+
+	// like the DB, the album id is given by the data access
+	Album createdAlbum(album.getOwnerId(), album.getName(), album.getCreationTime());
+	createdAlbum.setId(m_lastAlbumId + 1);
+	createdAlbum.reservePictures(album.getPictures().size());
+	auto created = addAlbumToGallery(createdAlbum);
+
+	logOperation({ OperationLog::Operation::CREATE_ALBUM, { created->getId(), created->getOwnerId(), created->getCreationTime() }, { created->getName() } });
+
+	// added one by one, so a compaction of the log between two pictures saves only the pictures that were logged
+	for (const Picture& picture : album.getPictures()) {
+		addPictureToAlbum(created, picture);
+	}
+}
+
+/*
+This function creates albums together with their pictures, the pictures keep the ids they were given
+input: the albums
+output: none
+*/
+void MemoryAccess::importAlbums(const std::list<Album>& albums)
+{
+	for (const Album& album : albums) {
+		createAlbum(album);
+	}
 }
 
 void MemoryAccess::deleteAlbum(const std::string& albumName, int userId)
 {
-	for (auto iter = m_albums.begin(); iter != m_albums.end(); iter++) {
-		if ( iter->getName() == albumName && iter->getOwnerId() == userId ) {
-			iter = m_albums.erase(iter);
-			return;
-		}
+	invalidateSnapshot();
+
+	auto album = m_index.findAlbum(albumName, userId);
+	if (album != m_albums.end()) {
+		removeAlbumFromGallery(album);
 	}
 }
 
+/*
+This function adds an album, with its id, to the gallery
+input: the album
+output: the album in the gallery
+*/
+std::list<Album>::iterator MemoryAccess::addAlbumToGallery(const Album& album)
+{
+	m_albums.push_back(album);
+	m_lastAlbumId = std::max(m_lastAlbumId, album.getId());
+
+	auto added = std::prev(m_albums.end());
+	m_index.addAlbum(added);
+	return added;
+}
+
+void MemoryAccess::removeAlbumFromGallery(std::list<Album>::iterator album)
+{
+	int albumId = album->getId();
+
+	m_index.removeAlbum(album);
+	m_albums.erase(album);
+
+	logOperation({ OperationLog::Operation::DELETE_ALBUM, { albumId }, {} });
+}
+
 bool MemoryAccess::doesAlbumExists(const std::string& albumName, int userId) 
 {
-	for (const auto& album: m_albums) {
-		if ( (album.getName() == albumName) && (album.getOwnerId() == userId) ) {
-			return true;
-		}
+	return m_index.findAlbum(albumName, userId) != m_albums.end();
+}
+
+Album MemoryAccess::openAlbum(const std::string& albumName, int userId) 
+{
+	auto album = m_index.findAlbum(albumName, userId);
+	if (album == m_albums.end()) {
+		throw MyException("No album with name " + albumName + " of user @" + std::to_string(userId) + " exists");
 	}
 
-	return false;
+	return *album;
 }
 
-Album MemoryAccess::openAlbum(const std::string& albumName) 
+Album MemoryAccess::getAlbumById(const int albumId)
 {
-	for (auto& album: m_albums)	{
-		if (albumName == album.getName()) {
-			return album;
+	auto album = m_index.findAlbum(albumId);
+	if (album == m_albums.end()) {
+		throw ItemNotFoundException("Album", albumId);
+	}
+
+	return *album;
+}
+
+void MemoryAccess::addPictureToAlbumByName(const std::string& albumName, int ownerId, const Picture& picture) 
+{
+	invalidateSnapshot();
+	addPictureToAlbum(getAlbumIfExists(albumName, ownerId), picture);
+}
+
+/*
+This function returns the biggest picture id of the gallery, so new pictures are given ids after it
+input: none
+output: the id, 0 if there are no pictures
+*/
+int MemoryAccess::getLastPictureId()
+{
+	int lastPictureId = 0;
+	for (const Album& album : m_albums) {
+		for (const Picture& picture : album.getPictures()) {
+			lastPictureId = std::max(lastPictureId, picture.getId());
 		}
 	}
-	throw MyException("No album with name " + albumName + " exists");
+
+	return lastPictureId;
+}
+
+void MemoryAccess::removePictureFromAlbumByName(const std::string& albumName, int ownerId, const std::string& pictureName) 
+{
+	invalidateSnapshot();
+	removePictureFromAlbum(getAlbumIfExists(albumName, ownerId), pictureName);
+}
+
+void MemoryAccess::tagUserInPicture(const std::string& albumName, int ownerId, const std::string& pictureName, int userId)
+{
+	invalidateSnapshot();
+	tagUserInPicture(getAlbumIfExists(albumName, ownerId), pictureName, userId);
+}
+
+void MemoryAccess::untagUserInPicture(const std::string& albumName, int ownerId, const std::string& pictureName, int userId)
+{
+	invalidateSnapshot();
+	untagUserInPicture(getAlbumIfExists(albumName, ownerId), pictureName, userId);
+}
+
+// the changes of pictures are logged by album id, since album names repeat between users
+void MemoryAccess::addPictureToAlbum(std::list<Album>::iterator album, const Picture& picture)
+{
+	(*album).addPicture(picture);
+	m_index.addPicture(album->getId(), picture);
+
+	logOperation(addPictureEntry(album->getId(), picture));
+}
+
+/*
+This function builds the log entry of a picture that was added to an album (replay() reads it back)
+input: the album id, the picture
+output: the entry - its numbers are the album id, the picture id, its creation time, its hashes,
+its width, height, format and file size, its capture time, whether it has a location and the bits of
+its latitude and longitude, then the ids of the users tagged in it; its texts are the name, the path
+and the camera model
+*/
+OperationLog::Entry MemoryAccess::addPictureEntry(int albumId, const Picture& picture)
+{
+	const ExifMetadata& metadata = picture.getMetadata();
+	int64_t latitudeBits = 0, longitudeBits = 0;
+	std::memcpy(&latitudeBits, &metadata.latitude, sizeof(latitudeBits));
+	std::memcpy(&longitudeBits, &metadata.longitude, sizeof(longitudeBits));
+
+	OperationLog::Entry entry { OperationLog::Operation::ADD_PICTURE, { albumId, picture.getId(), picture.getCreationTime(),
+		static_cast<int64_t>(picture.getContentHash()), static_cast<int64_t>(picture.getPerceptualHash()),
+		picture.getWidth(), picture.getHeight(), static_cast<int64_t>(picture.getFormat()), static_cast<int64_t>(picture.getFileSize()),
+		metadata.captureTime, metadata.hasLocation ? 1 : 0, latitudeBits, longitudeBits },
+		{ picture.getName(), picture.getPath(), metadata.cameraModel } };
+	entry.numbers.insert(entry.numbers.end(), picture.getUserTags().begin(), picture.getUserTags().end());
+	return entry;
 }
 
-void MemoryAccess::addPictureToAlbumByName(const std::string& albumName, const Picture& picture) 
+void MemoryAccess::removePictureFromAlbum(std::list<Album>::iterator album, const std::string& pictureName)
 {
-	auto result = getAlbumIfExists(albumName);
+	// the name may belong to the picture itself, and its place is taken by another picture when it's removed
+	OperationLog::Entry entry { OperationLog::Operation::REMOVE_PICTURE, { album->getId() }, { pictureName } };
 
-	(*result).addPicture(picture);
+	m_index.removePicture(album->getId(), (*album).getPicture(pictureName));
+	(*album).removePicture(pictureName);
+
+	logOperation(entry);
 }
 
-void MemoryAccess::removePictureFromAlbumByName(const std::string& albumName, const std::string& pictureName) 
+void MemoryAccess::tagUserInPicture(std::list<Album>::iterator album, const std::string& pictureName, int userId)
 {
-	auto result = getAlbumIfExists(albumName);
+	(*album).tagUserInPicture(userId, pictureName);
+	m_index.addTag(userId, album->getId(), (*album).getPicture(pictureName).getId());
 
-	(*result).removePicture(pictureName);
+	logOperation({ OperationLog::Operation::TAG_USER, { album->getId(), userId }, { pictureName } });
 }
 
-void MemoryAccess::tagUserInPicture(const std::string& albumName, const std::string& pictureName, int userId)
+void MemoryAccess::untagUserInPicture(std::list<Album>::iterator album, const std::string& pictureName, int userId)
 {
-	auto result = getAlbumIfExists(albumName);
+	(*album).untagUserInPicture(userId, pictureName);
+	m_index.removeTag(userId, album->getId(), (*album).getPicture(pictureName).getId());
 
-	(*result).tagUserInPicture(userId, pictureName);
+	logOperation({ OperationLog::Operation::UNTAG_USER, { album->getId(), userId }, { pictureName } });
 }
 
-void MemoryAccess::untagUserInPicture(const std::string& albumName, const std::string& pictureName, int userId)
+void MemoryAccess::closeAlbum(const Album&) 
+{
+	// nothing to release, openAlbum hands out a copy of the stored album
+}
+
+/*
+This function returns a snapshot of the gallery as it is now.
+The snapshot is built once per version of the gallery and shared by all the readers of that version.
+input: none
+output: the snapshot
+*/
+std::shared_ptr<const GallerySnapshot> MemoryAccess::getSnapshot()
 {
-	auto result = getAlbumIfExists(albumName);
+	if (!m_snapshot) {
+		m_snapshot = std::make_shared<const GallerySnapshot>(m_version, m_albums, m_users);
+	}
 
-	(*result).untagUserInPicture(userId, pictureName);
+	return m_snapshot;
 }
 
-void MemoryAccess::closeAlbum(Album& ) 
+/*
+This function must be called before every change of the gallery. It drops the cached
+snapshot first, so albums that no reader holds anymore are changed in place and not copied.
+input: none
+output: none
+*/
+void MemoryAccess::invalidateSnapshot()
 {
-	// basically here we would like to delete the allocated memory we got from openAlbum
+	m_snapshot.reset();
+	++m_version;
 }
 
 // ******************* User ******************* 
@@ -165,43 +364,60 @@ void MemoryAccess::printUsers()
 }
 
 User MemoryAccess::getUser(int userId) {
-	for (const auto& user : m_users) {
-		if (user.getId() == userId) {
-			return user;
-		}
+	auto user = m_index.findUser(userId);
+	if (user == m_users.end()) {
+		throw ItemNotFoundException("User", userId);
 	}
 
-	throw ItemNotFoundException("User", userId);
+	return *user;
 }
 
 void MemoryAccess::createUser(User& user)
 {
+	// like the primary key of the DB - the caller must not report the user as created
+	if (m_index.findUser(user.getId()) != m_users.end()) {
+		throw MyException("Failed to create user, a user with id @" + std::to_string(user.getId()) + " already exists");
+	}
+
+	invalidateSnapshot();
+
 	m_users.push_back(user);
+	m_index.addUser(std::prev(m_users.end()));
+
+	logOperation({ OperationLog::Operation::CREATE_USER, { user.getId() }, { user.getName() } });
 }
 
 void MemoryAccess::deleteUser(const User& user)
 {
-	if (doesUserExists(user.getId())) {
-	
-		for (auto iter = m_users.begin(); iter != m_users.end(); ++iter) {
-			if (*iter == user) {
-				iter = m_users.erase(iter);
-				return;
-			}
-		}
+	invalidateSnapshot();
+
+	auto iter = m_index.findUser(user.getId());
+	if (iter != m_users.end()) {
+		m_index.removeUser(iter);
+		m_users.erase(iter);
+
+		logOperation({ OperationLog::Operation::DELETE_USER, { user.getId() }, {} });
 	}
 }
 
 bool MemoryAccess::doesUserExists(int userId) 
 {
-	auto iter = m_users.begin();
-	for (const auto& user : m_users) {
-		if (user.getId() == userId) {
-			return true;
-		}
+	return m_index.findUser(userId) != m_users.end();
+}
+
+/*
+This function returns the biggest user id of the gallery, so new users are given ids after it
+input: none
+output: the id, 0 if there are no users
+*/
+int MemoryAccess::getLastUserId()
+{
+	int lastUserId = 0;
+	for (const User& user : m_users) {
+		lastUserId = std::max(lastUserId, user.getId());
 	}
-	
-	return false;
+
+	return lastUserId;
 }
 
 /*
@@ -219,9 +435,9 @@ void MemoryAccess::deleteUsersAlbums(const User& user)
 		}
 	}
 
-	catch (std::exception& e)
+	catch (std::exception&)
 	{
-		throw e;
+		throw;
 	}
 }
 
@@ -232,73 +448,81 @@ output: none
 */
 void MemoryAccess::deleteUserTags(const User& user)
 {
-	try
-	{
-		for (const auto& album : m_albums) {
-			const std::list<Picture>& pics = album.getPictures();
+	invalidateSnapshot();
 
-			for (const auto& picture : pics) {
-				if (picture.isUserTagged(user)) {
-					untagUserInPicture(album.getName(), picture.getName(), user.getId());
-				}
-			}
+	// copied, since the index entries are removed while iterating
+	const GalleryIndex::TaggedPictures taggedPictures = m_index.getTaggedPicturesOfUser(user.getId());
+	for (const auto& albumPictures : taggedPictures) {
+		auto album = m_index.findAlbum(albumPictures.first);
+
+		for (int pictureId : albumPictures.second) {
+			album->untagUserInPicture(user.getId(), pictureId);
+			m_index.removeTag(user.getId(), albumPictures.first, pictureId);
 		}
 	}
 
-	catch (std::exception& e)
-	{
-		throw e;
-	}
+	logOperation({ OperationLog::Operation::DELETE_USER_TAGS, { user.getId() }, {} });
 }
 
 
-// user statistics
-int MemoryAccess::countAlbumsOwnedOfUser(const User& user) 
+/*
+This function deletes a user together with its tags and its albums
+input: the user
+output: none
+*/
+void MemoryAccess::deleteUserCascade(const User& user)
 {
-	int albumsCount = 0;
+	invalidateSnapshot();
+	removeUserFromGallery(user);
 
-	for (const auto& album: m_albums) {
-		if (album.getOwnerId() == user.getId()) {
-			++albumsCount;
-		}
-	}
-
-	return albumsCount;
+	logOperation({ OperationLog::Operation::DELETE_USER_CASCADE, { user.getId() }, {} });
 }
 
-int MemoryAccess::countAlbumsTaggedOfUser(const User& user) 
+/*
+This function removes a user, its tags and its albums from the gallery
+input: the user
+output: none
+*/
+void MemoryAccess::removeUserFromGallery(const User& user)
 {
-	int albumsCount = 0;
-
-	for (const auto& album: m_albums) {
-		const std::list<Picture>& pics = album.getPictures();
-		
-		for (const auto& picture: pics)	{
-			if (picture.isUserTagged(user))	{
-				albumsCount++;
-				break;
-			}
+	// copied, since the index entries are removed while iterating
+	const GalleryIndex::TaggedPictures taggedPictures = m_index.getTaggedPicturesOfUser(user.getId());
+	for (const auto& albumPictures : taggedPictures) {
+		auto album = m_index.findAlbum(albumPictures.first);
+
+		for (int pictureId : albumPictures.second) {
+			album->untagUserInPicture(user.getId(), pictureId);
+			m_index.removeTag(user.getId(), albumPictures.first, pictureId);
 		}
 	}
 
-	return albumsCount;
+	for (auto album : m_index.findAlbumsOfUser(user.getId())) {
+		m_index.removeAlbum(album);
+		m_albums.erase(album);
+	}
+
+	auto iter = m_index.findUser(user.getId());
+	if (iter != m_users.end()) {
+		m_index.removeUser(iter);
+		m_users.erase(iter);
+	}
 }
 
-int MemoryAccess::countTagsOfUser(const User& user) 
+
+// user statistics
+int MemoryAccess::countAlbumsOwnedOfUser(const User& user)
 {
-	int tagsCount = 0;
+	return m_index.countAlbumsOfUser(user.getId());
+}
 
-	for (const auto& album: m_albums) {
-		const std::list<Picture>& pics = album.getPictures();
-		
-		for (const auto& picture: pics)	{
-			if (picture.isUserTagged(user))	{
-				tagsCount++;
-			}
-		}
-	}
+int MemoryAccess::countAlbumsTaggedOfUser(const User& user) 
+{
+	return m_index.countAlbumsTaggedOfUser(user.getId());
+}
 
-	return tagsCount;
+int MemoryAccess::countTagsOfUser(const User& user) 
+{
+	return m_index.countTagsOfUser(user.getId());
 }
 
 float MemoryAccess::averageTagsPerAlbumOfUser(const User& user) 
@@ -314,84 +538,383 @@ float MemoryAccess::averageTagsPerAlbumOfUser(const User& user)
 
 User MemoryAccess::getTopTaggedUser()
 {
-	std::map<int, int> userTagsCountMap;
+	std::vector<int> topTaggedUsers = m_index.getTopTaggedUsers(1);
 
-	auto albumsIter = m_albums.begin();
-	for (const auto& album: m_albums) {
-		for (const auto& picture: album.getPictures()) {
-			const std::set<int>& userTags = picture.getUserTags();
-			for (const auto& user: userTags ) {
-				//As map creates default constructed values, 
-				//users which we haven't yet encountered will start from 0
-				userTagsCountMap[user]++;
-			}
-		}
+	if (topTaggedUsers.empty()) {
+		throw MyException("There isn't any tagged user.");
 	}
 
-	if (userTagsCountMap.size() == 0) {
-		throw MyException("There isn't any tagged user.");
+	if (!doesUserExists(topTaggedUsers.front()))
+	{
+		throw MyException("The most tagged user is no longer exists");
+	}
+
+	return getUser(topTaggedUsers.front());
+}
+
+Picture MemoryAccess::getTopTaggedPicture()
+{
+	std::vector<GalleryIndex::PictureKey> topTaggedPictures = m_index.getTopTaggedPictures(1);
+
+	if (topTaggedPictures.empty()) {
+		throw MyException("There isn't any tagged picture.");
 	}
 
-	int topTaggedUser = -1;
-	int currentMax = -1;
-	for (auto entry: userTagsCountMap) {
-		if (entry.second < currentMax) {
-			continue;
+	return m_index.findAlbum(topTaggedPictures.front().first)->getPicture(topTaggedPictures.front().second);
+}
+
+std::list<Picture> MemoryAccess::getTaggedPicturesOfUser(const User& user)
+{
+	std::list<Picture> pictures;
+
+	for (const auto& albumPictures : m_index.getTaggedPicturesOfUser(user.getId())) {
+		auto album = m_index.findAlbum(albumPictures.first);
+
+		for (int pictureId : albumPictures.second) {
+			pictures.push_back(album->getPicture(pictureId));
 		}
+	}
 
-		topTaggedUser = entry.first;
-		currentMax = entry.second;
+	return pictures;
+}
+
+
+std::list<User> MemoryAccess::getTopTaggedUsers(int count)
+{
+	std::list<User> users;
+
+	for (int userId : m_index.getTopTaggedUsers(count)) {
+		// users that no longer exist are skipped
+		if (doesUserExists(userId)) {
+			users.push_back(getUser(userId));
+		}
 	}
 
-	if ( -1 == topTaggedUser ) {
-		throw MyException("Failed to find most tagged user");
+	return users;
+}
+
+std::list<Picture> MemoryAccess::getTopTaggedPictures(int count)
+{
+	std::list<Picture> pictures;
+
+	for (const auto& picture : m_index.getTopTaggedPictures(count)) {
+		pictures.push_back(m_index.findAlbum(picture.first)->getPicture(picture.second));
 	}
 
-	if (!doesUserExists(topTaggedUser))
-	{
-		throw MyException("The most tagged user is no longer exists");
+	return pictures;
+}
+
+std::list<Picture> MemoryAccess::getPicturesCreatedBetween(int64_t from, int64_t to)
+{
+	std::list<Picture> pictures;
+
+	for (const auto& picture : m_index.getPicturesCreatedBetween(from, to)) {
+		pictures.push_back(m_index.findAlbum(picture.first)->getPicture(picture.second));
 	}
 
-	return getUser(topTaggedUser);
+	return pictures;
 }
 
-Picture MemoryAccess::getTopTaggedPicture()
+/*
+This function returns the groups of pictures that have the same content (the same file, copied or added twice)
+input: none
+output: the pictures of every group, ordered by id
+*/
+std::list<std::list<Picture>> MemoryAccess::getDuplicatePictures()
 {
-	int currentMax = -1;
-	const Picture* mostTaggedPic = nullptr;
-	for (const auto& album: m_albums) {
-		for (const Picture& picture: album.getPictures()) {
-			int tagsCount = picture.getTagsCount();
-			if (tagsCount == 0) {
-				continue;
-			}
+	return getPictureGroups(m_index.getDuplicatePictures());
+}
 
-			if (tagsCount <= currentMax) {
-				continue;
-			}
+/*
+This function returns the groups of pictures that look alike - pictures whose perceptual hashes
+differ in at most the given number of bits, or that are linked by a chain of such pictures
+input: the max distance (0 to 64 bits, about 10 finds resized or recompressed copies)
+output: the pictures of every group, ordered by id
+*/
+std::list<std::list<Picture>> MemoryAccess::getSimilarPictures(int maxDistance)
+{
+	return getPictureGroups(m_index.getSimilarPictures(maxDistance));
+}
+
+/*
+This function returns the pictures of an album that are larger than a size - wider or taller than it
+input: the album name, the id of its owner, the size in pixels
+output: the pictures, ordered by id (pictures whose header wasn't read have no size, and are left out)
+*/
+std::list<Picture> MemoryAccess::getPicturesLargerThan(const std::string& albumName, int ownerId, int pixels)
+{
+	std::list<Picture> pictures;
 
-			mostTaggedPic = &picture;
-			currentMax = tagsCount;
+	for (const Picture& picture : getAlbumIfExists(albumName, ownerId)->getPictures()) {
+		if (std::max(picture.getWidth(), picture.getHeight()) > pixels) {
+			pictures.push_back(picture);
 		}
 	}
-	if ( nullptr == mostTaggedPic ) {
-		throw MyException("There isn't any tagged picture.");
+
+	return pictures;
+}
+
+/*
+This function returns the pictures taken in a time range (by their EXIF capture time), the oldest one first
+input: the first and last capture times of the range (seconds since the epoch, both included)
+output: the pictures (pictures with no capture time are left out)
+*/
+std::list<Picture> MemoryAccess::getPicturesCapturedBetween(int64_t from, int64_t to)
+{
+	std::list<Picture> pictures;
+
+	for (const auto& picture : m_index.getPicturesCapturedBetween(from, to)) {
+		pictures.push_back(m_index.findAlbum(picture.first)->getPicture(picture.second));
 	}
 
-	return *mostTaggedPic;	
+	return pictures;
 }
 
-std::list<Picture> MemoryAccess::getTaggedPicturesOfUser(const User& user)
+/*
+This function returns the pictures taken with a camera, the oldest one first
+input: the camera model (case insensitive)
+output: the pictures
+*/
+std::list<Picture> MemoryAccess::getPicturesOfCamera(const std::string& cameraModel)
 {
 	std::list<Picture> pictures;
 
-	for (const auto& album: m_albums) {
-		for (const auto& picture: album.getPictures()) {
-			if (picture.isUserTagged(user)) {
-				pictures.push_back(picture);
+	for (const auto& picture : m_index.getPicturesOfCamera(cameraModel)) {
+		pictures.push_back(m_index.findAlbum(picture.first)->getPicture(picture.second));
+	}
+
+	return pictures;
+}
+
+/*
+This function turns groups of pictures of the gallery index into the pictures themselves
+input: (album id, picture id) of the pictures of every group
+output: the pictures of every group, in the same order
+*/
+std::list<std::list<Picture>> MemoryAccess::getPictureGroups(const std::vector<std::vector<GalleryIndex::PictureKey>>& pictureGroups)
+{
+	std::list<std::list<Picture>> groups;
+
+	for (const auto& group : pictureGroups) {
+		groups.emplace_back();
+		for (const auto& picture : group) {
+			groups.back().push_back(m_index.findAlbum(picture.first)->getPicture(picture.second));
+		}
+	}
+
+	return groups;
+}
+
+
+// ******************* Persistence *******************
+/*
+This function loads the gallery from the snapshot file, if there is one
+input: the stamp of the snapshot (output parameter, 0 if there is no snapshot)
+output: true if the gallery was loaded or there is no snapshot, false if the snapshot is damaged
+*/
+bool MemoryAccess::loadSnapshot(uint64_t& stamp)
+{
+	SnapshotFile snapshotFile;
+	stamp = 0;
+
+	if (!snapshotFile.open(snapshotFileName)) {
+		// a new gallery, unless its log is there without it
+		return true;
+	}
+
+	for (size_t user = 0; user < snapshotFile.getUsersCount(); ++user) {
+		m_users.push_back(snapshotFile.getUser(user));
+		m_index.addUser(std::prev(m_users.end()));
+	}
+
+	for (size_t album = 0; album < snapshotFile.getAlbumsCount(); ++album) {
+		Album loadedAlbum = snapshotFile.getAlbum(album);
+		if (!snapshotFile.readPictures(album, loadedAlbum)) {
+			std::cout << "The snapshot file is damaged" << std::endl;
+			return false;
+		}
+		addAlbumToGallery(loadedAlbum);
+	}
+
+	stamp = snapshotFile.getStamp();
+	return true;
+}
+
+/*
+This function applies a change from the operation log to the gallery (the log isn't open yet, so it isn't logged again)
+input: the change
+output: none
+*/
+void MemoryAccess::replay(const OperationLog::Entry& entry)
+{
+	const std::vector<int64_t>& numbers = entry.numbers;
+	const std::vector<std::string>& texts = entry.texts;
+	auto findAlbum = [this](int64_t albumId) {
+		auto album = m_index.findAlbum(static_cast<int>(albumId));
+		if (album == m_albums.end()) {
+			throw ItemNotFoundException("Album", static_cast<int>(albumId));
+		}
+		return album;
+	};
+
+	try
+	{
+		switch (entry.operation)
+		{
+		case OperationLog::Operation::CREATE_USER:
+		{
+			User user(static_cast<int>(numbers.at(0)), texts.at(0));
+			createUser(user);
+			break;
+		}
+		case OperationLog::Operation::DELETE_USER:
+			deleteUser(User(static_cast<int>(numbers.at(0)), ""));
+			break;
+		case OperationLog::Operation::CREATE_ALBUM:
+		{
+			Album album(static_cast<int>(numbers.at(1)), texts.at(0), numbers.at(2));
+			album.setId(static_cast<int>(numbers.at(0)));
+			addAlbumToGallery(album);
+			break;
+		}
+		case OperationLog::Operation::DELETE_ALBUM:
+			removeAlbumFromGallery(findAlbum(numbers.at(0)));
+			break;
+		case OperationLog::Operation::ADD_PICTURE:
+		{
+			Picture picture(static_cast<int>(numbers.at(1)), texts.at(0), texts.at(1), numbers.at(2));
+			picture.setContentHash(static_cast<uint64_t>(numbers.at(3)));
+			picture.setPerceptualHash(static_cast<uint64_t>(numbers.at(4)));
+			picture.setDimensions(static_cast<int>(numbers.at(5)), static_cast<int>(numbers.at(6)));
+			picture.setFormat(static_cast<ImageFormat>(numbers.at(7)));
+			picture.setFileSize(static_cast<uint64_t>(numbers.at(8)));
+			ExifMetadata metadata;
+			metadata.captureTime = numbers.at(9);
+			metadata.cameraModel = texts.at(2);
+			metadata.hasLocation = numbers.at(10) != 0;
+			std::memcpy(&metadata.latitude, &numbers.at(11), sizeof(metadata.latitude));
+			std::memcpy(&metadata.longitude, &numbers.at(12), sizeof(metadata.longitude));
+			picture.setMetadata(metadata);
+			for (size_t tag = 13; tag < numbers.size(); ++tag) {
+				picture.tagUser(static_cast<int>(numbers[tag]));
 			}
+			addPictureToAlbum(findAlbum(numbers.at(0)), picture);
+			break;
 		}
+		case OperationLog::Operation::REMOVE_PICTURE:
+			removePictureFromAlbum(findAlbum(numbers.at(0)), texts.at(0));
+			break;
+		case OperationLog::Operation::TAG_USER:
+			tagUserInPicture(findAlbum(numbers.at(0)), texts.at(0), static_cast<int>(numbers.at(1)));
+			break;
+		case OperationLog::Operation::UNTAG_USER:
+			untagUserInPicture(findAlbum(numbers.at(0)), texts.at(0), static_cast<int>(numbers.at(1)));
+			break;
+		case OperationLog::Operation::DELETE_USER_TAGS:
+			deleteUserTags(User(static_cast<int>(numbers.at(0)), ""));
+			break;
+		case OperationLog::Operation::DELETE_USER_CASCADE:
+			deleteUserCascade(User(static_cast<int>(numbers.at(0)), ""));
+			break;
+		default:
+			throw MyException("Unknown operation " + std::to_string(static_cast<int>(entry.operation)));
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "Failed to replay a change from the operation log: " << e.what() << std::endl;
 	}
+}
 
-	return pictures;
+/*
+This function logs a change of the gallery, and compacts the log into a new snapshot when it grows too big
+input: the change
+output: none
+*/
+void MemoryAccess::logOperation(const OperationLog::Entry& entry)
+{
+	if (!m_log.isOpen()) {
+		return;
+	}
+
+	m_log.append(entry);
+	if (m_log.getSize() >= m_compactionSize) {
+		saveSnapshot();
+	}
+}
+
+/*
+This function compacts the operation log - it saves a snapshot of the gallery and starts the log over on top of it.
+The snapshot is on the disk before the log is started over, and until then the old log is ignored by the
+new snapshot (see OperationLog::open), so a crash in between loses nothing.
+input: none
+output: true if the snapshot was saved, false otherwise
+*/
+bool MemoryAccess::saveSnapshot()
+{
+	if (!m_log.isOpen()) {
+		return false;
+	}
+
+	auto startTime = std::chrono::steady_clock::now();
+	uint64_t stamp = SnapshotFile::newStamp();
+
+	bool success = m_log.commit() && SnapshotFile::save(snapshotFileName, stamp, m_users, m_albums, [](const Album& album) {
+		return album.getPictures();
+	});
+	if (!success)
+	{
+		std::cout << "Failed to save snapshot" << std::endl;
+		return false;
+	}
+
+	if (!m_log.reset(stamp))
+	{
+		std::cout << "Failed to compact the operation log, the next changes won't be saved" << std::endl;
+		return false;
+	}
+
+	std::chrono::duration<double> saveTime = std::chrono::steady_clock::now() - startTime;
+	std::cout << "Saved a snapshot of the gallery in " << std::fixed << std::setprecision(3) << saveTime.count() << " sec" << std::defaultfloat << std::endl;
+	return true;
+}
+
+/*
+This function writes the changes that are waiting for their group to the log
+input: none
+output: none
+*/
+void MemoryAccess::flush()
+{
+	m_log.commit();
+}
+
+/*
+This function sets when the changes are written to the log - every flushSize changes,
+or on the first change after flushInterval passed since the oldest change that is waiting
+input: the count of changes, the time
+output: none
+*/
+void MemoryAccess::setFlushPolicy(int flushSize, std::chrono::milliseconds flushInterval)
+{
+	m_log.setFlushPolicy(flushSize, flushInterval);
+}
+
+void MemoryAccess::setCompactionSize(uint64_t compactionSize)
+{
+	m_compactionSize = compactionSize;
+}
+
+
+// ******************* SQL *******************
+// The memory access has no DB behind it, so there is nothing to run
+
+bool MemoryAccess::runSqlCommand(std::string)
+{
+	return false;
+}
+
+void MemoryAccess::dropTables()
+{
+	// Left empty
 }
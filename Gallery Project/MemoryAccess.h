@@ -3,38 +3,47 @@
 #include "Album.h"
 #include "User.h"
 #include "IDataAccess.h"
+#include "GalleryIndex.h"
+#include "GallerySnapshot.h"
+#include "OperationLog.h"
 
 class MemoryAccess : public IDataAccess
 {
 
 public:
-	MemoryAccess() = default;
+	MemoryAccess();
 	virtual ~MemoryAccess() = default;
 
 	// album related
-	const std::list<Album> getAlbums() override;
+	std::list<Album> getAlbums() override;
 	std::list<Album> getAlbumsOfUser(const User& user) override;
 	void createAlbum(const Album& album) override;
+	void importAlbums(const std::list<Album>& albums) override;
 	void deleteAlbum(const std::string& albumName, int userId) override;
 	bool doesAlbumExists(const std::string& albumName, int userId) override;
-	Album openAlbum(const std::string& albumName) override;
-	void closeAlbum(Album &pAlbum) override;
+	Album openAlbum(const std::string& albumName, int userId) override;
+	Album getAlbumById(const int albumId) override;
+	void closeAlbum(const Album& pAlbum) override;
 	void printAlbums() override;
+	std::shared_ptr<const GallerySnapshot> getSnapshot() override;
 
 	// picture related
-	void addPictureToAlbumByName(const std::string& albumName, const Picture& picture) override;
-	void removePictureFromAlbumByName(const std::string& albumName, const std::string& pictureName) override;
-	void tagUserInPicture(const std::string& albumName, const std::string& pictureName, int userId) override;
-	void untagUserInPicture(const std::string& albumName, const std::string& pictureName, int userId) override;
+	void addPictureToAlbumByName(const std::string& albumName, int ownerId, const Picture& picture) override;
+	void removePictureFromAlbumByName(const std::string& albumName, int ownerId, const std::string& pictureName) override;
+	void tagUserInPicture(const std::string& albumName, int ownerId, const std::string& pictureName, int userId) override;
+	void untagUserInPicture(const std::string& albumName, int ownerId, const std::string& pictureName, int userId) override;
+	int getLastPictureId() override;
 
 	// user related
 	void printUsers() override;
 	void createUser(User& user) override;
 	void deleteUser(const User& user) override;
 	bool doesUserExists(int userId) override;
+	int getLastUserId() override;
 	User getUser(int userId) override;
 	void deleteUsersAlbums(const User& user) override;
 	void deleteUserTags(const User& user) override;
+	void deleteUserCascade(const User& user) override;
 
 	// user statistics
 	int countAlbumsOwnedOfUser(const User& user) override;
@@ -46,16 +55,54 @@ public:
 	User getTopTaggedUser() override;
 	Picture getTopTaggedPicture() override;
 	std::list<Picture> getTaggedPicturesOfUser(const User& user) override;
+	std::list<User> getTopTaggedUsers(int count) override;
+	std::list<Picture> getTopTaggedPictures(int count) override;
+	std::list<Picture> getPicturesCreatedBetween(int64_t from, int64_t to) override;
+	std::list<std::list<Picture>> getDuplicatePictures() override;
+	std::list<std::list<Picture>> getSimilarPictures(int maxDistance) override;
+	std::list<Picture> getPicturesLargerThan(const std::string& albumName, int ownerId, int pixels) override;
+	std::list<Picture> getPicturesCapturedBetween(int64_t from, int64_t to) override;
+	std::list<Picture> getPicturesOfCamera(const std::string& cameraModel) override;
 
 	bool open() override;
-	void close() override {};
+	void close() override;
 	void clear() override;
+	void flush() override;
+	bool saveSnapshot() override;
+	void setFlushPolicy(int flushSize, std::chrono::milliseconds flushInterval);
+	void setCompactionSize(uint64_t compactionSize);
+	bool runSqlCommand(std::string sqlStatement) override;
+	void dropTables() override;
 
 private:
 	std::list<Album> m_albums;
 	std::list<User> m_users;
+	GalleryIndex m_index;
+	std::shared_ptr<const GallerySnapshot> m_snapshot;
+	unsigned long long m_version { 0 };
+	int m_lastAlbumId { 0 };
 
-	auto getAlbumIfExists(const std::string& albumName);
+	// persistence - the gallery is loaded from the snapshot file, then the changes since are replayed from the log
+	std::string snapshotFileName;
+	std::string logFileName;
+	OperationLog m_log;
+	// the log is compacted into a new snapshot when it grows this big
+	uint64_t m_compactionSize { 64 * 1024 * 1024 };
+
+	auto getAlbumIfExists(const std::string& albumName, int ownerId);
+	void invalidateSnapshot();
+	bool loadSnapshot(uint64_t& stamp);
+	void replay(const OperationLog::Entry& entry);
+	void logOperation(const OperationLog::Entry& entry);
+	static OperationLog::Entry addPictureEntry(int albumId, const Picture& picture);
+	std::list<Album>::iterator addAlbumToGallery(const Album& album);
+	void removeAlbumFromGallery(std::list<Album>::iterator album);
+	void addPictureToAlbum(std::list<Album>::iterator album, const Picture& picture);
+	void removePictureFromAlbum(std::list<Album>::iterator album, const std::string& pictureName);
+	void tagUserInPicture(std::list<Album>::iterator album, const std::string& pictureName, int userId);
+	void untagUserInPicture(std::list<Album>::iterator album, const std::string& pictureName, int userId);
+	void removeUserFromGallery(const User& user);
+	std::list<std::list<Picture>> getPictureGroups(const std::vector<std::vector<GalleryIndex::PictureKey>>& pictureGroups);
 	Album createDummyAlbum(const User& user);
 	void cleanUserData(const User& userId);
 };
@@ -0,0 +1,413 @@
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include "OperationLog.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static const char LOG_MAGIC[8] = { 'G', 'A', 'L', 'O', 'P', 'L', 'O', 'G' };
+// read back in another byte order it doesn't match
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+// every entry is framed by the length of its bytes and their CRC-32
+static const size_t FRAME_SIZE = 2 * sizeof(uint32_t);
+
+
+OperationLog::~OperationLog()
+{
+	close();
+}
+
+
+// ******************* Opening *******************
+/*
+This function opens a log for appending, after it replays the entries that are already in it.
+A damaged tail is cut off the log. A log that applies to an older snapshot than the given one
+is started over, since the snapshot already holds its changes. A missing log is created.
+input: the log file name, the stamp of the snapshot the gallery was loaded from (0 if none),
+	a function that applies an entry to the gallery
+output: true if the log was opened, false otherwise
+*/
+bool OperationLog::open(const std::string& fileName, uint64_t baseStamp, const std::function<void(const Entry&)>& replay)
+{
+	close();
+	m_fileName = fileName;
+
+	std::error_code error;
+	if (!std::filesystem::exists(fileName, error)) {
+		return reset(baseStamp);
+	}
+
+	return replayFile(baseStamp, replay);
+}
+
+bool OperationLog::replayFile(uint64_t baseStamp, const std::function<void(const Entry&)>& replay)
+{
+	std::ifstream file(m_fileName, std::ios::binary);
+	std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (!file.eof() && file.fail()) {
+		std::cout << "Failed to read the operation log" << std::endl;
+		return false;
+	}
+	file.close();
+
+	Header header = {};
+	if (data.size() >= sizeof(header)) {
+		std::memcpy(&header, data.data(), sizeof(header));
+	}
+	if (data.size() < sizeof(header) || std::memcmp(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0 ||
+		header.version != VERSION || header.byteOrder != BYTE_ORDER_MARK)
+	{
+		std::cout << "Failed to open the operation log, " << m_fileName << " isn't a valid log" << std::endl;
+		return false;
+	}
+
+	if (header.baseStamp != baseStamp) {
+		// the snapshot was saved after the changes of this log, but the log wasn't started over
+		if (baseStamp != 0) {
+			return reset(baseStamp);
+		}
+		std::cout << "Failed to open the operation log, its snapshot is missing" << std::endl;
+		return false;
+	}
+
+	size_t position = sizeof(header);
+	Entry entry;
+	while (data.size() - position >= FRAME_SIZE) {
+		uint32_t length = 0, checksum = 0;
+		std::memcpy(&length, data.data() + position, sizeof(length));
+		std::memcpy(&checksum, data.data() + position + sizeof(length), sizeof(checksum));
+
+		const char* bytes = data.data() + position + FRAME_SIZE;
+		if (length > data.size() - position - FRAME_SIZE || crc32(bytes, length) != checksum || !decode(bytes, length, entry)) {
+			break;
+		}
+
+		replay(entry);
+		position += FRAME_SIZE + length;
+	}
+
+	if (position != data.size()) {
+		std::cout << "Cut a damaged tail of " << data.size() - position << " bytes off the operation log" << std::endl;
+		std::error_code error;
+		std::filesystem::resize_file(m_fileName, position, error);
+		if (error) {
+			std::cout << "Failed to cut the operation log" << std::endl;
+			return false;
+		}
+	}
+
+	m_file = std::fopen(m_fileName.c_str(), "ab");
+	m_size = position;
+	return m_file != nullptr;
+}
+
+void OperationLog::close()
+{
+	if (m_file) {
+		commit();
+		std::fclose(m_file);
+		m_file = nullptr;
+	}
+	m_pending.clear();
+	m_pendingEntries = 0;
+	m_size = 0;
+}
+
+bool OperationLog::isOpen() const
+{
+	return m_file != nullptr;
+}
+
+
+// ******************* Writing *******************
+/*
+This function adds an entry to the current group, and commits the group if it is big enough or old enough
+input: the entry
+output: none
+*/
+void OperationLog::append(const Entry& entry)
+{
+	if (0 == m_pendingEntries) {
+		m_groupStartTime = std::chrono::steady_clock::now();
+	}
+
+	encode(entry, m_pending);
+	++m_pendingEntries;
+
+	if (m_pendingEntries >= m_flushSize || std::chrono::steady_clock::now() - m_groupStartTime >= m_flushInterval) {
+		commit();
+	}
+}
+
+/*
+This function writes the current group to the log and syncs it to the disk
+input: none
+output: true if the group was written, false otherwise (the group is lost)
+*/
+bool OperationLog::commit()
+{
+	if (m_pending.empty()) {
+		return true;
+	}
+
+	bool success = m_file && std::fwrite(m_pending.data(), 1, m_pending.size(), m_file) == m_pending.size() && sync(m_file);
+	if (success) {
+		m_size += m_pending.size();
+	}
+	else {
+		std::cout << "Failed to write the operation log" << std::endl;
+	}
+
+	m_pending.clear();
+	m_pendingEntries = 0;
+	return success;
+}
+
+/*
+This function starts the log over on top of a snapshot (the entries that weren't committed are dropped).
+The new log is written to a temporary file first and then renamed, so the old one is replaced only by a complete one.
+input: the stamp of the snapshot
+output: true if the log was started over, false otherwise (the log is closed)
+*/
+bool OperationLog::reset(uint64_t baseStamp)
+{
+	if (m_file) {
+		std::fclose(m_file);
+		m_file = nullptr;
+	}
+	m_pending.clear();
+	m_pendingEntries = 0;
+
+	Header header = {};
+	std::memcpy(header.magic, LOG_MAGIC, sizeof(header.magic));
+	header.version = VERSION;
+	header.byteOrder = BYTE_ORDER_MARK;
+	header.baseStamp = baseStamp;
+
+	const std::string tempFileName = m_fileName + ".tmp";
+	FILE* file = std::fopen(tempFileName.c_str(), "wb");
+	bool success = file && std::fwrite(&header, sizeof(header), 1, file) == 1 && sync(file);
+	if (file) {
+		success = (std::fclose(file) == 0) && success;
+	}
+
+	success = success && replaceFile(tempFileName, m_fileName);
+	if (!success) {
+		std::cout << "Failed to start the operation log over" << std::endl;
+		std::remove(tempFileName.c_str());
+		return false;
+	}
+
+	m_file = std::fopen(m_fileName.c_str(), "ab");
+	m_size = sizeof(header);
+	return m_file != nullptr;
+}
+
+/*
+This function sets when a group of entries is committed
+input: the count of entries in a full group, the age of a group that is committed on the next entry
+output: none
+*/
+void OperationLog::setFlushPolicy(int flushSize, std::chrono::milliseconds flushInterval)
+{
+	m_flushSize = flushSize;
+	m_flushInterval = flushInterval;
+}
+
+uint64_t OperationLog::getSize() const
+{
+	return m_size + m_pending.size();
+}
+
+
+// ******************* Encoding *******************
+/*
+This function appends an entry, framed by its length and checksum, to a buffer.
+The entry is its operation, the counts of its numbers and texts, its numbers, and its texts (each after its length).
+input: the entry, the buffer
+output: none
+*/
+void OperationLog::encode(const Entry& entry, std::string& buffer)
+{
+	const size_t frame = buffer.size();
+	buffer.resize(frame + FRAME_SIZE);
+
+	auto put = [&buffer](const void* value, size_t size) {
+		buffer.append(static_cast<const char*>(value), size);
+	};
+
+	uint8_t operation = static_cast<uint8_t>(entry.operation);
+	uint32_t numbersCount = static_cast<uint32_t>(entry.numbers.size());
+	uint32_t textsCount = static_cast<uint32_t>(entry.texts.size());
+	put(&operation, sizeof(operation));
+	put(&numbersCount, sizeof(numbersCount));
+	put(&textsCount, sizeof(textsCount));
+	put(entry.numbers.data(), entry.numbers.size() * sizeof(int64_t));
+	for (const std::string& text : entry.texts) {
+		uint32_t length = static_cast<uint32_t>(text.size());
+		put(&length, sizeof(length));
+		put(text.data(), text.size());
+	}
+
+	uint32_t length = static_cast<uint32_t>(buffer.size() - frame - FRAME_SIZE);
+	uint32_t checksum = crc32(buffer.data() + frame + FRAME_SIZE, length);
+	std::memcpy(&buffer[frame], &length, sizeof(length));
+	std::memcpy(&buffer[frame + sizeof(length)], &checksum, sizeof(checksum));
+}
+
+/*
+This function reads an entry (without its frame)
+input: the bytes of the entry, their count, the entry (output parameter)
+output: true if the bytes hold exactly one entry, false otherwise
+*/
+bool OperationLog::decode(const char* data, size_t size, Entry& entry)
+{
+	size_t position = 0;
+	auto get = [data, size, &position](void* value, size_t length) {
+		if (length > size - position) {
+			return false;
+		}
+		std::memcpy(value, data + position, length);
+		position += length;
+		return true;
+	};
+
+	uint8_t operation = 0;
+	uint32_t numbersCount = 0, textsCount = 0;
+	if (!get(&operation, sizeof(operation)) || !get(&numbersCount, sizeof(numbersCount)) || !get(&textsCount, sizeof(textsCount)) ||
+		numbersCount > (size - position) / sizeof(int64_t))
+	{
+		return false;
+	}
+
+	entry.operation = static_cast<Operation>(operation);
+	entry.numbers.resize(numbersCount);
+	if (!get(entry.numbers.data(), numbersCount * sizeof(int64_t)) || textsCount > (size - position) / sizeof(uint32_t)) {
+		return false;
+	}
+
+	entry.texts.resize(textsCount);
+	for (std::string& text : entry.texts) {
+		uint32_t length = 0;
+		if (!get(&length, sizeof(length)) || length > size - position) {
+			return false;
+		}
+		text.assign(data + position, length);
+		position += length;
+	}
+
+	return position == size;
+}
+
+/*
+This function calculates the CRC-32 (the one of zip and png) of bytes
+input: the bytes, their count
+output: the CRC-32
+*/
+uint32_t OperationLog::crc32(const char* data, size_t size)
+{
+	static const std::array<uint32_t, 256> table = []() {
+		std::array<uint32_t, 256> values = {};
+		for (uint32_t i = 0; i < values.size(); ++i) {
+			uint32_t value = i;
+			for (int bit = 0; bit < 8; ++bit) {
+				value = (value & 1) ? (0xEDB88320u ^ (value >> 1)) : (value >> 1);
+			}
+			values[i] = value;
+		}
+		return values;
+	}();
+
+	uint32_t crc = 0xFFFFFFFFu;
+	for (size_t i = 0; i < size; ++i) {
+		crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+	}
+	return crc ^ 0xFFFFFFFFu;
+}
+
+
+// ******************* Syncing *******************
+/*
+This function flushes an open file and waits until the disk holds it
+input: the file
+output: true if the file was synced, false otherwise
+*/
+bool OperationLog::sync(FILE* file)
+{
+	if (std::fflush(file) != 0) {
+		return false;
+	}
+
+#ifdef _WIN32
+	return _commit(_fileno(file)) == 0;
+#else
+	return fsync(fileno(file)) == 0;
+#endif
+}
+
+/*
+This function waits until the disk holds a file that was written and closed
+input: the file name
+output: true if the file was synced, false otherwise
+*/
+bool OperationLog::syncFile(const std::string& fileName)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(fileName.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (INVALID_HANDLE_VALUE == file) {
+		return false;
+	}
+	bool success = FlushFileBuffers(file) != 0;
+	CloseHandle(file);
+#else
+	int file = ::open(fileName.c_str(), O_RDONLY);
+	if (file < 0) {
+		return false;
+	}
+	bool success = fsync(file) == 0;
+	::close(file);
+#endif
+
+	return success;
+}
+
+/*
+This function renames a file that was written and synced over another file, and waits until the disk
+holds the rename (the folder of the file is synced too) - so after a crash the file is either the old
+one or the whole new one
+input: the written file name, the name it replaces
+output: true if the file was replaced, false otherwise
+*/
+bool OperationLog::replaceFile(const std::string& tempFileName, const std::string& fileName)
+{
+#ifdef _WIN32
+	return MoveFileExA(tempFileName.c_str(), fileName.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	std::error_code error;
+	std::filesystem::rename(tempFileName, fileName, error);
+	if (error) {
+		return false;
+	}
+
+	std::filesystem::path folder = std::filesystem::path(fileName).parent_path();
+	int file = ::open(folder.empty() ? "." : folder.c_str(), O_RDONLY);
+	if (file < 0) {
+		return false;
+	}
+	bool success = fsync(file) == 0;
+	::close(file);
+
+	return success;
+#endif
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+An append only log of the changes of a gallery, so a gallery kept in memory survives a restart.
+Every change is one entry, framed by its length and a CRC-32 of its bytes, so a torn or damaged
+tail (a crash in the middle of a write) is found and cut off when the log is replayed.
+Entries are written and synced to the disk in groups (group commit) - a group is committed when it
+is big enough or old enough, or when the log is committed, reset or closed.
+The log starts with the stamp of the snapshot file it applies to (0 if it applies to an empty
+gallery), reset() starts a new log on top of a new snapshot.
+*/
+class OperationLog
+{
+public:
+	static const uint32_t VERSION = 5;
+
+	enum class Operation : uint8_t
+	{
+		CREATE_USER = 1,
+		DELETE_USER,
+		CREATE_ALBUM,
+		DELETE_ALBUM,
+		ADD_PICTURE,
+		REMOVE_PICTURE,
+		TAG_USER,
+		UNTAG_USER,
+		DELETE_USER_TAGS,
+		DELETE_USER_CASCADE
+	};
+
+	// one change - the numbers and texts it needs, in an order known to its operation
+	struct Entry
+	{
+		Operation operation;
+		std::vector<int64_t> numbers;
+		std::vector<std::string> texts;
+	};
+
+	OperationLog() = default;
+	~OperationLog();
+	OperationLog(const OperationLog&) = delete;
+	OperationLog& operator=(const OperationLog&) = delete;
+
+	bool open(const std::string& fileName, uint64_t baseStamp, const std::function<void(const Entry&)>& replay);
+	void close();
+	bool isOpen() const;
+	void append(const Entry& entry);
+	bool commit();
+	bool reset(uint64_t baseStamp);
+	void setFlushPolicy(int flushSize, std::chrono::milliseconds flushInterval);
+	uint64_t getSize() const;
+
+	static bool syncFile(const std::string& fileName);
+	static bool replaceFile(const std::string& tempFileName, const std::string& fileName);
+
+private:
+	struct Header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t byteOrder;
+		uint64_t baseStamp;
+	};
+
+	std::string m_fileName;
+	FILE* m_file { nullptr };
+	uint64_t m_size { 0 };
+
+	// group commit - the entries that weren't written yet
+	std::string m_pending;
+	int m_pendingEntries { 0 };
+	int m_flushSize { 1000 };
+	std::chrono::milliseconds m_flushInterval { 1000 };
+	std::chrono::steady_clock::time_point m_groupStartTime;
+
+	bool replayFile(uint64_t baseStamp, const std::function<void(const Entry&)>& replay);
+	static void encode(const Entry& entry, std::string& buffer);
+	static bool decode(const char* data, size_t size, Entry& entry);
+	static uint32_t crc32(const char* data, size_t size);
+	static bool sync(FILE* file);
+};
@@ -0,0 +1,101 @@
+#include <mutex>
+#include "PathTrie.h"
+
+
+PathTrie::PathTrie() :
+	m_nodes(1, Node { 0, 0 })
+{
+	// Left empty
+}
+
+/*
+This function returns the handle of a path, adding its missing components to the trie
+input: the path
+output: the handle
+*/
+PathTrie::Handle PathTrie::intern(std::string_view path)
+{
+	{
+		std::shared_lock<std::shared_mutex> lock(m_mutex);
+		auto known = m_paths.find(path);
+		if (known != m_paths.end()) {
+			return known->second;
+		}
+	}
+
+	Handle node = 0;
+	size_t start = 0;
+
+	while (start < path.size()) {
+		size_t end = path.find_first_of("/\\", start);
+		end = (end == std::string_view::npos) ? path.size() : end + 1;
+
+		node = getChild(node, m_components.intern(path.substr(start, end - start)));
+		start = end;
+	}
+
+	std::unique_lock<std::shared_mutex> lock(m_mutex);
+	if (m_paths.find(path) == m_paths.end()) {
+		m_pathStrings.emplace_back(path);
+		m_paths.emplace(m_pathStrings.back(), node);
+	}
+	return node;
+}
+
+/*
+This function rebuilds a path from its components
+input: the handle of the path
+output: the path
+*/
+std::string PathTrie::get(Handle handle) const
+{
+	std::vector<StringPool::Handle> components;
+	{
+		std::shared_lock<std::shared_mutex> lock(m_mutex);
+		for (Handle node = handle; node != 0; node = m_nodes[node].parent) {
+			components.push_back(m_nodes[node].component);
+		}
+	}
+
+	std::string path;
+	for (auto component = components.rbegin(); component != components.rend(); ++component) {
+		path += m_components.get(*component);
+	}
+
+	return path;
+}
+
+size_t PathTrie::size() const
+{
+	std::shared_lock<std::shared_mutex> lock(m_mutex);
+	return m_nodes.size();
+}
+
+/*
+This function returns the node of a component under a parent node, adding it if it is new
+input: the parent node, the component
+output: the node
+*/
+PathTrie::Handle PathTrie::getChild(Handle parent, StringPool::Handle component)
+{
+	uint64_t key = (static_cast<uint64_t>(parent) << 32) | component;
+
+	{
+		std::shared_lock<std::shared_mutex> lock(m_mutex);
+		auto child = m_children.find(key);
+		if (child != m_children.end()) {
+			return child->second;
+		}
+	}
+
+	std::unique_lock<std::shared_mutex> lock(m_mutex);
+	auto child = m_children.find(key);
+	if (child != m_children.end()) {
+		return child->second;
+	}
+
+	m_nodes.push_back(Node { parent, component });
+	Handle node = static_cast<Handle>(m_nodes.size() - 1);
+	m_children.emplace(key, node);
+	return node;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <shared_mutex>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "StringPool.h"
+
+/*
+A table of interned file paths, stored as a trie of path components (split after every
+'/' or '\'), so paths that share directories store those directories once.
+Every distinct path is referred to by a small handle, handle 0 is the empty path.
+Paths are never removed. The trie may be used from several threads at once.
+*/
+class PathTrie
+{
+public:
+	using Handle = uint32_t;
+
+	PathTrie();
+
+	Handle intern(std::string_view path);
+	std::string get(Handle handle) const;
+	size_t size() const;
+
+private:
+	struct Node
+	{
+		Handle parent;
+		StringPool::Handle component;
+	};
+
+	mutable std::shared_mutex m_mutex;
+	StringPool m_components;
+	std::vector<Node> m_nodes;
+	// parent handle and component handle -> node handle
+	std::unordered_map<uint64_t, Handle> m_children;
+	// the paths interned so far, so interning a known path is a single lookup
+	// (a deque never moves its strings, so the views of m_paths stay valid)
+	std::deque<std::string> m_pathStrings;
+	std::unordered_map<std::string_view, Handle> m_paths;
+
+	Handle getChild(Handle parent, StringPool::Handle component);
+};
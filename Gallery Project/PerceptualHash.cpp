@@ -0,0 +1,66 @@
+#include <bitset>
+#include "PerceptualHash.h"
+
+// one column more than the bits of a row, every bit compares two neighbors
+static const int HASH_WIDTH = 9;
+static const int HASH_HEIGHT = 8;
+
+
+/*
+This function computes the perceptual hash of a picture
+input: the picture
+output: the hash (0 for an empty picture)
+*/
+uint64_t PerceptualHash::compute(const Image& image)
+{
+	if (image.isEmpty()) {
+		return 0;
+	}
+
+	Image small = image.scaledDown(HASH_WIDTH, HASH_HEIGHT);
+	int gray[HASH_HEIGHT][HASH_WIDTH];
+
+	for (int y = 0; y < HASH_HEIGHT; ++y) {
+		for (int x = 0; x < HASH_WIDTH; ++x) {
+			const uint8_t* pixel = small.getPixel(x, y);
+			// luma (ITU-R BT.601) in fixed point
+			gray[y][x] = (77 * pixel[0] + 150 * pixel[1] + 29 * pixel[2]) >> 8;
+		}
+	}
+
+	uint64_t hash = 0;
+	for (int y = 0; y < HASH_HEIGHT; ++y) {
+		for (int x = 0; x < HASH_WIDTH - 1; ++x) {
+			hash = (hash << 1) | (gray[y][x] > gray[y][x + 1] ? 1 : 0);
+		}
+	}
+
+	return hash;
+}
+
+/*
+This function computes the perceptual hash of a picture file (see Image for the formats that are decoded)
+input: the file path, the hash to fill
+output: true if the file was decoded, false otherwise
+*/
+bool PerceptualHash::hashFile(const std::string& path, uint64_t& hash)
+{
+	// a file that can't be decoded isn't read at all
+	Image image;
+	if (!Image::isDecodable(path) || !Image::load(path, image)) {
+		return false;
+	}
+
+	hash = compute(image);
+	return true;
+}
+
+/*
+This function counts the bits two hashes differ in
+input: the hashes
+output: the Hamming distance between them, 0 to 64
+*/
+int PerceptualHash::distance(uint64_t first, uint64_t second)
+{
+	return static_cast<int>(std::bitset<BITS>(first ^ second).count());
+}
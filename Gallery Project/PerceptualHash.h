@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "Image.h"
+
+/*
+A 64 bit perceptual hash of a picture (dHash) - the picture is shrunk to 9x8 gray pixels, and
+every bit tells whether a pixel is brighter than the one on its right. Scaling, recompressing or
+slightly changing the colors of a picture flips few bits, so similar pictures have hashes that are
+a small Hamming distance apart (the number of bits that differ).
+Hash 0 means "no hash" - a picture that wasn't decoded, or a flat one that has nothing to compare by.
+*/
+class PerceptualHash
+{
+public:
+	static const int BITS = 64;
+
+	static uint64_t compute(const Image& image);
+	static bool hashFile(const std::string& path, uint64_t& hash);
+	static int distance(uint64_t first, uint64_t second);
+};
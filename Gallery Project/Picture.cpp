@@ -1,17 +1,17 @@
 ﻿#include "Picture.h"
-#include <ctime>
-#include <sstream>
+#include "TimeFormat.h"
 
 
 Picture::Picture(int id, const std::string& name): 
-	m_pictureId(id), m_name(name), m_pathOnDisk(""), m_creationDate("")
+	m_pictureId(id), m_name(name)
 {
 	setCreationDateNow();
 }
 
-Picture::Picture(int id, const std::string& name, const std::string& pathOnDisk, const std::string& creationDate)
-	: m_pictureId(id), m_name(name), m_pathOnDisk(pathOnDisk), m_creationDate(creationDate)
+Picture::Picture(int id, const std::string& name, const std::string& pathOnDisk, int64_t creationTime)
+	: m_pictureId(id), m_name(name), m_creationTime(creationTime)
 {
+	setPath(pathOnDisk);
 	// Left empty
 }
 
@@ -35,42 +35,126 @@ void Picture::setName(const std::string& name)
 	m_name = name;
 }
 
-const std::string& Picture::getPath() const
+std::string Picture::getPath() const
 {
-	return m_pathOnDisk;
+	return directories().get(m_directory) + m_fileName;
 }
 
 void Picture::setPath(const std::string& location)
 {
-	m_pathOnDisk = location;
+	size_t fileNameStart = location.find_last_of("/\\");
+	fileNameStart = (fileNameStart == std::string::npos) ? 0 : fileNameStart + 1;
+
+	m_directory = directories().intern(std::string_view(location).substr(0, fileNameStart));
+	m_fileName = location.substr(fileNameStart);
 }
 
-const std::string& Picture::getCreationDate() const
+std::string Picture::getCreationDate() const
 {
-	return m_creationDate;
+	return formatTime(m_creationTime);
 }
 
 void Picture::setCreationDate(const std::string& creationTime)
 {
-	m_creationDate = creationTime;
+	parseTime(creationTime, m_creationTime);
 }
 
 void Picture::setCreationDateNow()
 {
-	time_t now = time(nullptr);
-	std::stringstream oss;
-	oss << std::put_time(localtime(&now), "%d/%m/%Y %H:%M:%S");
-	m_creationDate = oss.str();
+	m_creationTime = currentTime();
+}
+
+int64_t Picture::getCreationTime() const
+{
+	return m_creationTime;
+}
+
+void Picture::setCreationTime(int64_t creationTime)
+{
+	m_creationTime = creationTime;
+}
+
+uint64_t Picture::getContentHash() const
+{
+	return m_contentHash;
+}
+
+void Picture::setContentHash(uint64_t contentHash)
+{
+	m_contentHash = contentHash;
+}
+
+uint64_t Picture::getPerceptualHash() const
+{
+	return m_perceptualHash;
+}
+
+void Picture::setPerceptualHash(uint64_t perceptualHash)
+{
+	m_perceptualHash = perceptualHash;
+}
+
+ImageFormat Picture::getFormat() const
+{
+	return m_format;
+}
+
+void Picture::setFormat(ImageFormat format)
+{
+	m_format = format;
+}
+
+int Picture::getWidth() const
+{
+	return m_width;
+}
+
+int Picture::getHeight() const
+{
+	return m_height;
+}
+
+void Picture::setDimensions(int width, int height)
+{
+	m_width = width;
+	m_height = height;
+}
+
+uint64_t Picture::getFileSize() const
+{
+	return m_fileSize;
+}
+
+void Picture::setFileSize(uint64_t fileSize)
+{
+	m_fileSize = fileSize;
+}
+
+void Picture::setImageHeader(const ImageHeader& header)
+{
+	m_format = header.format;
+	setDimensions(header.width, header.height);
+	m_fileSize = header.fileSize;
+}
+
+const ExifMetadata& Picture::getMetadata() const
+{
+	return m_metadata;
+}
+
+void Picture::setMetadata(const ExifMetadata& metadata)
+{
+	m_metadata = metadata;
 }
 
 bool Picture::isUserTagged(const User& user) const
 {
-	return std::find(m_usersTags.begin(), m_usersTags.end(), user.getId()) != m_usersTags.end();
+	return m_usersTags.contains(user.getId());
 }
 
 bool Picture::isUserTagged(int userId) const
 {
-	return std::find(m_usersTags.begin(), m_usersTags.end(), userId) != m_usersTags.end();
+	return m_usersTags.contains(userId);
 }
 
 void Picture::tagUser(const User& user)
@@ -85,16 +169,12 @@ void Picture::tagUser(int userId)
 
 void Picture::untagUser(const User& user)
 {
-	if (isUserTagged(user)) {
-		m_usersTags.erase(std::find(m_usersTags.begin(), m_usersTags.end(), user.getId()));
-	}
+	m_usersTags.erase(user.getId());
 }
 
 void Picture::untagUser(int userId)
 {
-	if (isUserTagged(userId)) {
-		m_usersTags.erase(std::find(m_usersTags.begin(), m_usersTags.end(), userId));
-	}
+	m_usersTags.erase(userId);
 }
 
 int Picture::getTagsCount() const
@@ -102,11 +182,24 @@ int Picture::getTagsCount() const
 	return m_usersTags.size();
 }
 
-const std::set<int>& Picture::getUserTags() const
+const TagSet& Picture::getUserTags() const
 {
 	return m_usersTags;
 }
 
+/*
+This function returns the directories of all the pictures - pictures in the same
+directory share it, and directories share their common parents
+input: none
+output: the directories trie
+*/
+PathTrie& Picture::directories()
+{
+	static PathTrie directories;
+	return directories;
+}
+
+
 bool Picture::operator==(const Picture& other) const
 {
 	return m_pictureId == other.getId();
@@ -114,7 +207,7 @@ bool Picture::operator==(const Picture& other) const
 
 std::ostream& operator<<(std::ostream& strOut, const Picture& pic) {
 	strOut << "Picture@" << pic.m_pictureId << ": ["
-		<< pic.m_name << ", " << pic.m_creationDate << ", " << pic.m_pathOnDisk <<
+		<< pic.getName() << ", " << pic.getCreationDate() << ", " << pic.getPath() <<
 		"] " << pic.getTagsCount() << " users tagged : ";
 	
 	for (const auto user : pic.m_usersTags) {
@@ -1,6 +1,10 @@
 ﻿#pragma once
 #include "User.h"
-#include <set>
+#include "TagSet.h"
+#include "PathTrie.h"
+#include "ImageHeader.h"
+#include "ExifMetadata.h"
+#include <cstdint>
 #include <string>
 #include <memory>
 #include <iomanip>
@@ -10,7 +14,7 @@ class Picture
 public:
 	Picture() = default;
 	Picture(int id, const std::string& name);
-	Picture(int id, const std::string& name, const std::string& pathOnDisk, const std::string& creationDate);
+	Picture(int id, const std::string& name, const std::string& pathOnDisk, int64_t creationTime);
 
 	int getId() const;
 	void setId(int id);
@@ -18,12 +22,28 @@ public:
 	const std::string& getName() const;
 	void setName(const std::string& name);
 
-	const std::string& getPath() const;
+	std::string getPath() const;
 	void setPath(const std::string& location);
 
-	const std::string& getCreationDate() const;
+	std::string getCreationDate() const;
 	void setCreationDate(const std::string& creationTime);
 	void setCreationDateNow();
+	int64_t getCreationTime() const;
+	void setCreationTime(int64_t creationTime);
+	uint64_t getContentHash() const;
+	void setContentHash(uint64_t contentHash);
+	uint64_t getPerceptualHash() const;
+	void setPerceptualHash(uint64_t perceptualHash);
+	ImageFormat getFormat() const;
+	void setFormat(ImageFormat format);
+	int getWidth() const;
+	int getHeight() const;
+	void setDimensions(int width, int height);
+	uint64_t getFileSize() const;
+	void setFileSize(uint64_t fileSize);
+	void setImageHeader(const ImageHeader& header);
+	const ExifMetadata& getMetadata() const;
+	void setMetadata(const ExifMetadata& metadata);
 
 	bool isUserTagged(const User& user) const;
 	bool isUserTagged(int userId) const;
@@ -33,7 +53,7 @@ public:
 	void untagUser(int userId);
 	int getTagsCount() const;
 
-	const std::set<int>& getUserTags() const;
+	const TagSet& getUserTags() const;
 
 	bool operator==(const Picture& other) const;
 	friend std::ostream& operator<<(std::ostream& strout, const Picture& object);
@@ -41,7 +61,23 @@ public:
 private:
 	int m_pictureId;
 	std::string m_name;
-	std::string m_pathOnDisk;
-	std::string m_creationDate;
-	std::set<int> m_usersTags;
+	// the path is kept as an interned directory (see directories()) and a file name
+	PathTrie::Handle m_directory { 0 };
+	std::string m_fileName;
+	// seconds since the epoch, formatted only when shown
+	int64_t m_creationTime { 0 };
+	// the hash of the file's content (see ContentHash), 0 if the file wasn't hashed
+	uint64_t m_contentHash { 0 };
+	// the hash of what the picture looks like (see PerceptualHash), 0 if it wasn't decoded
+	uint64_t m_perceptualHash { 0 };
+	// read from the header of the file (see ImageHeader), 0 / UNKNOWN if it wasn't read
+	uint64_t m_fileSize { 0 };
+	int m_width { 0 };
+	int m_height { 0 };
+	ImageFormat m_format { ImageFormat::UNKNOWN };
+	// what the camera wrote in the file (see ExifMetadata), empty if it wasn't read
+	ExifMetadata m_metadata;
+	TagSet m_usersTags;
+
+	static PathTrie& directories();
 };
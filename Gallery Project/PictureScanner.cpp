@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include "ContentHash.h"
+#include "ExifMetadata.h"
+#include "ImageHeader.h"
+#include "PerceptualHash.h"
+#include "PictureScanner.h"
+
+namespace fs = std::filesystem;
+
+static const char* const PICTURE_EXTENSIONS[] = { ".bmp", ".gif", ".heic", ".jpeg", ".jpg", ".png", ".ppm", ".tif", ".tiff", ".webp" };
+// pictures hashed by one task - enough to make a task worth its scheduling, few enough to spread a big folder over the threads
+static const size_t PICTURES_PER_HASH_TASK = 16;
+
+
+/*
+This function finds the picture files in a folder and all the folders under it
+input: the root folder, the thread pool that lists the folders
+output: the folders that were found (with or without pictures), ordered by name
+*/
+std::vector<PictureScanner::Folder> PictureScanner::scan(const std::string& rootPath, ThreadPool& pool)
+{
+	std::error_code error;
+	fs::path root = fs::absolute(rootPath, error).lexically_normal();
+	if (!root.has_filename()) {
+		root = root.parent_path();
+	}
+
+	// C++17 has no clock_cast - the file clock is moved to the system clock by the difference between them now
+	const auto fileClockOffset = std::chrono::system_clock::now().time_since_epoch() -
+		std::chrono::duration_cast<std::chrono::system_clock::duration>(fs::file_time_type::clock::now().time_since_epoch());
+
+	std::vector<Folder> folders;
+	std::mutex foldersMutex;
+
+	std::function<void(fs::path, std::string)> scanFolder = [&](fs::path folderPath, std::string name) {
+		Folder folder { std::move(name), {} };
+		std::error_code entryError;
+
+		for (fs::directory_iterator entry(folderPath, fs::directory_options::skip_permission_denied, entryError), end; !entryError && entry != end; entry.increment(entryError)) {
+			// linked folders are skipped, they may lead back up the tree
+			if (entry->is_directory(entryError) && !entry->is_symlink(entryError)) {
+				pool.submit([&scanFolder, path = entry->path(), subfolderName = folder.name + "/" + entry->path().filename().string()]() {
+					scanFolder(path, subfolderName);
+				});
+			}
+			else if (entry->is_regular_file(entryError) && isPictureFile(entry->path())) {
+				auto writeTime = entry->last_write_time(entryError).time_since_epoch();
+				auto creationTime = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::duration_cast<std::chrono::system_clock::duration>(writeTime) + fileClockOffset);
+				folder.pictures.emplace_back(0, entry->path().filename().string(), entry->path().string(), creationTime.count());
+			}
+			// a file that vanished or can't be read doesn't stop the listing
+			entryError.clear();
+		}
+
+		std::sort(folder.pictures.begin(), folder.pictures.end(), [](const Picture& first, const Picture& second) {
+			return first.getName() < second.getName();
+		});
+
+		std::lock_guard<std::mutex> lock(foldersMutex);
+		folders.push_back(std::move(folder));
+	};
+
+	if (fs::is_directory(root, error)) {
+		std::string rootName = root.filename().string();
+		pool.submit([&scanFolder, &root, rootName]() {
+			scanFolder(root, rootName.empty() ? root.string() : rootName);
+		});
+		pool.wait();
+	}
+
+	std::sort(folders.begin(), folders.end(), [](const Folder& first, const Folder& second) {
+		return first.name < second.name;
+	});
+	return folders;
+}
+
+/*
+This function reads the header of the pictures of the folders (see ImageHeader) and the EXIF metadata
+of the JPEGs (see ExifMetadata), hashes their content (see ContentHash), and what the pictures that
+can be decoded look like (see PerceptualHash).
+A hash that can't be computed stays 0.
+input: the folders, the thread pool that hashes the pictures
+output: how many pictures had their content hashed
+*/
+size_t PictureScanner::hashPictures(std::vector<Folder>& folders, ThreadPool& pool)
+{
+	std::atomic<size_t> hashedCount { 0 };
+
+	for (Folder& folder : folders) {
+		for (size_t first = 0; first < folder.pictures.size(); first += PICTURES_PER_HASH_TASK) {
+			Picture* begin = folder.pictures.data() + first;
+			Picture* end = folder.pictures.data() + std::min(first + PICTURES_PER_HASH_TASK, folder.pictures.size());
+
+			// every task has its own pictures, nothing else touches them until the pool is done
+			pool.submit([begin, end, &hashedCount]() {
+				for (Picture* picture = begin; picture != end; ++picture) {
+					std::string path = picture->getPath();
+					ImageHeader header;
+					ImageHeader::read(path, header);
+					picture->setImageHeader(header);
+
+					ExifMetadata metadata;
+					if (ImageFormat::JPEG == header.format && ExifMetadata::read(path, metadata)) {
+						picture->setMetadata(metadata);
+					}
+
+					uint64_t contentHash = 0, perceptualHash = 0;
+					if (ContentHash::hashFile(path, contentHash)) {
+						picture->setContentHash(contentHash);
+						++hashedCount;
+					}
+					// the file was just read, decoding it reads it again from the page cache
+					if (PerceptualHash::hashFile(path, perceptualHash)) {
+						picture->setPerceptualHash(perceptualHash);
+					}
+				}
+			});
+		}
+	}
+	pool.wait();
+
+	return hashedCount;
+}
+
+/*
+This function checks by its extension if a file is a picture
+input: the file path
+output: true if the file is a picture, false otherwise
+*/
+bool PictureScanner::isPictureFile(const fs::path& path)
+{
+	std::string extension = path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) {
+		return static_cast<char>(std::tolower(c));
+	});
+
+	return std::find(std::begin(PICTURE_EXTENSIONS), std::end(PICTURE_EXTENSIONS), extension) != std::end(PICTURE_EXTENSIONS);
+}
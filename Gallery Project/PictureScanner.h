@@ -0,0 +1,28 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "Picture.h"
+#include "ThreadPool.h"
+
+/*
+Finds the picture files of a directory tree. Every folder is listed by its own task on a thread
+pool, so the folders of the tree are listed (and their files are stat'ed) in parallel.
+The pictures that were found are read (header and hashes) on the thread pool too, a few files per task.
+*/
+class PictureScanner
+{
+public:
+	// a folder of the tree and the pictures right in it
+	struct Folder
+	{
+		// the path of the folder from the root folder, starting with the name of the root folder
+		std::string name;
+		// ordered by name, their ids are 0 (the data access gives the ids)
+		std::vector<Picture> pictures;
+	};
+
+	static std::vector<Folder> scan(const std::string& rootPath, ThreadPool& pool);
+	static size_t hashPictures(std::vector<Folder>& folders, ThreadPool& pool);
+	static bool isPictureFile(const std::filesystem::path& path);
+};
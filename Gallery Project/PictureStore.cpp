@@ -0,0 +1,146 @@
+#include "PictureStore.h"
+
+
+const std::vector<Picture>& PictureStore::getPictures() const
+{
+	return m_pictures;
+}
+
+size_t PictureStore::size() const
+{
+	return m_pictures.size();
+}
+
+bool PictureStore::empty() const
+{
+	return m_pictures.empty();
+}
+
+
+const Picture* PictureStore::find(const std::string& pictureName) const
+{
+	auto index = m_indexByName.find(pictureName);
+	return index == m_indexByName.end() ? nullptr : &m_pictures[index->second];
+}
+
+const Picture* PictureStore::find(int pictureId) const
+{
+	auto index = m_indexById.find(pictureId);
+	return index == m_indexById.end() ? nullptr : &m_pictures[index->second];
+}
+
+Picture* PictureStore::find(const std::string& pictureName)
+{
+	return const_cast<Picture*>(static_cast<const PictureStore*>(this)->find(pictureName));
+}
+
+Picture* PictureStore::find(int pictureId)
+{
+	return const_cast<Picture*>(static_cast<const PictureStore*>(this)->find(pictureId));
+}
+
+
+void PictureStore::add(const Picture& picture)
+{
+	m_pictures.push_back(picture);
+	index(m_pictures.size() - 1);
+}
+
+void PictureStore::add(Picture&& picture)
+{
+	m_pictures.push_back(std::move(picture));
+	index(m_pictures.size() - 1);
+}
+
+void PictureStore::reserve(size_t count)
+{
+	m_pictures.reserve(count);
+	m_indexByName.reserve(count);
+	m_indexById.reserve(count);
+}
+
+/*
+This function removes a picture - the last picture is moved into its place
+input: the picture name
+output: true if the picture was removed, false if there is no such picture
+*/
+bool PictureStore::remove(const std::string& pictureName)
+{
+	auto found = m_indexByName.find(pictureName);
+	if (found == m_indexByName.end()) {
+		return false;
+	}
+
+	size_t position = found->second;
+	size_t last = m_pictures.size() - 1;
+
+	unindex(position);
+	if (position != last) {
+		unindex(last);
+		m_pictures[position] = std::move(m_pictures[last]);
+		index(position);
+	}
+	m_pictures.pop_back();
+
+	// another picture with the removed name (or id) takes its place in the indexes
+	if (m_hasDuplicates) {
+		for (size_t other = 0; other < m_pictures.size(); ++other) {
+			index(other);
+		}
+	}
+
+	return true;
+}
+
+
+void PictureStore::tagUser(int userId)
+{
+	for (auto& picture : m_pictures) {
+		picture.tagUser(userId);
+	}
+}
+
+void PictureStore::untagUser(int userId)
+{
+	for (auto& picture : m_pictures) {
+		picture.untagUser(userId);
+	}
+}
+
+
+/*
+This function indexes the picture at a position, unless its name (or id) is already indexed
+input: the position
+output: none
+*/
+void PictureStore::index(size_t position)
+{
+	const Picture& picture = m_pictures[position];
+
+	bool isNewName = m_indexByName.emplace(picture.getName(), position).second;
+	bool isNewId = m_indexById.emplace(picture.getId(), position).second;
+
+	if (!(isNewName && isNewId)) {
+		m_hasDuplicates = true;
+	}
+}
+
+/*
+This function removes the picture at a position from the indexes (if it is the indexed one)
+input: the position
+output: none
+*/
+void PictureStore::unindex(size_t position)
+{
+	const Picture& picture = m_pictures[position];
+
+	auto byName = m_indexByName.find(picture.getName());
+	if (byName != m_indexByName.end() && byName->second == position) {
+		m_indexByName.erase(byName);
+	}
+
+	auto byId = m_indexById.find(picture.getId());
+	if (byId != m_indexById.end() && byId->second == position) {
+		m_indexById.erase(byId);
+	}
+}
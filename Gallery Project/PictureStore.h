@@ -0,0 +1,44 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Picture.h"
+
+/*
+The pictures of an album, stored contiguously, with hash indexes from a picture name and
+from a picture id to the picture's position - so finding, adding and removing a picture
+take constant time. Pictures are kept in the order they were added, except that removing
+a picture moves the last picture into its place.
+The name and id of a picture in the store must not be changed.
+If several pictures have the same name (or id), lookups find one of them.
+*/
+class PictureStore
+{
+public:
+	const std::vector<Picture>& getPictures() const;
+	size_t size() const;
+	bool empty() const;
+
+	const Picture* find(const std::string& pictureName) const;
+	const Picture* find(int pictureId) const;
+	Picture* find(const std::string& pictureName);
+	Picture* find(int pictureId);
+
+	void add(const Picture& picture);
+	void add(Picture&& picture);
+	void reserve(size_t count);
+	bool remove(const std::string& pictureName);
+
+	void tagUser(int userId);
+	void untagUser(int userId);
+
+private:
+	std::vector<Picture> m_pictures;
+	std::unordered_map<std::string, size_t> m_indexByName;
+	std::unordered_map<int, size_t> m_indexById;
+	// whether a picture was added with the name (or id) of another picture
+	bool m_hasDuplicates { false };
+
+	void index(size_t position);
+	void unindex(size_t position);
+};
@@ -0,0 +1,440 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include "SnapshotFile.h"
+#include "OperationLog.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char SNAPSHOT_MAGIC[8] = { 'G', 'A', 'L', 'S', 'N', 'A', 'P', '\0' };
+// read back in another byte order it doesn't match
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+
+SnapshotFile::~SnapshotFile()
+{
+	close();
+}
+
+
+// ******************* Writing *******************
+/*
+This function makes up a stamp for a new snapshot, that ties it to the data it was saved from
+input: none
+output: a random positive 63 bit number (so it fits a signed column), never 0
+*/
+uint64_t SnapshotFile::newStamp()
+{
+	std::random_device randomDevice;
+	std::mt19937_64 random((static_cast<uint64_t>(randomDevice()) << 32) ^ randomDevice() ^
+		static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+
+	return (random() >> 1) | 1;
+}
+
+/*
+This function writes a snapshot of a gallery. The snapshot is written to a temporary file
+first, synced to the disk and then renamed, so an existing snapshot is replaced only by a complete one -
+and once it returns, the new snapshot is on the disk (a DB may be stamped with it).
+input: the snapshot file name, the stamp that ties the snapshot to its DB, the users, the albums,
+	a function that returns the pictures (with their tags) of an album
+output: true if the snapshot was written, false otherwise
+*/
+bool SnapshotFile::save(const std::string& fileName, uint64_t stamp, const std::list<User>& users, const std::list<Album>& albums,
+	const std::function<std::vector<Picture>(const Album&)>& getPictures)
+{
+	const std::string tempFileName = fileName + ".tmp";
+	std::ofstream file(tempFileName, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		return false;
+	}
+
+	Header header = {};
+	std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+	header.version = VERSION;
+	header.byteOrder = BYTE_ORDER_MARK;
+	header.stamp = stamp;
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	uint64_t position = sizeof(header);
+	std::vector<char> chunk;
+	auto appendText = [&chunk, &position](const std::string& str) {
+		uint64_t offset = position + chunk.size();
+		chunk.insert(chunk.end(), str.begin(), str.end());
+		return offset;
+	};
+	auto writeChunk = [&file, &chunk, &position]() {
+		// every chunk starts 8 bytes aligned, so its records may be read in place
+		chunk.resize((chunk.size() + 7) / 8 * 8, '\0');
+		file.write(chunk.data(), chunk.size());
+		position += chunk.size();
+		chunk.clear();
+	};
+
+	// the chunk of every album - its picture records, then their tags, then their strings
+	std::vector<AlbumRecord> albumRecords;
+	albumRecords.reserve(albums.size());
+
+	for (const Album& album : albums) {
+		std::vector<Picture> pictures = getPictures(album);
+		std::sort(pictures.begin(), pictures.end(), [](const Picture& first, const Picture& second) {
+			return first.getId() < second.getId();
+		});
+
+		size_t tagsCount = 0;
+		for (const Picture& picture : pictures) {
+			tagsCount += picture.getUserTags().size();
+		}
+
+		uint64_t picturesOffset = position;
+		uint64_t tagsOffset = picturesOffset + pictures.size() * sizeof(PictureRecord);
+		chunk.resize(pictures.size() * sizeof(PictureRecord) + tagsCount * sizeof(int32_t));
+
+		size_t tag = 0;
+		for (size_t i = 0; i < pictures.size(); ++i) {
+			const Picture& picture = pictures[i];
+			PictureRecord record = {};
+			record.id = picture.getId();
+			record.creationTime = picture.getCreationTime();
+			record.contentHash = picture.getContentHash();
+			record.perceptualHash = picture.getPerceptualHash();
+			record.fileSize = picture.getFileSize();
+			record.width = picture.getWidth();
+			record.height = picture.getHeight();
+			record.format = static_cast<uint32_t>(picture.getFormat());
+			const ExifMetadata& metadata = picture.getMetadata();
+			record.captureTime = metadata.captureTime;
+			record.cameraModelLength = static_cast<uint32_t>(metadata.cameraModel.size());
+			record.cameraModelOffset = appendText(metadata.cameraModel);
+			record.hasLocation = metadata.hasLocation ? 1 : 0;
+			record.latitude = metadata.latitude;
+			record.longitude = metadata.longitude;
+			record.nameLength = static_cast<uint32_t>(picture.getName().size());
+			record.nameOffset = appendText(picture.getName());
+			std::string path = picture.getPath();
+			record.pathLength = static_cast<uint32_t>(path.size());
+			record.pathOffset = appendText(path);
+			record.tagsCount = static_cast<uint32_t>(picture.getUserTags().size());
+			record.tagsOffset = tagsOffset + tag * sizeof(int32_t);
+
+			for (int userId : picture.getUserTags()) {
+				int32_t value = userId;
+				std::memcpy(chunk.data() + (tagsOffset - picturesOffset) + tag++ * sizeof(int32_t), &value, sizeof(value));
+			}
+			std::memcpy(chunk.data() + i * sizeof(PictureRecord), &record, sizeof(record));
+		}
+
+		AlbumRecord albumRecord = {};
+		albumRecord.id = album.getId();
+		albumRecord.ownerId = album.getOwnerId();
+		albumRecord.creationTime = album.getCreationTime();
+		albumRecord.nameLength = static_cast<uint32_t>(album.getName().size());
+		albumRecord.nameOffset = appendText(album.getName());
+		albumRecord.picturesCount = static_cast<uint32_t>(pictures.size());
+		albumRecord.picturesOffset = picturesOffset;
+		albumRecords.push_back(albumRecord);
+
+		header.picturesCount += pictures.size();
+		header.tagsCount += tagsCount;
+		writeChunk();
+	}
+
+	// the user names, then the users table
+	std::vector<UserRecord> userRecords;
+	userRecords.reserve(users.size());
+	for (const User& user : users) {
+		UserRecord record = {};
+		record.id = user.getId();
+		record.nameLength = static_cast<uint32_t>(user.getName().size());
+		record.nameOffset = appendText(user.getName());
+		userRecords.push_back(record);
+	}
+	writeChunk();
+
+	std::sort(userRecords.begin(), userRecords.end(), [](const UserRecord& first, const UserRecord& second) {
+		return first.id < second.id;
+	});
+	header.usersOffset = position;
+	header.usersCount = userRecords.size();
+	file.write(reinterpret_cast<const char*>(userRecords.data()), userRecords.size() * sizeof(UserRecord));
+	position += userRecords.size() * sizeof(UserRecord);
+
+	// ordered by id, so an album is found by a binary search
+	std::sort(albumRecords.begin(), albumRecords.end(), [](const AlbumRecord& first, const AlbumRecord& second) {
+		return first.id < second.id;
+	});
+	header.albumsOffset = position;
+	header.albumsCount = albumRecords.size();
+	file.write(reinterpret_cast<const char*>(albumRecords.data()), albumRecords.size() * sizeof(AlbumRecord));
+	position += albumRecords.size() * sizeof(AlbumRecord);
+
+	header.fileSize = position;
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.close();
+
+	if (!(file && OperationLog::syncFile(tempFileName) && OperationLog::replaceFile(tempFileName, fileName))) {
+		std::remove(tempFileName.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+
+// ******************* Reading *******************
+/*
+This function maps a snapshot file into memory (a snapshot that is already open is closed first)
+input: the snapshot file name
+output: true if the file is a valid snapshot of this version, false otherwise
+*/
+bool SnapshotFile::open(const std::string& fileName)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (INVALID_HANDLE_VALUE == file) {
+		return false;
+	}
+	m_file = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart < static_cast<LONGLONG>(sizeof(Header))) {
+		close();
+		return false;
+	}
+
+	m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	const void* data = m_mapping ? MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (nullptr == data) {
+		close();
+		return false;
+	}
+	m_data = static_cast<const char*>(data);
+	m_size = static_cast<size_t>(size.QuadPart);
+#else
+	int file = ::open(fileName.c_str(), O_RDONLY);
+	if (file < 0) {
+		return false;
+	}
+
+	struct stat status;
+	if (fstat(file, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(Header))) {
+		::close(file);
+		return false;
+	}
+
+	// the mapping keeps the file alive, the descriptor isn't needed anymore
+	void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	::close(file);
+	if (MAP_FAILED == data) {
+		return false;
+	}
+	m_data = static_cast<const char*>(data);
+	m_size = static_cast<size_t>(status.st_size);
+#endif
+
+	const Header& fileHeader = header();
+	if (std::memcmp(fileHeader.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 || fileHeader.version != VERSION ||
+		fileHeader.byteOrder != BYTE_ORDER_MARK || fileHeader.fileSize != m_size ||
+		nullptr == records<UserRecord>(fileHeader.usersOffset, fileHeader.usersCount) ||
+		nullptr == records<AlbumRecord>(fileHeader.albumsOffset, fileHeader.albumsCount))
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void SnapshotFile::close()
+{
+#ifdef _WIN32
+	if (m_data) {
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping) {
+		CloseHandle(m_mapping);
+	}
+	if (m_file) {
+		CloseHandle(m_file);
+	}
+	m_mapping = nullptr;
+	m_file = nullptr;
+#else
+	if (m_data) {
+		munmap(const_cast<char*>(m_data), m_size);
+	}
+#endif
+
+	m_data = nullptr;
+	m_size = 0;
+}
+
+bool SnapshotFile::isOpen() const
+{
+	return m_data != nullptr;
+}
+
+
+uint64_t SnapshotFile::getStamp() const
+{
+	return header().stamp;
+}
+
+uint64_t SnapshotFile::getPicturesCount() const
+{
+	return header().picturesCount;
+}
+
+uint64_t SnapshotFile::getTagsCount() const
+{
+	return header().tagsCount;
+}
+
+size_t SnapshotFile::getUsersCount() const
+{
+	return static_cast<size_t>(header().usersCount);
+}
+
+User SnapshotFile::getUser(size_t index) const
+{
+	const UserRecord& record = records<UserRecord>(header().usersOffset, header().usersCount)[index];
+	std::string name;
+	text(record.nameOffset, record.nameLength, name);
+
+	return User(record.id, name);
+}
+
+size_t SnapshotFile::getAlbumsCount() const
+{
+	return static_cast<size_t>(header().albumsCount);
+}
+
+/*
+This function returns an album of the snapshot without its pictures (see readPictures)
+input: the index of the album in the albums table
+output: the album
+*/
+Album SnapshotFile::getAlbum(size_t index) const
+{
+	const AlbumRecord& record = records<AlbumRecord>(header().albumsOffset, header().albumsCount)[index];
+	std::string name;
+	text(record.nameOffset, record.nameLength, name);
+
+	Album album(record.ownerId, name, record.creationTime);
+	album.setId(record.id);
+	return album;
+}
+
+/*
+This function finds an album in the albums table
+input: the album id
+output: the index of the album, NOT_FOUND if there is no such album
+*/
+size_t SnapshotFile::findAlbum(int albumId) const
+{
+	const AlbumRecord* albums = records<AlbumRecord>(header().albumsOffset, header().albumsCount);
+	const AlbumRecord* end = albums + header().albumsCount;
+
+	const AlbumRecord* album = std::lower_bound(albums, end, albumId, [](const AlbumRecord& record, int id) {
+		return record.id < id;
+	});
+	return (album == end || album->id != albumId) ? NOT_FOUND : static_cast<size_t>(album - albums);
+}
+
+/*
+This function adds the pictures of an album in the snapshot, with their tags, to an album
+input: the index of the album in the albums table, the album to add them to
+output: true if all the pictures were read, false if the snapshot is damaged
+*/
+bool SnapshotFile::readPictures(size_t index, Album& album) const
+{
+	const AlbumRecord& albumRecord = records<AlbumRecord>(header().albumsOffset, header().albumsCount)[index];
+	const PictureRecord* pictures = records<PictureRecord>(albumRecord.picturesOffset, albumRecord.picturesCount);
+	if (nullptr == pictures) {
+		return false;
+	}
+
+	album.reservePictures(album.getPictures().size() + albumRecord.picturesCount);
+
+	// reused for every picture
+	std::string name, path;
+	ExifMetadata metadata;
+
+	for (const PictureRecord* record = pictures; record != pictures + albumRecord.picturesCount; ++record) {
+		const int32_t* tags = records<int32_t>(record->tagsOffset, record->tagsCount);
+		if (nullptr == tags || !text(record->nameOffset, record->nameLength, name) || !text(record->pathOffset, record->pathLength, path) ||
+			!text(record->cameraModelOffset, record->cameraModelLength, metadata.cameraModel))
+		{
+			return false;
+		}
+
+		Picture picture(record->id, name, path, record->creationTime);
+		picture.setContentHash(record->contentHash);
+		picture.setPerceptualHash(record->perceptualHash);
+		picture.setDimensions(record->width, record->height);
+		picture.setFormat(static_cast<ImageFormat>(record->format));
+		picture.setFileSize(record->fileSize);
+		metadata.captureTime = record->captureTime;
+		metadata.hasLocation = record->hasLocation != 0;
+		metadata.latitude = record->latitude;
+		metadata.longitude = record->longitude;
+		picture.setMetadata(metadata);
+		for (const int32_t* tag = tags; tag != tags + record->tagsCount; ++tag) {
+			picture.tagUser(*tag);
+		}
+		album.addPicture(std::move(picture));
+	}
+
+	return true;
+}
+
+
+const SnapshotFile::Header& SnapshotFile::header() const
+{
+	return *reinterpret_cast<const Header*>(m_data);
+}
+
+/*
+This function returns an array of records in the file
+input: the offset of the array, the count of records
+output: the records, nullptr if they aren't (aligned) inside the file
+*/
+template <class Record>
+const Record* SnapshotFile::records(uint64_t offset, uint64_t count) const
+{
+	if (offset % alignof(Record) != 0 || offset > m_size || count > (m_size - offset) / sizeof(Record)) {
+		return nullptr;
+	}
+
+	return reinterpret_cast<const Record*>(m_data + offset);
+}
+
+/*
+This function reads a string of the file
+input: the offset and length of the string, the string (output parameter)
+output: true if the string is inside the file, false otherwise
+*/
+bool SnapshotFile::text(uint64_t offset, uint32_t length, std::string& str) const
+{
+	if (offset > m_size || length > m_size - offset) {
+		return false;
+	}
+
+	str.assign(m_data + offset, length);
+	return true;
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+#include <vector>
+#include "Album.h"
+#include "User.h"
+
+/*
+A flat binary snapshot of a whole gallery (users, albums, pictures and tags) in one file.
+The file is memory mapped and read in place - every record is a fixed size struct and refers
+to its strings, pictures and tags by their offset in the file, so nothing has to be parsed or
+fixed up on open, and an album's pictures are read only when they are asked for.
+Layout: a header, then every album's chunk (its picture records, their tags, their strings),
+then the user strings, the users table and the albums table (ordered by album id).
+The file is written in the byte order of the machine that writes it, a file of another
+version or byte order is rejected by open().
+*/
+class SnapshotFile
+{
+public:
+	static const uint32_t VERSION = 5;
+	static const size_t NOT_FOUND = static_cast<size_t>(-1);
+
+	SnapshotFile() = default;
+	~SnapshotFile();
+	SnapshotFile(const SnapshotFile&) = delete;
+	SnapshotFile& operator=(const SnapshotFile&) = delete;
+
+	static uint64_t newStamp();
+	static bool save(const std::string& fileName, uint64_t stamp, const std::list<User>& users, const std::list<Album>& albums,
+		const std::function<std::vector<Picture>(const Album&)>& getPictures);
+
+	bool open(const std::string& fileName);
+	void close();
+	bool isOpen() const;
+
+	uint64_t getStamp() const;
+	uint64_t getPicturesCount() const;
+	uint64_t getTagsCount() const;
+	size_t getUsersCount() const;
+	User getUser(size_t index) const;
+	size_t getAlbumsCount() const;
+	Album getAlbum(size_t index) const;
+	size_t findAlbum(int albumId) const;
+	bool readPictures(size_t index, Album& album) const;
+
+private:
+	struct Header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t byteOrder;
+		uint64_t stamp;
+		uint64_t fileSize;
+		uint64_t usersOffset;
+		uint64_t usersCount;
+		uint64_t albumsOffset;
+		uint64_t albumsCount;
+		uint64_t picturesCount;
+		uint64_t tagsCount;
+	};
+
+	struct UserRecord
+	{
+		int32_t id;
+		uint32_t nameLength;
+		uint64_t nameOffset;
+	};
+
+	struct AlbumRecord
+	{
+		int32_t id;
+		int32_t ownerId;
+		int64_t creationTime;
+		uint64_t nameOffset;
+		uint32_t nameLength;
+		uint32_t picturesCount;
+		uint64_t picturesOffset;
+	};
+
+	struct PictureRecord
+	{
+		int32_t id;
+		uint32_t tagsCount;
+		int64_t creationTime;
+		uint64_t contentHash;
+		uint64_t perceptualHash;
+		uint64_t fileSize;
+		uint64_t nameOffset;
+		uint64_t pathOffset;
+		uint64_t tagsOffset;
+		uint32_t nameLength;
+		uint32_t pathLength;
+		int32_t width;
+		int32_t height;
+		uint32_t format;
+		uint32_t cameraModelLength;
+		// the EXIF metadata (see ExifMetadata), all 0 if the picture has none
+		int64_t captureTime;
+		uint64_t cameraModelOffset;
+		double latitude;
+		double longitude;
+		uint32_t hasLocation;
+		// keeps the record a multiple of 8 bytes with no padding, always 0
+		uint32_t reserved;
+	};
+
+	const char* m_data { nullptr };
+	size_t m_size { 0 };
+#ifdef _WIN32
+	void* m_file { nullptr };
+	void* m_mapping { nullptr };
+#endif
+
+	const Header& header() const;
+	template <class Record>
+	const Record* records(uint64_t offset, uint64_t count) const;
+	bool text(uint64_t offset, uint32_t length, std::string& str) const;
+};
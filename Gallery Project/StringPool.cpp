@@ -0,0 +1,47 @@
+#include <mutex>
+#include "StringPool.h"
+
+
+StringPool::StringPool()
+{
+	intern("");
+}
+
+/*
+This function returns the handle of a string, adding the string to the pool if it is new
+input: the string
+output: the handle
+*/
+StringPool::Handle StringPool::intern(std::string_view str)
+{
+	{
+		std::shared_lock<std::shared_mutex> lock(m_mutex);
+		auto handle = m_handles.find(str);
+		if (handle != m_handles.end()) {
+			return handle->second;
+		}
+	}
+
+	std::unique_lock<std::shared_mutex> lock(m_mutex);
+	auto handle = m_handles.find(str);
+	if (handle != m_handles.end()) {
+		return handle->second;
+	}
+
+	m_strings.emplace_back(str);
+	Handle newHandle = static_cast<Handle>(m_strings.size() - 1);
+	m_handles.emplace(m_strings.back(), newHandle);
+	return newHandle;
+}
+
+const std::string& StringPool::get(Handle handle) const
+{
+	std::shared_lock<std::shared_mutex> lock(m_mutex);
+	return m_strings[handle];
+}
+
+size_t StringPool::size() const
+{
+	std::shared_lock<std::shared_mutex> lock(m_mutex);
+	return m_strings.size();
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/*
+A table of interned strings - every distinct string is stored once and is referred to
+by a small handle. Strings are never removed, so a handle (and the reference returned
+for it) stays valid as long as the pool lives. Handle 0 is the empty string.
+The pool may be used from several threads at once.
+*/
+class StringPool
+{
+public:
+	using Handle = uint32_t;
+
+	StringPool();
+
+	Handle intern(std::string_view str);
+	const std::string& get(Handle handle) const;
+	size_t size() const;
+
+private:
+	mutable std::shared_mutex m_mutex;
+	// a deque never moves its strings, so the views of m_handles stay valid
+	std::deque<std::string> m_strings;
+	std::unordered_map<std::string_view, Handle> m_handles;
+};
@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <cstring>
+#include "TagSet.h"
+
+
+TagSet::TagSet(const TagSet& other)
+{
+	*this = other;
+}
+
+TagSet::TagSet(TagSet&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+TagSet& TagSet::operator=(const TagSet& other)
+{
+	if (this == &other) {
+		return *this;
+	}
+
+	release();
+
+	// a copy takes only the capacity it needs
+	if (other.m_size > INLINE_CAPACITY) {
+		m_heap = new int[other.m_size];
+		m_capacity = other.m_size;
+	}
+	std::memcpy(data(), other.data(), other.m_size * sizeof(int));
+	m_size = other.m_size;
+
+	return *this;
+}
+
+TagSet& TagSet::operator=(TagSet&& other) noexcept
+{
+	if (this == &other) {
+		return *this;
+	}
+
+	release();
+
+	if (other.isInline()) {
+		std::memcpy(m_inline, other.m_inline, other.m_size * sizeof(int));
+	}
+	else {
+		m_heap = other.m_heap;
+		m_capacity = other.m_capacity;
+		other.m_capacity = INLINE_CAPACITY;
+	}
+	m_size = other.m_size;
+	other.m_size = 0;
+
+	return *this;
+}
+
+TagSet::~TagSet()
+{
+	release();
+}
+
+
+bool TagSet::contains(int userId) const
+{
+	const int* position = lowerBound(userId);
+	return position != end() && *position == userId;
+}
+
+/*
+This function adds a user id, keeping the ids sorted
+input: the user id
+output: true if the id was added, false if it was already in the set
+*/
+bool TagSet::insert(int userId)
+{
+	size_t index = lowerBound(userId) - begin();
+	if (index < m_size && data()[index] == userId) {
+		return false;
+	}
+
+	if (m_size == m_capacity) {
+		uint32_t capacity = m_capacity * 2;
+		int* heap = new int[capacity];
+		std::memcpy(heap, data(), m_size * sizeof(int));
+		if (!isInline()) {
+			delete[] m_heap;
+		}
+		m_heap = heap;
+		m_capacity = capacity;
+	}
+
+	int* ids = data();
+	std::memmove(ids + index + 1, ids + index, (m_size - index) * sizeof(int));
+	ids[index] = userId;
+	++m_size;
+
+	return true;
+}
+
+/*
+This function removes a user id
+input: the user id
+output: true if the id was removed, false if it was not in the set
+*/
+bool TagSet::erase(int userId)
+{
+	size_t index = lowerBound(userId) - begin();
+	if (index == m_size || data()[index] != userId) {
+		return false;
+	}
+
+	int* ids = data();
+	std::memmove(ids + index, ids + index + 1, (m_size - index - 1) * sizeof(int));
+	--m_size;
+
+	return true;
+}
+
+
+size_t TagSet::size() const
+{
+	return m_size;
+}
+
+bool TagSet::empty() const
+{
+	return 0 == m_size;
+}
+
+size_t TagSet::capacity() const
+{
+	return m_capacity;
+}
+
+TagSet::const_iterator TagSet::begin() const
+{
+	return data();
+}
+
+TagSet::const_iterator TagSet::end() const
+{
+	return data() + m_size;
+}
+
+
+bool TagSet::isInline() const
+{
+	return m_capacity == INLINE_CAPACITY;
+}
+
+int* TagSet::data()
+{
+	return isInline() ? m_inline : m_heap;
+}
+
+const int* TagSet::data() const
+{
+	return isInline() ? m_inline : m_heap;
+}
+
+const int* TagSet::lowerBound(int userId) const
+{
+	return std::lower_bound(begin(), end(), userId);
+}
+
+/*
+This function frees the heap array (if there is one), leaving an empty inline set
+input: none
+output: none
+*/
+void TagSet::release()
+{
+	if (!isInline()) {
+		delete[] m_heap;
+	}
+	m_capacity = INLINE_CAPACITY;
+	m_size = 0;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/*
+The ids of the users tagged in a picture, as a sorted array of ints.
+Up to INLINE_CAPACITY ids are kept inside the object itself, more ids are moved to one
+heap array - so a picture costs no allocation per tag (as a std::set does), and finding
+an id is a binary search over contiguous memory.
+*/
+class TagSet
+{
+public:
+	using const_iterator = const int*;
+
+	TagSet() = default;
+	TagSet(const TagSet& other);
+	TagSet(TagSet&& other) noexcept;
+	TagSet& operator=(const TagSet& other);
+	TagSet& operator=(TagSet&& other) noexcept;
+	~TagSet();
+
+	bool contains(int userId) const;
+	bool insert(int userId);
+	bool erase(int userId);
+
+	size_t size() const;
+	bool empty() const;
+	size_t capacity() const;
+
+	const_iterator begin() const;
+	const_iterator end() const;
+
+	static const uint32_t INLINE_CAPACITY = 6;
+
+private:
+	uint32_t m_size { 0 };
+	uint32_t m_capacity { INLINE_CAPACITY };
+	union
+	{
+		int m_inline[INLINE_CAPACITY];
+		int* m_heap;
+	};
+
+	bool isInline() const;
+	int* data();
+	const int* data() const;
+	const int* lowerBound(int userId) const;
+	void release();
+};
@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Album.h"
+
+/*
+Benchmark of the pictures of an album - the PictureStore that Album keeps them in, against
+the std::list with linear searches that Album used before it (ListAlbum below keeps that code).
+For every album size it times building the album, finding / tagging pictures by name,
+removing pictures by name, and a full scan of the pictures.
+Build it in Release, the numbers of a Debug build mean little.
+*/
+
+static const size_t ALBUM_SIZES[] = { 10000, 100000 };
+// the lookups and removals that are timed on every album (random pictures)
+static const size_t OPERATIONS_COUNT = 200;
+static const int SCANS_COUNT = 20;
+
+
+/*
+The pictures of an album as Album kept them before the PictureStore - a list that is searched by name
+*/
+class ListAlbum
+{
+public:
+	void addPicture(const Picture& picture)
+	{
+		m_pictures.push_back(picture);
+	}
+
+	bool doesPictureExists(const std::string& name) const
+	{
+		for (const auto& picture : m_pictures) {
+			if (name == picture.getName()) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	const Picture& getPicture(const std::string& pictureName) const
+	{
+		for (auto& picture : m_pictures) {
+			if (pictureName == picture.getName()) {
+				return picture;
+			}
+		}
+		throw std::out_of_range(pictureName);
+	}
+
+	void tagUserInPicture(int userId, const std::string& pictureName)
+	{
+		for (auto& picture : m_pictures) {
+			if (picture.getName() == pictureName) {
+				picture.tagUser(userId);
+			}
+		}
+	}
+
+	void removePicture(const std::string& pictureName)
+	{
+		for (const auto& picture : m_pictures) {
+			if (pictureName == picture.getName()) {
+				m_pictures.remove(picture);
+				return;
+			}
+		}
+	}
+
+	const std::list<Picture>& getPictures() const
+	{
+		return m_pictures;
+	}
+
+private:
+	std::list<Picture> m_pictures;
+};
+
+
+struct Timings
+{
+	double build;		// ms for the whole album
+	double lookup;		// us per exists + get + tag of one picture
+	double remove;		// us per removal
+	double scan;		// ms per full scan
+};
+
+
+static double elapsed(std::chrono::steady_clock::time_point startTime)
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+static std::string pictureName(size_t picture)
+{
+	return "Picture " + std::to_string(picture);
+}
+
+/*
+This function times the operations on an album of one kind
+input: the album, the count of pictures, the names of the pictures to look up, the names of the pictures to remove
+output: the timings
+*/
+template <class AlbumType>
+static Timings benchmark(AlbumType& album, size_t picturesCount, const std::vector<std::string>& lookups, const std::vector<std::string>& removals)
+{
+	Timings timings {};
+	long long checksum = 0;
+
+	auto startTime = std::chrono::steady_clock::now();
+	for (size_t picture = 0; picture < picturesCount; ++picture) {
+		std::string name = pictureName(picture);
+		album.addPicture(Picture(static_cast<int>(picture), name, "Pictures/" + name + ".jpg", 0));
+	}
+	timings.build = elapsed(startTime) / 1000;
+
+	startTime = std::chrono::steady_clock::now();
+	for (const std::string& name : lookups) {
+		if (album.doesPictureExists(name)) {
+			checksum += album.getPicture(name).getId();
+			album.tagUserInPicture(1, name);
+		}
+	}
+	timings.lookup = elapsed(startTime) / lookups.size();
+
+	startTime = std::chrono::steady_clock::now();
+	for (int scan = 0; scan < SCANS_COUNT; ++scan) {
+		for (const Picture& picture : album.getPictures()) {
+			checksum += picture.getId() + picture.getTagsCount();
+		}
+	}
+	timings.scan = elapsed(startTime) / SCANS_COUNT / 1000;
+
+	startTime = std::chrono::steady_clock::now();
+	for (const std::string& name : removals) {
+		album.removePicture(name);
+	}
+	timings.remove = elapsed(startTime) / removals.size();
+
+	// so the compiler keeps the loops
+	if (checksum == 42) {
+		std::cout << std::endl;
+	}
+
+	return timings;
+}
+
+static void printTimings(const std::string& title, const Timings& timings)
+{
+	std::cout << "  " << std::left << std::setw(14) << title << std::right << std::fixed
+		<< std::setprecision(1) << std::setw(10) << timings.build << " ms"
+		<< std::setprecision(2) << std::setw(12) << timings.lookup << " us"
+		<< std::setprecision(2) << std::setw(12) << timings.remove << " us"
+		<< std::setprecision(3) << std::setw(10) << timings.scan << " ms" << std::endl;
+}
+
+int main(void)
+{
+	std::mt19937 random(2024);
+
+	for (size_t picturesCount : ALBUM_SIZES) {
+		std::uniform_int_distribution<size_t> anyPicture(0, picturesCount - 1);
+		std::vector<std::string> lookups, removals;
+		for (size_t operation = 0; operation < OPERATIONS_COUNT; ++operation) {
+			lookups.push_back(pictureName(anyPicture(random)));
+		}
+
+		// every removed picture exists
+		std::vector<size_t> pictures(picturesCount);
+		for (size_t picture = 0; picture < picturesCount; ++picture) {
+			pictures[picture] = picture;
+		}
+		std::shuffle(pictures.begin(), pictures.end(), random);
+		for (size_t operation = 0; operation < OPERATIONS_COUNT; ++operation) {
+			removals.push_back(pictureName(pictures[operation]));
+		}
+
+		ListAlbum listAlbum;
+		Album album(1, "Benchmark");
+
+		std::cout << picturesCount << " pictures" << std::endl;
+		std::cout << "  " << std::setw(14) << "" << std::setw(13) << "build" << std::setw(15) << "lookup+tag"
+			<< std::setw(15) << "remove" << std::setw(13) << "full scan" << std::endl;
+		printTimings("std::list", benchmark(listAlbum, picturesCount, lookups, removals));
+		printTimings("PictureStore", benchmark(album, picturesCount, lookups, removals));
+		std::cout << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,281 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <memory_resource>
+#include <new>
+#include <random>
+#include <string>
+#include "DatabaseAccess.h"
+#include "GalleryIndex.h"
+
+/*
+Benchmark of the memory allocations of the gallery - it counts the calls to operator new / delete
+(every allocation of the program goes through them, the memory pools included) while:
+- a GalleryIndex is built over a gallery in memory and cleared, at several gallery sizes, without and with
+  perceptual hashes (the HammingIndex of the perceptual hashes keeps the default allocator). The upstream
+  allocations of the index's pool are counted apart, so what is left are the allocations that didn't
+  go through the pool;
+- a DatabaseAccess opens (loads) a gallery from a DB, and clears it. Only the index nodes come from a pool,
+  the albums and pictures keep the default allocator.
+Build it in Release, the numbers of a Debug build mean little.
+*/
+
+namespace fs = std::filesystem;
+
+static const size_t GALLERY_SIZES[] = { 50000, 100000, 200000 };
+static const int USERS_COUNT = 100;
+static const int PICTURES_PER_ALBUM = 200;
+static const int TAGS_PER_PICTURE = 3;
+// the gallery of the DB
+static const int DB_PICTURES_COUNT = 200000;
+
+static std::atomic<long long> g_allocationsCount { 0 };
+static std::atomic<long long> g_freesCount { 0 };
+
+void* operator new(size_t size)
+{
+	++g_allocationsCount;
+	if (void* memory = std::malloc(size ? size : 1)) {
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	if (memory) {
+		++g_freesCount;
+		std::free(memory);
+	}
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	operator delete(memory);
+}
+
+
+/*
+A memory resource that counts the blocks it gives and takes back - it is set as the default resource,
+so it is the upstream of the pool of the index. The blocks come from operator new, so they are counted
+there too (the pool asks for no more than the default alignment).
+*/
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+	long long allocationsCount { 0 };
+	long long freesCount { 0 };
+
+private:
+	void* do_allocate(size_t bytes, size_t) override
+	{
+		++allocationsCount;
+		return ::operator new(bytes);
+	}
+
+	void do_deallocate(void* memory, size_t, size_t) override
+	{
+		++freesCount;
+		::operator delete(memory);
+	}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+	{
+		return this == &other;
+	}
+};
+
+
+// counts the allocations and the time from its creation
+struct Measure
+{
+	long long allocationsCount { g_allocationsCount };
+	long long freesCount { g_freesCount };
+	std::chrono::steady_clock::time_point startTime { std::chrono::steady_clock::now() };
+
+	long long allocations() const { return g_allocationsCount - allocationsCount; }
+	long long frees() const { return g_freesCount - freesCount; }
+	double milliseconds() const { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count(); }
+};
+
+
+/*
+This function makes a gallery in memory - every picture has a content hash, a perceptual hash (optional)
+and tags of several users, and half of the pictures have a capture time and a camera model
+input: the count of pictures, whether the pictures have perceptual hashes, the albums and users (output parameters)
+output: none
+*/
+static void makeGallery(size_t picturesCount, bool perceptualHashes, std::list<Album>& albums, std::list<User>& users)
+{
+	std::mt19937_64 random(2024);
+	static const std::string cameras[] = { "Canon EOS 80D", "NIKON D750", "iPhone 12 Pro", "Pixel 6" };
+
+	for (int user = 0; user < USERS_COUNT; ++user) {
+		users.emplace_back(user + 1, "User " + std::to_string(user));
+	}
+
+	for (size_t picture = 0; picture < picturesCount; ++picture) {
+		if (picture % PICTURES_PER_ALBUM == 0) {
+			int albumId = static_cast<int>(albums.size()) + 1;
+			albums.emplace_back(albumId % USERS_COUNT + 1, "Album " + std::to_string(albumId), 1600000000 + albumId);
+			albums.back().setId(albumId);
+			albums.back().reservePictures(PICTURES_PER_ALBUM);
+		}
+
+		std::string name = "Picture " + std::to_string(picture);
+		Picture created(static_cast<int>(picture) + 1, name, "C:\\Pictures\\" + albums.back().getName() + "\\" + name + ".jpg", 1600000000 + picture);
+		created.setContentHash(random() | 1);
+		uint64_t perceptualHash = random() | 1;
+		if (perceptualHashes) {
+			created.setPerceptualHash(perceptualHash);
+		}
+		if (picture % 2 == 0) {
+			ExifMetadata metadata;
+			metadata.captureTime = 1500000000 + picture;
+			metadata.cameraModel = cameras[picture % 4];
+			created.setMetadata(metadata);
+		}
+		for (int tag = 0; tag < TAGS_PER_PICTURE; ++tag) {
+			created.tagUser(static_cast<int>(random() % USERS_COUNT) + 1);
+		}
+		albums.back().addPicture(std::move(created));
+	}
+}
+
+/*
+This function builds and clears an index over galleries of several sizes
+input: whether the pictures have perceptual hashes
+output: none
+*/
+static void benchmarkIndex(bool perceptualHashes)
+{
+	std::cout << "GalleryIndex (" << TAGS_PER_PICTURE << " tags per picture, " << (perceptualHashes ? "with" : "without") << " perceptual hashes)" << std::endl;
+	std::cout << std::setw(10) << "pictures" << std::setw(14) << "allocations" << std::setw(12) << "pool" << std::setw(14) << "outside"
+		<< std::setw(11) << "build" << std::setw(10) << "frees" << std::setw(12) << "pool" << std::setw(11) << "clear" << std::endl;
+
+	for (size_t picturesCount : GALLERY_SIZES) {
+		std::list<Album> albums;
+		std::list<User> users;
+		makeGallery(picturesCount, perceptualHashes, albums, users);
+
+		CountingResource poolMemory;
+		std::pmr::memory_resource* defaultResource = std::pmr::set_default_resource(&poolMemory);
+		{
+			GalleryIndex index(albums, users);
+
+			Measure build;
+			long long poolAllocations = poolMemory.allocationsCount;
+			for (auto user = users.begin(); user != users.end(); ++user) {
+				index.addUser(user);
+			}
+			for (auto album = albums.begin(); album != albums.end(); ++album) {
+				index.addAlbum(album);
+				for (const Picture& picture : album->getPictures()) {
+					index.addPicture(album->getId(), picture);
+				}
+			}
+			double buildTime = build.milliseconds();
+			long long buildAllocations = build.allocations();
+			poolAllocations = poolMemory.allocationsCount - poolAllocations;
+
+			Measure clear;
+			long long poolFrees = poolMemory.freesCount;
+			index.clear();
+			double clearTime = clear.milliseconds();
+			poolFrees = poolMemory.freesCount - poolFrees;
+
+			std::cout << std::setw(10) << picturesCount << std::setw(14) << buildAllocations << std::setw(12) << poolAllocations
+				<< std::setw(14) << buildAllocations - poolAllocations << std::fixed << std::setprecision(1) << std::setw(8) << buildTime << " ms"
+				<< std::setw(10) << clear.frees() << std::setw(12) << poolFrees << std::setw(8) << clearTime << " ms" << std::endl;
+		}
+		std::pmr::set_default_resource(defaultResource);
+	}
+	std::cout << std::endl;
+}
+
+/*
+This function fills the tables of a new DB with a gallery, by set based inserts
+input: the data access (opened on an empty DB)
+output: true if the gallery was made, false otherwise
+*/
+static bool makeDatabase(DatabaseAccess& dataAccess)
+{
+	const std::string picturesCount = std::to_string(DB_PICTURES_COUNT);
+	const std::string albumsCount = std::to_string(DB_PICTURES_COUNT / PICTURES_PER_ALBUM);
+
+	return dataAccess.runSqlCommand("BEGIN;") &&
+		dataAccess.runSqlCommand("WITH RECURSIVE N(I) AS (SELECT 1 UNION ALL SELECT I + 1 FROM N WHERE I < " + std::to_string(USERS_COUNT) + ") "
+			"INSERT INTO USERS (ID, NAME) SELECT I, 'User ' || I FROM N;") &&
+		dataAccess.runSqlCommand("WITH RECURSIVE N(I) AS (SELECT 1 UNION ALL SELECT I + 1 FROM N WHERE I < " + albumsCount + ") "
+			"INSERT INTO ALBUMS (ID, NAME, CREATION_DATE, USER_ID) SELECT I, 'Album ' || I, 1600000000 + I, I % " + std::to_string(USERS_COUNT) + " + 1 FROM N;") &&
+		dataAccess.runSqlCommand("WITH RECURSIVE N(I) AS (SELECT 1 UNION ALL SELECT I + 1 FROM N WHERE I < " + picturesCount + ") "
+			"INSERT INTO PICTURES (ID, NAME, LOCATION, CREATION_DATE, ALBUM_ID, CONTENT_HASH) "
+			"SELECT I, 'Picture ' || I, 'C:\\Pictures\\Album ' || ((I - 1) / " + std::to_string(PICTURES_PER_ALBUM) + " + 1) || '\\Picture ' || I || '.jpg', "
+			"1600000000 + I, (I - 1) / " + std::to_string(PICTURES_PER_ALBUM) + " + 1, I * 7919 FROM N;") &&
+		dataAccess.runSqlCommand("WITH RECURSIVE N(I) AS (SELECT 0 UNION ALL SELECT I + 1 FROM N WHERE I < " + std::to_string(DB_PICTURES_COUNT * TAGS_PER_PICTURE - 1) + ") "
+			"INSERT INTO TAGS (PICTURE_ID, USER_ID) SELECT I / " + std::to_string(TAGS_PER_PICTURE) + " + 1, (I * 37) % " + std::to_string(USERS_COUNT) + " + 1 FROM N;") &&
+		dataAccess.runSqlCommand("COMMIT;");
+}
+
+/*
+This function opens a gallery from a DB and clears it
+input: none
+output: true if the DB was made and opened, false otherwise
+*/
+static bool benchmarkDatabaseAccess()
+{
+	fs::path folder = fs::temp_directory_path() / "GalleryAllocationBenchmark";
+	fs::path startFolder = fs::current_path();
+	fs::remove_all(folder);
+	fs::create_directories(folder);
+	fs::current_path(folder);
+
+	bool success = false;
+	{
+		DatabaseAccess dataAccess;
+		success = dataAccess.open() && makeDatabase(dataAccess);
+		dataAccess.close();
+	}
+
+	if (success)
+	{
+		DatabaseAccess dataAccess;
+
+		Measure open;
+		success = dataAccess.open();
+		double openTime = open.milliseconds();
+		long long openAllocations = open.allocations();
+
+		Measure clear;
+		dataAccess.clear();
+		double clearTime = clear.milliseconds();
+
+		std::cout << "DatabaseAccess (" << DB_PICTURES_COUNT << " pictures, " << DB_PICTURES_COUNT * TAGS_PER_PICTURE << " tags)" << std::endl;
+		std::cout << "  open():  " << openAllocations << " allocations in " << std::fixed << std::setprecision(1) << openTime << " ms" << std::endl;
+		std::cout << "  clear(): " << clear.frees() << " frees in " << clearTime << " ms" << std::endl;
+
+		dataAccess.close();
+	}
+
+	fs::current_path(startFolder);
+	fs::remove_all(folder);
+
+	return success;
+}
+
+int main(void)
+{
+	benchmarkIndex(false);
+	benchmarkIndex(true);
+
+	if (!benchmarkDatabaseAccess()) {
+		std::cout << "Failed to make the DB of the benchmark" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
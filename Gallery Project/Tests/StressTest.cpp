@@ -0,0 +1,270 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ConcurrentAccess.h"
+#include "DatabaseAccess.h"
+#include "MemoryAccess.h"
+
+/*
+Stress test of ConcurrentAccess: writer threads add pictures, tag and untag users in parallel
+while reader threads query the gallery, then the same work is run serially on a fresh gallery
+and both must end in the same state. The work of a writer thread touches only its own pictures
+and users, so its changes commute with those of the other threads, and any difference between
+the two runs is a lost or torn change.
+Every run starts from an empty gallery in a folder of its own (under the temp folder).
+*/
+
+namespace fs = std::filesystem;
+
+static const int WRITER_THREADS = 8;
+static const int READER_THREADS = 4;
+static const int ALBUMS_COUNT = 4;
+static const int PICTURES_PER_THREAD = 200;
+static const int USERS_PER_THREAD = 4;
+static const int FIRST_USER_ID = 1000;
+static const int FIRST_PICTURE_ID = 100000;
+
+
+/*
+A DB data access that loads the albums lazily into a cache smaller than the gallery and answers the
+queries from the DB, so the readers load and evict albums and wait for each other on the DB while
+the writers change the gallery
+*/
+class LazyDatabaseAccess : public DatabaseAccess
+{
+public:
+	LazyDatabaseAccess()
+	{
+		setLazyLoading(ALBUMS_COUNT / 2);
+	}
+};
+
+
+static std::string albumName(int album)
+{
+	return "Stress album " + std::to_string(album);
+}
+
+/*
+This function creates the users and albums the writer threads work on
+input: the data access
+output: none
+*/
+static void createGallery(IDataAccess& dataAccess)
+{
+	for (int user = 0; user < WRITER_THREADS * USERS_PER_THREAD; ++user) {
+		User created(FIRST_USER_ID + user, "Stress user " + std::to_string(user));
+		dataAccess.createUser(created);
+	}
+	for (int album = 0; album < ALBUMS_COUNT; ++album) {
+		dataAccess.createAlbum(Album(FIRST_USER_ID, albumName(album)));
+	}
+}
+
+/*
+This function runs the changes of one writer thread - it adds its pictures (spread over the shared
+albums), tags its users in them, and untags some of the tags again
+input: the data access, the thread number
+output: none
+*/
+static void runWriter(IDataAccess& dataAccess, int thread)
+{
+	for (int i = 0; i < PICTURES_PER_THREAD; ++i) {
+		int pictureId = FIRST_PICTURE_ID + thread * PICTURES_PER_THREAD + i;
+		std::string album = albumName(i % ALBUMS_COUNT);
+		std::string name = "Picture " + std::to_string(pictureId);
+
+		dataAccess.addPictureToAlbumByName(album, FIRST_USER_ID, Picture(pictureId, name, "stress/" + name + ".jpg", 0));
+
+		for (int user = 0; user <= i % USERS_PER_THREAD; ++user) {
+			dataAccess.tagUserInPicture(album, FIRST_USER_ID, name, FIRST_USER_ID + thread * USERS_PER_THREAD + user);
+		}
+		if (i % 3 == 0) {
+			dataAccess.untagUserInPicture(album, FIRST_USER_ID, name, FIRST_USER_ID + thread * USERS_PER_THREAD);
+		}
+		if (i % 50 == 49) {
+			dataAccess.flush();
+		}
+	}
+}
+
+/*
+This function runs queries until it is told to stop, and checks that what it reads is consistent
+input: the data access, the stop flag, the count of inconsistent reads (output parameter)
+output: none
+*/
+static void runReader(IDataAccess& dataAccess, const std::atomic<bool>& stop, std::atomic<int>& errorsCount)
+{
+	while (!stop) {
+		for (int album = 0; album < ALBUMS_COUNT; ++album) {
+			const Album opened = dataAccess.openAlbum(albumName(album), FIRST_USER_ID);
+			for (const Picture& picture : opened.getPictures()) {
+				if (picture.getTagsCount() != static_cast<int>(picture.getUserTags().size()) || opened.getPicture(picture.getName()).getId() != picture.getId()) {
+					++errorsCount;
+				}
+			}
+		}
+
+		dataAccess.getPicturesLargerThan(albumName(0), FIRST_USER_ID, 0);
+		dataAccess.getTopTaggedUsers(10);
+		dataAccess.getTopTaggedPictures(10);
+		dataAccess.countTagsOfUser(User(FIRST_USER_ID, ""));
+		dataAccess.getSnapshot();
+	}
+}
+
+/*
+This function writes the state of the gallery as text, in an order that doesn't depend on the order of the changes
+input: the data access
+output: the state
+*/
+static std::string dumpGallery(IDataAccess& dataAccess)
+{
+	std::ostringstream dump;
+
+	for (int user = 0; user < WRITER_THREADS * USERS_PER_THREAD; ++user) {
+		User found = dataAccess.getUser(FIRST_USER_ID + user);
+		dump << "user " << found.getId() << " " << found.getName() << " tags " << dataAccess.countTagsOfUser(found)
+			<< " albums " << dataAccess.countAlbumsTaggedOfUser(found) << "\n";
+	}
+
+	for (int album = 0; album < ALBUMS_COUNT; ++album) {
+		std::vector<Picture> pictures = dataAccess.openAlbum(albumName(album), FIRST_USER_ID).getPictures();
+		std::sort(pictures.begin(), pictures.end(), [](const Picture& first, const Picture& second) {
+			return first.getId() < second.getId();
+		});
+
+		dump << "album " << albumName(album) << " " << pictures.size() << " pictures\n";
+		for (const Picture& picture : pictures) {
+			std::vector<int> tags(picture.getUserTags().begin(), picture.getUserTags().end());
+			std::sort(tags.begin(), tags.end());
+			dump << "  " << picture.getId() << " " << picture.getName() << " " << picture.getPath() << " tags";
+			for (int tag : tags) {
+				dump << " " << tag;
+			}
+			dump << "\n";
+		}
+	}
+
+	// the rankings break ties by id, so they are the same whatever the order of the changes
+	for (const User& user : dataAccess.getTopTaggedUsers(10)) {
+		dump << "top user " << user.getId() << "\n";
+	}
+	for (const Picture& picture : dataAccess.getTopTaggedPictures(10)) {
+		dump << "top picture " << picture.getId() << "\n";
+	}
+
+	return dump.str();
+}
+
+/*
+This function runs the work of all the writer threads on a fresh gallery, in parallel or one after the other
+input: the kind of data access, true to run in parallel (with the reader threads), the folder of the gallery,
+the count of inconsistent reads (output parameter)
+output: the state of the gallery at the end, and after it was closed and opened again
+*/
+template <class DataAccess>
+static std::pair<std::string, std::string> runGallery(bool parallel, const fs::path& folder, std::atomic<int>& errorsCount)
+{
+	fs::remove_all(folder);
+	fs::create_directories(folder);
+	fs::current_path(folder);
+
+	std::string state, reopenedState;
+	{
+		DataAccess wrapped;
+		ConcurrentAccess dataAccess(wrapped);
+		dataAccess.open();
+		createGallery(dataAccess);
+
+		if (parallel) {
+			std::atomic<bool> stop { false };
+			std::vector<std::thread> readers, writers;
+			for (int thread = 0; thread < READER_THREADS; ++thread) {
+				readers.emplace_back(runReader, std::ref(dataAccess), std::cref(stop), std::ref(errorsCount));
+			}
+			for (int thread = 0; thread < WRITER_THREADS; ++thread) {
+				writers.emplace_back(runWriter, std::ref(dataAccess), thread);
+			}
+			for (std::thread& writer : writers) {
+				writer.join();
+			}
+			stop = true;
+			for (std::thread& reader : readers) {
+				reader.join();
+			}
+		}
+		else {
+			for (int thread = 0; thread < WRITER_THREADS; ++thread) {
+				runWriter(dataAccess, thread);
+			}
+		}
+
+		state = dumpGallery(dataAccess);
+		dataAccess.close();
+	}
+	{
+		DataAccess reopened;
+		reopened.open();
+		reopenedState = dumpGallery(reopened);
+		reopened.close();
+	}
+
+	return { state, reopenedState };
+}
+
+/*
+This function runs the stress test on one kind of data access
+input: the kind of data access (its name), the folder of the test
+output: true if the parallel run ended in the same state as the serial run, false otherwise
+*/
+template <class DataAccess>
+static bool testDataAccess(const std::string& name, const fs::path& folder)
+{
+	std::atomic<int> errorsCount { 0 };
+
+	auto startTime = std::chrono::steady_clock::now();
+	auto serial = runGallery<DataAccess>(false, folder / (name + "Serial"), errorsCount);
+	auto serialEndTime = std::chrono::steady_clock::now();
+	auto parallel = runGallery<DataAccess>(true, folder / (name + "Parallel"), errorsCount);
+	std::chrono::duration<double> serialTime = serialEndTime - startTime;
+	std::chrono::duration<double> parallelTime = std::chrono::steady_clock::now() - serialEndTime;
+
+	bool passed = serial.first == parallel.first && serial.first == serial.second && parallel.first == parallel.second && 0 == errorsCount;
+	std::cout << name << ": " << (passed ? "PASSED" : "FAILED") << " - " << WRITER_THREADS << " writers and " << READER_THREADS
+		<< " readers in " << parallelTime.count() << " sec, serially in " << serialTime.count() << " sec" << std::endl;
+	if (serial.first != parallel.first) {
+		std::cout << "   the parallel run ended in another state than the serial run" << std::endl;
+	}
+	if (serial.first != serial.second || parallel.first != parallel.second) {
+		std::cout << "   the gallery changed when it was opened again" << std::endl;
+	}
+	if (errorsCount != 0) {
+		std::cout << "   " << errorsCount << " inconsistent reads" << std::endl;
+	}
+
+	return passed;
+}
+
+int main(void)
+{
+	fs::path folder = fs::temp_directory_path() / "GalleryStressTest";
+	fs::path startFolder = fs::current_path();
+
+	bool passed = testDataAccess<MemoryAccess>("MemoryAccess", folder);
+	passed = testDataAccess<DatabaseAccess>("DatabaseAccess", folder) && passed;
+	passed = testDataAccess<LazyDatabaseAccess>("LazyDatabaseAccess", folder) && passed;
+
+	fs::current_path(startFolder);
+	fs::remove_all(folder);
+
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,92 @@
+#include <algorithm>
+#include "ThreadPool.h"
+
+
+ThreadPool::ThreadPool(unsigned int threadsCount)
+{
+	// hardware_concurrency() is 0 when it isn't known
+	threadsCount = std::max(threadsCount, 1u);
+
+	m_threads.reserve(threadsCount);
+	for (unsigned int i = 0; i < threadsCount; ++i) {
+		m_threads.emplace_back(&ThreadPool::work, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_taskReady.notify_all();
+
+	for (std::thread& thread : m_threads) {
+		thread.join();
+	}
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.push(std::move(task));
+		++m_unfinishedTasks;
+	}
+	m_taskReady.notify_one();
+}
+
+/*
+This function waits until every task that was submitted is done (the tasks they submitted too)
+input: none
+output: none (the first exception a task threw is thrown again here)
+*/
+void ThreadPool::wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_tasksDone.wait(lock, [this]() { return 0 == m_unfinishedTasks; });
+
+	if (m_exception) {
+		std::exception_ptr exception = m_exception;
+		m_exception = nullptr;
+		std::rethrow_exception(exception);
+	}
+}
+
+size_t ThreadPool::size() const
+{
+	return m_threads.size();
+}
+
+// the loop of every worker thread - runs tasks until the pool is destroyed
+void ThreadPool::work()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true) {
+		m_taskReady.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+		if (m_tasks.empty()) {
+			return;
+		}
+
+		std::function<void()> task = std::move(m_tasks.front());
+		m_tasks.pop();
+		lock.unlock();
+
+		std::exception_ptr exception;
+		try {
+			task();
+		}
+		catch (...) {
+			exception = std::current_exception();
+		}
+
+		lock.lock();
+		if (exception && !m_exception) {
+			m_exception = exception;
+		}
+		if (0 == --m_unfinishedTasks) {
+			m_tasksDone.notify_all();
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/*
+A fixed set of worker threads that run the tasks submitted to it, in the order they were submitted.
+A task may submit more tasks, wait() returns when all of them are done.
+*/
+class ThreadPool
+{
+public:
+	explicit ThreadPool(unsigned int threadsCount = std::thread::hardware_concurrency());
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	void submit(std::function<void()> task);
+	void wait();
+	size_t size() const;
+
+private:
+	std::vector<std::thread> m_threads;
+	std::queue<std::function<void()>> m_tasks;
+	std::mutex m_mutex;
+	std::condition_variable m_taskReady;
+	std::condition_variable m_tasksDone;
+	// tasks that were submitted and didn't finish yet
+	size_t m_unfinishedTasks { 0 };
+	bool m_stopping { false };
+	// the first exception a task threw since the last wait()
+	std::exception_ptr m_exception;
+
+	void work();
+};
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include "ContentHash.h"
+#include "Image.h"
+#include "ThumbnailCache.h"
+
+namespace fs = std::filesystem;
+
+static const char* const THUMBNAIL_EXTENSION = ".bmp";
+// the first hex digits of the hash name a subfolder, so no folder holds too many files
+static const size_t SUBFOLDER_NAME_LENGTH = 2;
+
+
+ThumbnailCache::ThumbnailCache(const std::string& folder) :
+	m_folder(folder), m_pool(std::max(std::thread::hardware_concurrency() / 2, 1u))
+{
+	// Left empty
+}
+
+/*
+This function builds the path of the thumbnail of a content (whether it was made or not)
+input: the content hash of the picture
+output: the thumbnail path
+*/
+std::string ThumbnailCache::getThumbnailPath(uint64_t contentHash) const
+{
+	std::string name = ContentHash::toString(contentHash);
+	return (fs::path(m_folder) / name.substr(0, SUBFOLDER_NAME_LENGTH) / (name + THUMBNAIL_EXTENSION)).string();
+}
+
+/*
+This function checks if the thumbnail of a picture is in the cache
+input: the picture
+output: true if it is, false otherwise (pictures that weren't hashed aren't looked up)
+*/
+bool ThumbnailCache::hasThumbnail(const Picture& picture) const
+{
+	std::error_code error;
+	return 0 != picture.getContentHash() && fs::exists(getThumbnailPath(picture.getContentHash()), error);
+}
+
+/*
+This function makes the thumbnail of a picture, unless it's in the cache already
+input: the picture
+output: true if the thumbnail is in the cache, false if the picture can't be read or decoded
+*/
+bool ThumbnailCache::makeThumbnail(const Picture& picture) const
+{
+	// pictures that were added before the pictures were hashed are hashed here
+	uint64_t contentHash = picture.getContentHash();
+	if (0 == contentHash && !ContentHash::hashFile(picture.getPath(), contentHash)) {
+		return false;
+	}
+
+	std::error_code error;
+	fs::path thumbnailPath = getThumbnailPath(contentHash);
+	if (fs::exists(thumbnailPath, error)) {
+		return true;
+	}
+
+	Image image;
+	if (!Image::isDecodable(picture.getPath()) || !Image::load(picture.getPath(), image)) {
+		return false;
+	}
+
+	// a picture smaller than a thumbnail is kept as it is
+	int width = image.getWidth(), height = image.getHeight();
+	if (std::max(width, height) > THUMBNAIL_SIZE) {
+		int longSide = std::max(width, height);
+		width = std::max(static_cast<int>(static_cast<int64_t>(width) * THUMBNAIL_SIZE / longSide), 1);
+		height = std::max(static_cast<int>(static_cast<int64_t>(height) * THUMBNAIL_SIZE / longSide), 1);
+	}
+	Image thumbnail = image.scaledDown(width, height);
+
+	fs::create_directories(thumbnailPath.parent_path(), error);
+
+	// written under a name of its own and then renamed, so a thumbnail in the cache is always whole -
+	// even if the program stops in the middle, or two pictures of the same content are done at once
+	static std::atomic<unsigned int> temporaryFilesCount { 0 };
+	fs::path temporaryPath = thumbnailPath;
+	temporaryPath += "." + std::to_string(++temporaryFilesCount) + ".tmp";
+
+	if (!thumbnail.saveBmp(temporaryPath.string())) {
+		fs::remove(temporaryPath, error);
+		return false;
+	}
+	fs::rename(temporaryPath, thumbnailPath, error);
+	if (error) {
+		fs::remove(temporaryPath, error);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+This function queues the pictures that have no thumbnail yet, their thumbnails are made on the thread pool
+input: the pictures
+output: the number of pictures that were queued
+*/
+size_t ThumbnailCache::makeThumbnailsInBackground(const std::vector<Picture>& pictures)
+{
+	size_t queuedCount = 0;
+
+	for (const Picture& picture : pictures) {
+		if (hasThumbnail(picture) || !Image::isDecodable(picture.getPath())) {
+			continue;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_pendingMutex);
+			if (!m_pendingPaths.insert(picture.getPath()).second) {
+				continue;
+			}
+		}
+
+		// the task has its own copy, the picture may be removed from its album in the meantime
+		m_pool.submit([this, picture]() {
+			makeThumbnail(picture);
+
+			std::lock_guard<std::mutex> lock(m_pendingMutex);
+			m_pendingPaths.erase(picture.getPath());
+		});
+		++queuedCount;
+	}
+
+	return queuedCount;
+}
+
+size_t ThumbnailCache::getPendingCount()
+{
+	std::lock_guard<std::mutex> lock(m_pendingMutex);
+	return m_pendingPaths.size();
+}
+
+/*
+This function waits until every thumbnail that was queued is made
+input: none
+output: none
+*/
+void ThumbnailCache::wait()
+{
+	m_pool.wait();
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "Picture.h"
+#include "ThreadPool.h"
+
+/*
+A folder of picture thumbnails. A thumbnail is the picture shrunk to fit in THUMBNAIL_SIZE x THUMBNAIL_SIZE
+(keeping its proportions) and saved as a BMP file named by the content hash of the picture - pictures with
+the same content share a thumbnail, and a picture that changed on disk gets a new one.
+Thumbnails are made in the background on a thread pool of the cache, only for the pictures Image decodes.
+*/
+class ThumbnailCache
+{
+public:
+	static const int THUMBNAIL_SIZE = 160;
+
+	explicit ThumbnailCache(const std::string& folder);
+
+	std::string getThumbnailPath(uint64_t contentHash) const;
+	bool hasThumbnail(const Picture& picture) const;
+	bool makeThumbnail(const Picture& picture) const;
+	size_t makeThumbnailsInBackground(const std::vector<Picture>& pictures);
+	size_t getPendingCount();
+	void wait();
+
+private:
+	std::string m_folder;
+	std::mutex m_pendingMutex;
+	// the paths of the pictures that are queued or being made, a picture isn't queued twice
+	std::unordered_set<std::string> m_pendingPaths;
+	// last, so its threads are done before the members they use are destroyed
+	ThreadPool m_pool;
+};
@@ -0,0 +1,64 @@
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include "TimeFormat.h"
+
+
+int64_t currentTime()
+{
+	return static_cast<int64_t>(time(nullptr));
+}
+
+/*
+This function formats a time as local time
+input: the time (seconds since the epoch)
+output: the formatted time
+*/
+std::string formatTime(int64_t time)
+{
+	time_t value = static_cast<time_t>(time);
+	std::tm localTime = {};
+
+#ifdef _WIN32
+	localtime_s(&localTime, &value);
+#else
+	localtime_r(&value, &localTime);
+#endif
+
+	std::ostringstream oss;
+	oss << std::put_time(&localTime, TIME_FORMAT);
+	return oss.str();
+}
+
+/*
+This function parses a local time in the time format (the time of day may be left out)
+input: the string, the parsed time (output parameter)
+output: true if the string is a valid time, false otherwise
+*/
+bool parseTime(const std::string& str, int64_t& time)
+{
+	std::tm localTime = {};
+	std::istringstream iss(str);
+
+	iss >> std::get_time(&localTime, "%d/%m/%Y");
+	if (iss.fail()) {
+		return false;
+	}
+
+	if (!(iss >> std::ws).eof()) {
+		iss >> std::get_time(&localTime, "%H:%M:%S");
+		if (iss.fail() || !(iss >> std::ws).eof()) {
+			return false;
+		}
+	}
+
+	// let mktime find out whether daylight saving time was in effect
+	localTime.tm_isdst = -1;
+	time_t value = mktime(&localTime);
+	if (value == static_cast<time_t>(-1)) {
+		return false;
+	}
+
+	time = static_cast<int64_t>(value);
+	return true;
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/*
+Creation times are kept as seconds since the epoch, and are shown (and typed in)
+as local time in the "dd/mm/yyyy hh:mm:ss" format.
+*/
+const char* const TIME_FORMAT = "%d/%m/%Y %H:%M:%S";
+
+int64_t currentTime();
+std::string formatTime(int64_t time);
+bool parseTime(const std::string& str, int64_t& time);